@@ -11,6 +11,24 @@
 #include <time.h>
 #include <sys/time.h>
 #include "../include/cardid.h"
+#include "../include/cardid_archive.h"
+#include "../include/cardid_follow.h"
+#include "../include/cardid_gen.h"
+#include "../include/cardid_metrics.h"
+#include "../include/cardid_record.h"
+#include "../include/cardid_results.h"
+#include "../include/cardid_scan.h"
+#include "../include/cardid_token.h"
+#include "../include/cardid_velocity.h"
+#ifndef _WIN32
+#include <pthread.h>
+#endif
+#ifdef CARDID_HAVE_ZLIB
+#include <zlib.h>
+#endif
+#ifdef CARDID_HAVE_ZSTD
+#include <zstd.h>
+#endif
 
 #define BENCHMARK_ITERATIONS 1000000
 #define BENCHMARK_WARMUP 10000
@@ -161,6 +179,39 @@ static void benchmark_analysis() {
     printf("\n");
 }
 
+/**
+ * @brief Batch analysis (arena digits, one wipe per batch) vs per-call analysis
+ */
+static void benchmark_batch_analysis() {
+    printf("=== Batch Analysis Benchmark ===\n");
+
+    enum { BATCH = 1024 };
+    static const char* inputs[BATCH];
+    static cardid_result results[BATCH];
+    const int rounds = BENCHMARK_ITERATIONS / BATCH;
+    for (int i = 0; i < BATCH; i++) {
+        inputs[i] = benchmark_cards[i % 8];
+    }
+
+    long long start = get_time_us();
+    for (int r = 0; r < rounds; r++) {
+        for (int i = 0; i < BATCH; i++) {
+            cardid_analyze(inputs[i], &results[i], NULL);
+        }
+    }
+    double single = (double)(get_time_us() - start) * 1000.0 / ((double)rounds * BATCH);
+
+    start = get_time_us();
+    for (int r = 0; r < rounds; r++) {
+        cardid_analyze_batch(inputs, BATCH, results);
+    }
+    double batch = (double)(get_time_us() - start) * 1000.0 / ((double)rounds * BATCH);
+
+    printf("Per-call analysis: %.1f ns per PAN\n", single);
+    printf("Batch analysis:    %.1f ns per PAN\n", batch);
+    printf("\n");
+}
+
 /**
  * @brief Benchmark different card types
  */
@@ -237,6 +288,609 @@ static void benchmark_memory() {
     }
 }
 
+/**
+ * @brief Cost of metrics collection on the analysis hot path
+ */
+static void benchmark_metrics_overhead() {
+    printf("=== Metrics Overhead Benchmark ===\n");
+
+    if (!cardid_metrics_available()) {
+        printf("Metrics compiled out (CARDID_ENABLE_METRICS=OFF)\n\n");
+        return;
+    }
+
+    const char* test_input = "4111-1111-1111-1111";
+    cardid_result result;
+    double avg[2];
+
+    for (int enabled = 0; enabled < 2; enabled++) {
+        cardid_metrics_enable(enabled != 0);
+        for (int i = 0; i < BENCHMARK_WARMUP; i++) {
+            cardid_analyze(test_input, &result, NULL);
+        }
+        long long start = get_time_us();
+        for (int i = 0; i < BENCHMARK_ITERATIONS; i++) {
+            cardid_analyze(test_input, &result, NULL);
+        }
+        avg[enabled] = (double)(get_time_us() - start) * 1000.0 / BENCHMARK_ITERATIONS;
+    }
+    cardid_metrics_enable(false);
+
+    printf("Metrics disabled: %.1f ns per analysis\n", avg[0]);
+    printf("Metrics enabled:  %.1f ns per analysis\n", avg[1]);
+    printf("Overhead: %.1f ns per analysis\n", avg[1] - avg[0]);
+    printf("\n");
+}
+
+// cardid_analyze built from the same source with and without probe sites
+// (cardid_probed.c, cardid_noprobe.c)
+void cardid_probed_analyze(const char* input, cardid_result* out,
+                           cardid_extract_result* extract_meta);
+void cardid_noprobe_analyze(const char* input, cardid_result* out,
+                            cardid_extract_result* extract_meta);
+bool cardid_probed_probes_available(void);
+
+/**
+ * @brief Analysis cost with USDT probes compiled in but not attached
+ *
+ * Times two copies of the analysis path built alike in this binary, one with
+ * probe sites and one without, alternating runs so drift hits both alike.
+ * Build with sys/sdt.h installed (systemtap-sdt-dev) for a meaningful delta.
+ */
+static void benchmark_probe_overhead() {
+    printf("=== USDT Probe Overhead Benchmark ===\n");
+    printf("Probes compiled in: %s\n", cardid_probed_probes_available() ? "Yes" : "No");
+
+    typedef void (*analyze_fn)(const char*, cardid_result*, cardid_extract_result*);
+    const analyze_fn paths[2] = {cardid_noprobe_analyze, cardid_probed_analyze};
+    const char* test_input = "4111-1111-1111-1111";
+    cardid_result result;
+    double best[2] = {0.0, 0.0};
+
+    // Best of five runs each to keep scheduler noise out of a sub-nanosecond delta
+    for (int run = 0; run < 5; run++) {
+        for (int p = 0; p < 2; p++) {
+            for (int i = 0; i < BENCHMARK_WARMUP; i++) {
+                paths[p](test_input, &result, NULL);
+            }
+            long long start = get_time_us();
+            for (int i = 0; i < BENCHMARK_ITERATIONS; i++) {
+                paths[p](test_input, &result, NULL);
+            }
+            double avg = (double)(get_time_us() - start) * 1000.0 / BENCHMARK_ITERATIONS;
+            if (run == 0 || avg < best[p]) best[p] = avg;
+        }
+    }
+
+    printf("Without probes: %.1f ns per analysis (best of 5)\n", best[0]);
+    printf("With probes:    %.1f ns per analysis (best of 5)\n", best[1]);
+    printf("Overhead: %+.1f ns per analysis (%+.1f%%)\n", best[1] - best[0],
+           (best[1] - best[0]) * 100.0 / best[0]);
+    printf("\n");
+}
+
+/**
+ * @brief Validation plus tokenization: per-record loop vs multi-lane batch
+ */
+static void benchmark_tokenize() {
+    printf("=== Tokenization Benchmark ===\n");
+
+    enum { BATCH = 1024 };
+    static const char* inputs[BATCH];
+    static cardid_result results[BATCH];
+    static uint64_t tokens[BATCH];
+    const cardid_token_key key = {0x0706050403020100ULL, 0x0f0e0d0c0b0a0908ULL};
+    const int rounds = BENCHMARK_ITERATIONS / BATCH;
+    char digits[32];
+
+    for (int i = 0; i < BATCH; i++) {
+        inputs[i] = benchmark_cards[i % 8];
+    }
+
+    long long start = get_time_us();
+    for (int r = 0; r < rounds; r++) {
+        for (int i = 0; i < BATCH; i++) {
+            cardid_extract_result meta;
+            cardid_analyze(inputs[i], &results[i], &meta);
+            cardid_extract_digits(inputs[i], digits, sizeof(digits));
+            tokens[i] = results[i].luhn_valid ? cardid_token64(&key, digits, meta.digit_count) : 0;
+        }
+    }
+    double scalar = (double)(get_time_us() - start) * 1000.0 / ((double)rounds * BATCH);
+
+    start = get_time_us();
+    for (int r = 0; r < rounds; r++) {
+        cardid_analyze_tokenize_batch(&key, inputs, BATCH, results, tokens);
+    }
+    double batch = (double)(get_time_us() - start) * 1000.0 / ((double)rounds * BATCH);
+
+    printf("Per-record analyze + token: %.1f ns per PAN\n", scalar);
+    printf("Batch analyze + token:      %.1f ns per PAN\n", batch);
+    printf("Tokens per second (batch): %.0f\n", 1e9 / batch);
+    printf("\n");
+}
+
+static void count_scan_match(const cardid_scan_match* m, void* ctx) {
+    (void)m;
+    ++*(unsigned long long*)ctx;
+}
+
+// Log-like lines, one in 64 followed by a "card=" line carrying a generated PAN.
+// varied gives every line its own timestamp, ids and sizes, so the text
+// compresses like a real log instead of a single repeated line. Returns the
+// bytes written to text (at most size).
+static size_t fill_log_corpus(char* text, size_t size, bool varied, unsigned long long* planted) {
+    cardid_gen_config cfg;
+    memset(&cfg, 0, sizeof(cfg));
+    cfg.seed = 11;
+    cfg.separator_rate = 0.3;
+    cardid_gen gen;
+    cardid_gen_init(&gen, &cfg);
+
+    static const char* filler =
+        "2024-05-01T12:00:00Z INFO request id=8f3a21 user=alice path=/api/v1/orders status=200\n";
+    size_t flen = strlen(filler), pos = 0;
+    unsigned x = 11;
+    *planted = 0;
+    for (int line = 0; pos + 2 * flen + CARDID_GEN_MAX_TEXT + 8 < size; ++line) {
+        if (varied) {
+            x = x * 1103515245u + 12345u;
+            pos += (size_t)sprintf(text + pos,
+                                   "2024-05-01T12:%02d:%02d.%03dZ %s request id=%08x user=u%05u"
+                                   " path=/api/v1/orders/%u status=%d bytes=%u\n",
+                                   line / 60000 % 60, line / 1000 % 60, line % 1000,
+                                   x % 50 ? "INFO" : "WARN", x, (x >> 8) % 20000, (x >> 4) % 9973,
+                                   x % 97 ? 200 : 404, (x >> 12) % 65536);
+        } else {
+            memcpy(text + pos, filler, flen);
+            pos += flen;
+        }
+        if (line % 64 == 0) {
+            memcpy(text + pos, "card=", 5);
+            pos += 5;
+            pos += (size_t)cardid_gen_next(&gen, text + pos);
+            text[pos++] = '\n';
+            ++*planted;
+        }
+    }
+    return pos;
+}
+
+/**
+ * @brief Free-text PAN discovery throughput: log-like lines, one in 64 carrying a
+ *        generated PAN, fed in 256 KiB chunks as the filesystem crawler does
+ */
+static void benchmark_stream_scan() {
+    printf("=== Stream Scan Benchmark ===\n");
+
+    const size_t size = 64u << 20;
+    char* text = malloc(size);
+    if (!text) return;
+    unsigned long long planted;
+    size_t pos = fill_log_corpus(text, size, false, &planted);
+
+    unsigned long long found = 0;
+    const size_t chunk = 256u << 10;
+    long long start = get_time_us();
+    cardid_scanner scanner;
+    cardid_scanner_init(&scanner, 0);
+    for (size_t off = 0; off < pos; off += chunk) {
+        cardid_scanner_feed(&scanner, text + off, pos - off < chunk ? pos - off : chunk,
+                            count_scan_match, &found);
+    }
+    cardid_scanner_finish(&scanner, count_scan_match, &found);
+    double secs = (double)(get_time_us() - start) / 1e6;
+
+    printf("Scanned %.1f MiB in %.3f s: %.0f MiB/s\n", (double)pos / (1 << 20), secs,
+           (double)pos / (1 << 20) / secs);
+    printf("PANs found: %llu of %llu planted\n", found, planted);
+    printf("\n");
+    free(text);
+}
+
+#if defined(CARDID_HAVE_ZLIB) || defined(CARDID_HAVE_ZSTD)
+// Decode-only baseline: the same decoder loop with nothing downstream.
+static double decompress_only_secs(cardid_archive_format format, const unsigned char* in,
+                                   size_t len, unsigned char* out, size_t cap) {
+    long long start = get_time_us();
+#ifdef CARDID_HAVE_ZLIB
+    if (format == CARDID_ARCHIVE_GZIP) {
+        z_stream z;
+        memset(&z, 0, sizeof(z));
+        inflateInit2(&z, 16 + 15);
+        z.next_in = (unsigned char*)in;
+        z.avail_in = (uInt)len;
+        while (z.avail_in > 0) {
+            z.next_out = out;
+            z.avail_out = (uInt)cap;
+            int rc = inflate(&z, Z_NO_FLUSH);
+            if (rc == Z_STREAM_END) {
+                inflateReset(&z);
+            } else if (rc != Z_OK) {
+                break;
+            }
+        }
+        inflateEnd(&z);
+    }
+#endif
+#ifdef CARDID_HAVE_ZSTD
+    if (format == CARDID_ARCHIVE_ZSTD) {
+        ZSTD_DStream* zs = ZSTD_createDStream();
+        ZSTD_inBuffer ib = {in, len, 0};
+        while (zs && ib.pos < ib.size) {
+            ZSTD_outBuffer ob = {out, cap, 0};
+            if (ZSTD_isError(ZSTD_decompressStream(zs, &ob, &ib))) break;
+        }
+        ZSTD_freeDStream(zs);
+    }
+#endif
+    return (double)(get_time_us() - start) / 1e6;
+}
+
+static void report_archive(const char* name, cardid_archive_format format,
+                           const unsigned char* packed, size_t n, size_t plain,
+                           unsigned char* scratch, size_t scratch_cap) {
+    double decode = decompress_only_secs(format, packed, n, scratch, scratch_cap);
+    unsigned long long found = 0;
+    cardid_archive_stats stats;
+    long long start = get_time_us();
+    cardid_archive_scan(packed, n, 1, count_scan_match, &found, &stats);
+    double one = (double)(get_time_us() - start) / 1e6;
+    found = 0;
+    start = get_time_us();
+    cardid_archive_scan(packed, n, 0, count_scan_match, &found, &stats);
+    double all = (double)(get_time_us() - start) / 1e6;
+    double mib = (double)plain / (1 << 20);
+    printf("%-6s %5.1f MiB -> decode only %.0f MiB/s, scan 1 thread %.0f MiB/s (%.2fx decode),"
+           " %d threads %.0f MiB/s; %llu PANs\n",
+           name, (double)n / (1 << 20), mib / decode, mib / one, one / decode, stats.threads,
+           mib / all, found);
+}
+#endif
+
+/**
+ * @brief Compressed log scanning: bgzip and multi-frame zstd archives of the
+ *        stream-scan corpus, against decompressing the same archive to nowhere
+ */
+static void benchmark_archive() {
+    printf("=== Compressed Archive Benchmark ===\n");
+#if defined(CARDID_HAVE_ZLIB) || defined(CARDID_HAVE_ZSTD)
+    const size_t size = 32u << 20;
+    char* text = malloc(size);
+    unsigned char* packed = malloc(size + (size >> 4) + (1 << 20));
+    unsigned char* scratch = malloc(256u << 10);
+    if (!text || !packed || !scratch) {
+        free(text);
+        free(packed);
+        free(scratch);
+        return;
+    }
+    unsigned long long planted;
+    size_t len = fill_log_corpus(text, size, true, &planted);
+    unsigned long long found = 0;
+    long long start = get_time_us();
+    cardid_archive_scan(text, len, 1, count_scan_match, &found, NULL);
+    double plain = (double)(get_time_us() - start) / 1e6;
+    printf("plain  %5.1f MiB -> scan only %.0f MiB/s\n", (double)len / (1 << 20),
+           (double)len / (1 << 20) / plain);
+#ifdef CARDID_HAVE_ZLIB
+    // bgzip layout: 64 KiB gzip members tagged with their size
+    size_t n = 0;
+    for (size_t off = 0; off < len; off += 65280) {
+        size_t part = len - off < 65280 ? len - off : 65280;
+        z_stream z;
+        memset(&z, 0, sizeof(z));
+        deflateInit2(&z, 6, Z_DEFLATED, -15, 8, Z_DEFAULT_STRATEGY);
+        z.next_in = (unsigned char*)text + off;
+        z.avail_in = (uInt)part;
+        z.next_out = packed + n + 18;
+        z.avail_out = (uInt)deflateBound(&z, (uLong)part);
+        deflate(&z, Z_FINISH);
+        size_t bsize = 18 + z.total_out + 8;
+        deflateEnd(&z);
+        static const unsigned char head[16] = {31, 139, 8, 4, 0, 0, 0,   0,
+                                               0,  255, 6, 0, 'B', 'C', 2, 0};
+        memcpy(packed + n, head, 16);
+        packed[n + 16] = (unsigned char)((bsize - 1) & 0xff);
+        packed[n + 17] = (unsigned char)((bsize - 1) >> 8);
+        uLong crc = crc32(0L, (const unsigned char*)text + off, (uInt)part);
+        unsigned char* t = packed + n + bsize - 8;
+        for (int b = 0; b < 4; b++) t[b] = (unsigned char)(crc >> (8 * b));
+        for (int b = 0; b < 4; b++) t[4 + b] = (unsigned char)(part >> (8 * b));
+        n += bsize;
+    }
+    report_archive("bgzip", CARDID_ARCHIVE_GZIP, packed, n, len, scratch, 256u << 10);
+#endif
+#ifdef CARDID_HAVE_ZSTD
+    size_t zn = 0;
+    size_t zcap = size + (size >> 4) + (1 << 20);
+    for (size_t off = 0; off < len; off += 1u << 20) {
+        size_t part = len - off < (1u << 20) ? len - off : (1u << 20);
+        size_t c = ZSTD_compress(packed + zn, zcap - zn, text + off, part, 3);
+        if (ZSTD_isError(c)) break;
+        zn += c;
+    }
+    report_archive("zstd", CARDID_ARCHIVE_ZSTD, packed, zn, len, scratch, 256u << 10);
+#endif
+    printf("Planted PANs: %llu\n", planted);
+    free(text);
+    free(packed);
+    free(scratch);
+#else
+    printf("Built without zlib and libzstd\n");
+#endif
+    printf("\n");
+}
+
+#ifndef _WIN32
+/**
+ * @brief Tail-follow steady state: cost per poll after small appends to a large
+ *        log should track the appended bytes, not the file size
+ */
+static void benchmark_follow() {
+    printf("=== Tail Follow Benchmark ===\n");
+
+    char path[] = "/tmp/cardid_bench_follow_XXXXXX";
+    int fd = mkstemp(path);
+    if (fd < 0) return;
+    FILE* f = fdopen(fd, "wb");
+    static char block[1 << 16];
+    memset(block, 'x', sizeof(block));
+    for (int i = 0; i < 512; i++) fwrite(block, 1, sizeof(block), f);  // 32 MiB
+    fflush(f);
+
+    const char* paths[] = {path};
+    cardid_follow* fw = cardid_follow_open(paths, 1, NULL);
+    cardid_follow_stats stats;
+    memset(&stats, 0, sizeof(stats));
+    long long start = get_time_us();
+    cardid_follow_poll(fw, NULL, NULL, &stats);
+    double initial = (double)(get_time_us() - start) / 1000.0;
+
+    const int appends = 1000;
+    const char* line = "2024-05-01T12:00:00Z INFO payment card=4111 1111 1111 1111 ok\n";
+    start = get_time_us();
+    for (int i = 0; i < appends; i++) {
+        fputs(line, f);
+        fflush(f);
+        cardid_follow_poll(fw, NULL, NULL, &stats);
+    }
+    double per_poll = (double)(get_time_us() - start) / appends;
+
+    printf("Initial catch-up over 32 MiB: %.1f ms\n", initial);
+    printf("Append %zu bytes + poll: %.1f us (matches: %llu)\n", strlen(line), per_poll,
+           stats.matches);
+    printf("\n");
+    cardid_follow_close(fw);
+    fclose(f);
+    remove(path);
+}
+#endif
+
+/**
+ * @brief Analysis over a generated corpus with a realistic mix of networks,
+ *        lengths, separators, bad checksums and junk
+ */
+static void benchmark_generated_corpus() {
+    printf("=== Generated Corpus Benchmark ===\n");
+
+    enum { CORPUS = 100000 };
+    static char text[CORPUS][CARDID_GEN_MAX_TEXT + 1];
+    cardid_gen_config cfg;
+    memset(&cfg, 0, sizeof(cfg));
+    cfg.network_weight[CARD_VISA] = 5;
+    cfg.network_weight[CARD_MASTERCARD] = 3;
+    cfg.network_weight[CARD_AMEX] = 1;
+    cfg.network_weight[CARD_DISCOVER] = 1;
+    cfg.invalid_rate = 0.05;
+    cfg.separator_rate = 0.3;
+    cfg.garbage_rate = 0.01;
+    cfg.seed = 2024;
+
+    cardid_gen gen;
+    if (cardid_gen_init(&gen, &cfg) != CARDID_OK) {
+        printf("Generator configuration rejected\n\n");
+        return;
+    }
+    long long start = get_time_us();
+    for (int i = 0; i < CORPUS; i++) {
+        text[i][cardid_gen_next(&gen, text[i])] = '\0';
+    }
+    long long gen_time = get_time_us() - start;
+
+    int valid = 0;
+    cardid_result result;
+    start = get_time_us();
+    for (int round = 0; round < 10; round++) {
+        for (int i = 0; i < CORPUS; i++) {
+            cardid_analyze(text[i], &result, NULL);
+            valid += result.luhn_valid && result.network != CARD_UNKNOWN;
+        }
+    }
+    long long total_time = get_time_us() - start;
+    double avg_time = (double)total_time / (10.0 * CORPUS);
+
+    printf("Corpus: %d PANs generated in %lld μs\n", CORPUS, gen_time);
+    printf("Valid fraction: %.3f\n", (double)valid / (10.0 * CORPUS));
+    printf("Average time: %.3f μs per analysis\n", avg_time);
+    printf("Analyses per second: %.0f\n", 1000000.0 / avg_time);
+    printf("\n");
+}
+
+#ifndef _WIN32
+typedef struct {
+    cardid_velocity* v;
+    uint32_t seed;
+    int events;
+    uint64_t step_ns;
+} velocity_worker;
+
+static void* velocity_add_worker(void* arg) {
+    velocity_worker* w = arg;
+    uint32_t x = w->seed;
+    for (int i = 0; i < w->events; i++) {
+        x = x * 1664525u + 1013904223u;
+        cardid_velocity_add(w->v, x >> 12, (uint64_t)i * w->step_ns);
+    }
+    return NULL;
+}
+
+/**
+ * @brief Velocity sketch: observed overestimate against the count-min bound, and
+ *        add throughput with 1..8 threads sharing one tracker
+ */
+static void benchmark_velocity() {
+    printf("=== Velocity Benchmark ===\n");
+
+    enum { KEYS = 100000, EVENTS = 2000000 };
+    cardid_velocity* v = cardid_velocity_create(NULL);
+    unsigned* exact = calloc(KEYS, sizeof(unsigned));
+    if (!v || !exact) {
+        cardid_velocity_destroy(v);
+        free(exact);
+        return;
+    }
+    double eps, delta;
+    cardid_velocity_bounds(v, &eps, &delta);
+
+    // Skewed keys: half the events go to the first 1% of keys. All land within
+    // ten one-minute slices; query the ten-minute window at the end.
+    const uint64_t minute = 60000000000ull;
+    uint32_t x = 1;
+    for (int i = 0; i < EVENTS; i++) {
+        x = x * 1664525u + 1013904223u;
+        unsigned k = (x >> 8) % (x & 1 ? KEYS / 100 : KEYS);
+        ++exact[k];
+        cardid_velocity_add(v, k, (uint64_t)i * (10 * minute / EVENTS));
+    }
+    uint64_t now = 10 * minute - 1;
+    uint64_t total = cardid_velocity_total(v, 10 * minute, now);
+    double bound = eps * (double)total, sum_over = 0;
+    uint64_t max_over = 0;
+    int over_bound = 0;
+    long long start = get_time_us();
+    for (unsigned k = 0; k < KEYS; k++) {
+        uint64_t over = cardid_velocity_count(v, k, 10 * minute, now) - exact[k];
+        sum_over += (double)over;
+        if (over > max_over) max_over = over;
+        over_bound += (double)over > bound;
+    }
+    double query_ns = (double)(get_time_us() - start) * 1000.0 / KEYS;
+
+    printf("Sketch: %.1f MiB, epsilon %.2e, delta %.3f\n",
+           (double)cardid_velocity_memory(v) / (1 << 20), eps, delta);
+    printf("Window total %llu, bound eps*N = %.1f\n", (unsigned long long)total, bound);
+    printf("Overestimate: max %llu, mean %.3f, keys over bound %.4f%% (delta %.2f%%)\n",
+           (unsigned long long)max_over, sum_over / KEYS, 100.0 * over_bound / KEYS,
+           100.0 * delta);
+    printf("Query: %.1f ns per 10-slice count\n", query_ns);
+    cardid_velocity_destroy(v);
+    free(exact);
+
+    // Throughput: a 1 us/event clock across all threads against 50 ms slices, so
+    // every run crosses 40 slice boundaries and wraps the 16-slice ring.
+    cardid_velocity_config cfg = {0, 0, 16, 50000000, 0};
+    for (int threads = 1; threads <= 8; threads *= 2) {
+        v = cardid_velocity_create(&cfg);
+        if (!v) return;
+        velocity_worker w[8];
+        pthread_t tid[8];
+        int per = EVENTS / threads;
+        start = get_time_us();
+        for (int t = 0; t < threads; t++) {
+            w[t] = (velocity_worker){v, 0x9e3779b9u * (uint32_t)(t + 1), per, 1000u * threads};
+            pthread_create(&tid[t], NULL, velocity_add_worker, &w[t]);
+        }
+        for (int t = 0; t < threads; t++) pthread_join(tid[t], NULL);
+        double secs = (double)(get_time_us() - start) / 1e6;
+        printf("%d thread%s: %.1f M adds/s\n", threads, threads == 1 ? " " : "s",
+               (double)per * threads / secs / 1e6);
+        cardid_velocity_destroy(v);
+    }
+    printf("\n");
+}
+#endif
+
+#ifndef _WIN32
+/**
+ * @brief Columnar result file: cost of writing it alongside a record run, and of
+ *        pulling one network or one BIN range back out versus re-parsing the text
+ */
+static void benchmark_results_file() {
+    printf("=== Result File Benchmark ===\n");
+
+    enum { RECORDS = 1000000 };
+    const char* path = "/tmp/cardid_bench_results.cidr";
+    size_t cap = (size_t)RECORDS * (CARDID_GEN_MAX_TEXT + 1);
+    char* text = malloc(cap);
+    FILE* in = tmpfile();
+    FILE* sink = fopen("/dev/null", "w");
+    if (!text || !in || !sink) {
+        free(text);
+        if (in) fclose(in);
+        if (sink) fclose(sink);
+        return;
+    }
+    cardid_gen_config gcfg;
+    memset(&gcfg, 0, sizeof(gcfg));
+    gcfg.seed = 35;
+    gcfg.invalid_rate = 0.05;
+    cardid_gen gen;
+    size_t records = 0, len = 0;
+    if (cardid_gen_init(&gen, &gcfg) == CARDID_OK) {
+        len = cardid_gen_fill(&gen, CARDID_GEN_LINES, text, cap, RECORDS, &records);
+    }
+    fwrite(text, 1, len, in);
+    free(text);
+
+    cardid_record_config cfg = {CARDID_RECORD_CSV, 0, false, NULL, 0, NULL, NULL};
+    rewind(in);
+    long long start = get_time_us();
+    cardid_record_stream(in, sink, &cfg, NULL);
+    long long parse_us = get_time_us() - start;
+
+    rewind(in);
+    start = get_time_us();
+    cardid_status st = cardid_results_writer_open(path, &cfg.results);
+    if (st == CARDID_OK) {
+        cardid_record_stream(in, sink, &cfg, NULL);
+        st = cardid_results_writer_close(cfg.results);
+    }
+    long long write_us = get_time_us() - start;
+    fclose(in);
+    fclose(sink);
+
+    cardid_results* r = NULL;
+    if (st != CARDID_OK || cardid_results_open(path, &r) != CARDID_OK) {
+        printf("Result file could not be written\n\n");
+        remove(path);
+        return;
+    }
+    cardid_results_row row;
+    cardid_results_iter it;
+    const cardid_results_filter amex = {true, CARD_AMEX, false, 0, 0, true};
+    const cardid_results_filter bin = {false, CARD_UNKNOWN, true, 411100, 411199, false};
+    unsigned long long amex_rows = 0, bin_rows = 0;
+    start = get_time_us();
+    cardid_results_iter_init(&it, r, &amex);
+    while (cardid_results_next(&it, &row)) amex_rows++;
+    long long amex_us = get_time_us() - start;
+    start = get_time_us();
+    cardid_results_iter_init(&it, r, &bin);
+    while (cardid_results_next(&it, &row)) bin_rows++;
+    long long bin_us = get_time_us() - start;
+    cardid_results_close(r);
+
+    printf("Records: %zu (%.1f MiB of text)\n", records, (double)len / (1 << 20));
+    printf("Text re-parse:           %lld μs\n", parse_us);
+    printf("Parse + write results:   %lld μs\n", write_us);
+    printf("All valid AMEX (%llu):   %lld μs\n", amex_rows, amex_us);
+    printf("BIN 4111xx (%llu):       %lld μs\n", bin_rows, bin_us);
+    printf("\n");
+    remove(path);
+}
+#endif
+
 /**
  * @brief Main benchmark function
  */
@@ -249,8 +903,22 @@ int main() {
     benchmark_extraction();
     benchmark_network_detection();
     benchmark_analysis();
+    benchmark_batch_analysis();
+    benchmark_stream_scan();
+    benchmark_archive();
+#ifndef _WIN32
+    benchmark_follow();
+#endif
     benchmark_card_types();
+    benchmark_generated_corpus();
     benchmark_memory();
+    benchmark_metrics_overhead();
+    benchmark_probe_overhead();
+    benchmark_tokenize();
+#ifndef _WIN32
+    benchmark_velocity();
+    benchmark_results_file();
+#endif
     
     printf("Benchmark completed!\n");
     return 0;
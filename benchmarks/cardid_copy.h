@@ -0,0 +1,39 @@
+/**
+ * @file cardid_copy.h
+ * @brief Renames for compiling src/cardid.c a second time into the benchmark
+ *
+ * Define CARDID_COPY_PREFIX (e.g. cardid_probed_) and include this before
+ * src/cardid.c: every external symbol of that file, USDT semaphores included,
+ * gets the prefix instead of "cardid_", so the copy links next to the library.
+ * A symbol added to src/cardid.c without a rename here fails the benchmark link.
+ */
+#pragma once
+
+#define CARDID_COPY_PASTE(p, n) p##n
+#define CARDID_COPY_NAME(p, n) CARDID_COPY_PASTE(p, n)
+#define CARDID_COPY(n) CARDID_COPY_NAME(CARDID_COPY_PREFIX, n)
+
+#define cardid_probes_available CARDID_COPY(probes_available)
+#define cardid_luhn_digits CARDID_COPY(luhn_digits)
+#define cardid_network_name CARDID_COPY(network_name)
+#define cardid_extract_digits CARDID_COPY(extract_digits)
+#define cardid_extract_digits_n CARDID_COPY(extract_digits_n)
+#define cardid_network_rules CARDID_COPY(network_rules)
+#define cardid_network_rule_count CARDID_COPY(network_rule_count)
+#define cardid_detect_network CARDID_COPY(detect_network)
+#define cardid_analyze CARDID_COPY(analyze)
+#define cardid_analyze_into CARDID_COPY(analyze_into)
+#define cardid_analyze_n CARDID_COPY(analyze_n)
+#define cardid_analyze_batch CARDID_COPY(analyze_batch)
+
+// Semaphores are named provider_probe_semaphore by sdt.h; the pasted names are
+// rescanned, so these reach both the definitions and the probe notes.
+#define cardid_analyze__entry_semaphore CARDID_COPY(analyze__entry_semaphore)
+#define cardid_analyze__return_semaphore CARDID_COPY(analyze__return_semaphore)
+#define cardid_reject_semaphore CARDID_COPY(reject_semaphore)
+#define cardid_extract__entry_semaphore CARDID_COPY(extract__entry_semaphore)
+#define cardid_extract__return_semaphore CARDID_COPY(extract__return_semaphore)
+#define cardid_luhn__entry_semaphore CARDID_COPY(luhn__entry_semaphore)
+#define cardid_luhn__return_semaphore CARDID_COPY(luhn__return_semaphore)
+#define cardid_detect__entry_semaphore CARDID_COPY(detect__entry_semaphore)
+#define cardid_detect__return_semaphore CARDID_COPY(detect__return_semaphore)
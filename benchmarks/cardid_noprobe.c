@@ -0,0 +1,14 @@
+/**
+ * @file cardid_noprobe.c
+ * @brief The analysis path built without USDT probe sites
+ *
+ * benchmark_probe_overhead times this copy against cardid_probed.c, the same
+ * source with probes compiled in when sys/sdt.h is available. Both copies are
+ * built alike (see CMakeLists.txt), so only the probe sites differ.
+ */
+
+#undef CARDID_USDT
+#define CARDID_COPY_PREFIX cardid_noprobe_
+#include "cardid_copy.h"
+
+#include "../src/cardid.c"
@@ -0,0 +1,12 @@
+/**
+ * @file cardid_probed.c
+ * @brief The analysis path built with USDT probe sites (when sys/sdt.h exists)
+ *
+ * Counterpart of cardid_noprobe.c for benchmark_probe_overhead. CMake defines
+ * CARDID_USDT here exactly when it does for the library.
+ */
+
+#define CARDID_COPY_PREFIX cardid_probed_
+#include "cardid_copy.h"
+
+#include "../src/cardid.c"
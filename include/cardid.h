@@ -1,5 +1,10 @@
 #pragma once
 #include <stdbool.h>
+#include <stddef.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
 
 typedef enum {
   CARD_UNKNOWN = 0,
@@ -15,6 +20,30 @@ typedef struct {
   int length;
 } cardid_result;
 
+// Why cardid_analyze accepted or rejected an input, in the order it checks.
+typedef enum {
+  CARDID_OUTCOME_VALID = 0,         // Luhn valid and a known network
+  CARDID_OUTCOME_EMPTY,             // no digits in the input
+  CARDID_OUTCOME_OVERFLOW,          // more than CARDID_MAX_DIGITS digits
+  CARDID_OUTCOME_BAD_LENGTH,        // fewer than 13 digits
+  CARDID_OUTCOME_LENGTH_FILTERED,   // 14, 17 or 18 digits (not an issued PAN length)
+  CARDID_OUTCOME_LUHN_FAIL,         // checksum mismatch
+  CARDID_OUTCOME_UNKNOWN_NETWORK,   // Luhn valid but no network prefix matched
+  CARDID_OUTCOME_COUNT
+} cardid_outcome;
+
+// Status codes returned by the streaming/batch entry points.
+typedef enum {
+  CARDID_OK = 0,
+  CARDID_ERR_ARG,     // invalid argument or configuration
+  CARDID_ERR_IO,      // read/write failure on a stream or file
+  CARDID_ERR_NOMEM,   // allocation failure
+  CARDID_ERR_FORMAT,  // malformed input (e.g. record exceeds the size limit)
+} cardid_status;
+
+// Upper-case network name ("VISA", "MASTERCARD", "AMEX", "DISCOVER", "UNKNOWN").
+const char* cardid_network_name(cardid_network network);
+
 bool cardid_luhn_digits(const char* digits, int len);
 
 // Maximum number of PAN digits supported by this library (ISO allows up to 19)
@@ -32,6 +61,13 @@ cardid_extract_result cardid_extract_digits(const char* input,
                                             char* out_digits,
                                             int out_capacity);
 
+// Same as cardid_extract_digits but reads exactly input_len bytes, so callers can
+// validate a field inside a larger buffer without copying or NUL-terminating it.
+cardid_extract_result cardid_extract_digits_n(const char* input,
+                                              size_t input_len,
+                                              char* out_digits,
+                                              int out_capacity);
+
 // Detect network from a clean digits string and its length.
 cardid_network cardid_detect_network(const char* digits, int len);
 
@@ -39,3 +75,19 @@ cardid_network cardid_detect_network(const char* digits, int len);
 void cardid_analyze(const char* input,
                     cardid_result* out,
                     cardid_extract_result* extract_meta);
+
+// Length-delimited variant of cardid_analyze (input need not be NUL-terminated).
+void cardid_analyze_n(const char* input,
+                      size_t input_len,
+                      cardid_result* out,
+                      cardid_extract_result* extract_meta);
+
+// Analyze count NUL-terminated inputs into out[0..count-1].
+void cardid_analyze_batch(const char* const* inputs, size_t count, cardid_result* out);
+
+// True when the library was built with USDT tracepoints (see src/cardid_probes.h).
+bool cardid_probes_available(void);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,310 @@
+#pragma once
+// C++17 interface to the validation core, header-only: nothing here calls into
+// the compiled library. Every function is constexpr, so fixed PANs in tests and
+// configuration can be checked with static_assert, and takes std::string_view,
+// so std::string fields are validated in place without a NUL-terminated copy.
+//
+// Results are bit-for-bit those of cardid_analyze_n / cardid_luhn_digits /
+// cardid_detect_network in the default "C" locale (the library never changes
+// it): same digit extraction, same overflow rule, same length filter, same
+// prefix table. tests/test_cardid_hpp.cpp checks this against the C library.
+//
+// analyze() keeps no copy of the digits: it folds them into the two running
+// Luhn sums and the six-digit prefix as it reads, so there is nothing to wipe.
+// These calls do not feed cardid_metrics.h counters or USDT probes.
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <string_view>
+#include <type_traits>
+#include <utility>
+#if defined(__has_include)
+#if __has_include(<span>) && (__cplusplus >= 202002L || (defined(_MSVC_LANG) && _MSVC_LANG >= 202002L))
+#include <span>
+#endif
+#endif
+#include "cardid.h"
+
+namespace cardid {
+
+#if defined(__cpp_lib_span)
+template <class T>
+using span = std::span<T>;
+#else
+// Stand-in for std::span before C++20: a pointer and a size, constructible from
+// arrays and from contiguous containers with data() and size().
+template <class T>
+class span {
+ public:
+  constexpr span() noexcept = default;
+  constexpr span(T* data, std::size_t size) noexcept : data_(data), size_(size) {}
+  template <std::size_t N>
+  constexpr span(T (&array)[N]) noexcept : data_(array), size_(N) {}
+  template <class C,
+            class = std::enable_if_t<
+                !std::is_same_v<std::decay_t<C>, span> &&
+                std::is_convertible_v<decltype(std::declval<C&>().data()), T*>>>
+  constexpr span(C&& c) noexcept : data_(c.data()), size_(c.size()) {}
+
+  constexpr T* data() const noexcept { return data_; }
+  constexpr std::size_t size() const noexcept { return size_; }
+  constexpr bool empty() const noexcept { return size_ == 0; }
+  constexpr T& operator[](std::size_t i) const noexcept { return data_[i]; }
+  constexpr T* begin() const noexcept { return data_; }
+  constexpr T* end() const noexcept { return data_ + size_; }
+
+ private:
+  T* data_ = nullptr;
+  std::size_t size_ = 0;
+};
+#endif
+
+namespace detail {
+
+constexpr unsigned len_bit(int n) { return 1u << n; }
+
+struct network_rule {
+  cardid_network network;
+  int prefix_len;
+  int lo, hi;
+  unsigned lengths;
+};
+
+// Same rules, same order as cardid_network_rules in src/cardid.c.
+inline constexpr network_rule network_rules[] = {
+    {CARD_AMEX, 2, 34, 34, len_bit(15)},
+    {CARD_AMEX, 2, 37, 37, len_bit(15)},
+    {CARD_VISA, 1, 4, 4, len_bit(13) | len_bit(16) | len_bit(19)},
+    {CARD_MASTERCARD, 2, 51, 55, len_bit(16)},
+    {CARD_MASTERCARD, 4, 2221, 2720, len_bit(16)},
+    {CARD_DISCOVER, 4, 6011, 6011, len_bit(16) | len_bit(19)},
+    {CARD_DISCOVER, 2, 65, 65, len_bit(16) | len_bit(19)},
+    {CARD_DISCOVER, 3, 644, 649, len_bit(16) | len_bit(19)},
+    {CARD_DISCOVER, 6, 622126, 622925, len_bit(16) | len_bit(19)},
+};
+
+// No rule looks at more than this many leading digits.
+inline constexpr int max_prefix_len = 6;
+
+// isdigit / isspace in the "C" locale.
+constexpr bool is_digit(unsigned char c) { return c >= '0' && c <= '9'; }
+constexpr bool is_space(unsigned char c) { return c == ' ' || (c >= '\t' && c <= '\r'); }
+
+constexpr int pow10(int n) {
+  int v = 1;
+  while (n-- > 0) v *= 10;
+  return v;
+}
+
+// Network from the value of the first six digits of a len-digit PAN (len >= 6).
+constexpr cardid_network detect_prefix6(int prefix6, int len) {
+  if (len <= 0 || len > CARDID_MAX_DIGITS) return CARD_UNKNOWN;
+  for (const network_rule& r : network_rules) {
+    if (!(r.lengths & len_bit(len))) continue;
+    int p = prefix6 / pow10(max_prefix_len - r.prefix_len);
+    if (p >= r.lo && p <= r.hi) return r.network;
+  }
+  return CARD_UNKNOWN;
+}
+
+// The doubling step of Luhn: 2v, minus 9 when that has two digits.
+constexpr int luhn_double(int v) { return v * 2 > 9 ? v * 2 - 9 : v * 2; }
+
+constexpr bool length_allowed(int len) {
+  return len == 13 || len == 15 || len == 16 || len == 19;
+}
+
+}  // namespace detail
+
+// cardid_luhn_digits: false if any byte is not a digit; an empty string passes.
+constexpr bool luhn(std::string_view digits) noexcept {
+  int sum = 0;
+  std::size_t pos = 0;
+  for (std::size_t i = digits.size(); i-- > 0; ++pos) {
+    int v = digits[i] - '0';
+    if (static_cast<unsigned>(v) > 9) return false;
+    sum += (pos & 1) ? detail::luhn_double(v) : v;
+  }
+  return sum % 10 == 0;
+}
+
+// cardid_detect_network on clean digits (no separators).
+constexpr cardid_network detect_network(std::string_view digits) noexcept {
+  if (digits.empty() || digits.size() > CARDID_MAX_DIGITS) return CARD_UNKNOWN;
+  const int len = static_cast<int>(digits.size());
+  for (const detail::network_rule& r : detail::network_rules) {
+    if (!(r.lengths & detail::len_bit(len))) continue;
+    if (len < r.prefix_len) continue;
+    int p = 0;
+    for (int i = 0; i < r.prefix_len; ++i) p = p * 10 + (digits[i] - '0');
+    if (p >= r.lo && p <= r.hi) return r.network;
+  }
+  return CARD_UNKNOWN;
+}
+
+// cardid_analyze_n: fills out (and meta when given) exactly as the C call would
+// and returns the outcome that decided it.
+constexpr cardid_outcome analyze(std::string_view input,
+                                 cardid_result& out,
+                                 cardid_extract_result* meta = nullptr) noexcept {
+  int count = 0;
+  bool non_digit = false, overflowed = false;
+  int prefix6 = 0;
+  int sum[2] = {0, 0};  // Luhn sums doubling the digits at even / odd indexes from the left
+  for (char ch : input) {
+    const unsigned char c = static_cast<unsigned char>(ch);
+    if (count >= CARDID_MAX_DIGITS) {  // extraction buffer full, as in C
+      overflowed = true;
+      break;
+    }
+    if (detail::is_digit(c)) {
+      const int v = c - '0';
+      if (count < detail::max_prefix_len) prefix6 = prefix6 * 10 + v;
+      sum[count & 1] += detail::luhn_double(v);
+      sum[(count & 1) ^ 1] += v;
+      ++count;
+    } else if (!detail::is_space(c) && c != '-') {
+      non_digit = true;
+    }
+  }
+  if (meta) *meta = cardid_extract_result{count, non_digit, overflowed};
+
+  out.length = count;
+  out.luhn_valid = false;
+  out.network = CARD_UNKNOWN;
+  if (overflowed) return CARDID_OUTCOME_OVERFLOW;
+  if (count == 0) return CARDID_OUTCOME_EMPTY;
+  if (count < 13 || count > 19) return CARDID_OUTCOME_BAD_LENGTH;
+  if (!detail::length_allowed(count)) return CARDID_OUTCOME_LENGTH_FILTERED;
+  // Index i is doubled when it sits an odd distance from the check digit,
+  // i.e. when i and count have the same parity.
+  out.luhn_valid = sum[count & 1] % 10 == 0;
+  if (!out.luhn_valid) return CARDID_OUTCOME_LUHN_FAIL;
+  out.network = detail::detect_prefix6(prefix6, count);
+  return out.network == CARD_UNKNOWN ? CARDID_OUTCOME_UNKNOWN_NETWORK : CARDID_OUTCOME_VALID;
+}
+
+constexpr cardid_result analyze(std::string_view input) noexcept {
+  cardid_result out{CARD_UNKNOWN, false, 0};
+  analyze(input, out);
+  return out;
+}
+
+// Luhn valid and a known network: static_assert(cardid::valid("4111 1111 1111 1111")).
+constexpr bool valid(std::string_view input) noexcept {
+  cardid_result out{CARD_UNKNOWN, false, 0};
+  return analyze(input, out) == CARDID_OUTCOME_VALID;
+}
+
+// cardid_network_name.
+constexpr std::string_view network_name(cardid_network network) noexcept {
+  switch (network) {
+    case CARD_VISA: return "VISA";
+    case CARD_MASTERCARD: return "MASTERCARD";
+    case CARD_AMEX: return "AMEX";
+    case CARD_DISCOVER: return "DISCOVER";
+    default: return "UNKNOWN";
+  }
+}
+
+// ---------------------------------------------------------------------------
+// Length-specialized forms for fixed-width digit fields. With Len a constant
+// the loops have fixed trip counts and the rules for other lengths drop out,
+// so these inline into straight-line code at the call site.
+
+template <int Len>
+constexpr bool luhn(const char* digits) noexcept {
+  static_assert(Len >= 0 && Len <= CARDID_MAX_DIGITS, "PAN length out of range");
+  int sum = 0;
+  for (int i = 0; i < Len; ++i) {
+    int v = digits[i] - '0';
+    if (static_cast<unsigned>(v) > 9) return false;
+    sum += ((Len - 1 - i) & 1) ? detail::luhn_double(v) : v;
+  }
+  return sum % 10 == 0;
+}
+
+template <int Len>
+constexpr cardid_network detect_network(const char* digits) noexcept {
+  static_assert(Len >= 0 && Len <= CARDID_MAX_DIGITS, "PAN length out of range");
+  if constexpr (Len == 0) {
+    return CARD_UNKNOWN;
+  } else {
+    for (const detail::network_rule& r : detail::network_rules) {
+      if (!(r.lengths & detail::len_bit(Len)) || Len < r.prefix_len) continue;
+      int p = 0;
+      for (int i = 0; i < r.prefix_len; ++i) p = p * 10 + (digits[i] - '0');
+      if (p >= r.lo && p <= r.hi) return r.network;
+    }
+    return CARD_UNKNOWN;
+  }
+}
+
+// analyze() on exactly Len bytes. Fields that hold anything but Len digits take
+// the general path, so the result is the same for any bytes.
+template <int Len>
+constexpr cardid_outcome analyze_digits(const char* digits, cardid_result& out) noexcept {
+  static_assert(Len >= 0, "negative length");
+  for (int i = 0; i < Len; ++i) {
+    if (!detail::is_digit(static_cast<unsigned char>(digits[i])))
+      return analyze(std::string_view(digits, static_cast<std::size_t>(Len)), out);
+  }
+  out.length = Len > CARDID_MAX_DIGITS ? CARDID_MAX_DIGITS : Len;
+  out.luhn_valid = false;
+  out.network = CARD_UNKNOWN;
+  if constexpr (Len > CARDID_MAX_DIGITS) {
+    return CARDID_OUTCOME_OVERFLOW;
+  } else if constexpr (Len == 0) {
+    return CARDID_OUTCOME_EMPTY;
+  } else if constexpr (Len < 13) {
+    return CARDID_OUTCOME_BAD_LENGTH;
+  } else if constexpr (!detail::length_allowed(Len)) {
+    return CARDID_OUTCOME_LENGTH_FILTERED;
+  } else {
+    out.luhn_valid = luhn<Len>(digits);
+    if (!out.luhn_valid) return CARDID_OUTCOME_LUHN_FAIL;
+    out.network = detect_network<Len>(digits);
+    return out.network == CARD_UNKNOWN ? CARDID_OUTCOME_UNKNOWN_NETWORK : CARDID_OUTCOME_VALID;
+  }
+}
+
+template <std::size_t N>
+constexpr cardid_outcome analyze_digits(const std::array<char, N>& digits,
+                                        cardid_result& out) noexcept {
+  return analyze_digits<static_cast<int>(N)>(digits.data(), out);
+}
+
+// ---------------------------------------------------------------------------
+// Batch forms. They write into the caller's spans and allocate nothing; each
+// processes min(inputs, outputs) entries and returns that count.
+
+inline std::size_t analyze_batch(span<const std::string_view> inputs,
+                                 span<cardid_result> out) noexcept {
+  const std::size_t n = inputs.size() < out.size() ? inputs.size() : out.size();
+  for (std::size_t i = 0; i < n; ++i) analyze(inputs[i], out[i]);
+  return n;
+}
+
+inline std::size_t analyze_batch(span<const std::string_view> inputs,
+                                 span<cardid_result> out,
+                                 span<cardid_outcome> outcomes) noexcept {
+  std::size_t n = inputs.size() < out.size() ? inputs.size() : out.size();
+  if (outcomes.size() < n) n = outcomes.size();
+  for (std::size_t i = 0; i < n; ++i) outcomes[i] = analyze(inputs[i], out[i]);
+  return n;
+}
+
+// Fixed-width records packed back to back, Len bytes each (e.g. a PAN column
+// of a fixed-width file); a trailing partial record is ignored.
+template <int Len>
+std::size_t analyze_batch_digits(span<const char> packed, span<cardid_result> out) noexcept {
+  static_assert(Len > 0, "record width must be positive");
+  std::size_t n = packed.size() / static_cast<std::size_t>(Len);
+  if (out.size() < n) n = out.size();
+  for (std::size_t i = 0; i < n; ++i)
+    analyze_digits<Len>(packed.data() + i * static_cast<std::size_t>(Len), out[i]);
+  return n;
+}
+
+}  // namespace cardid
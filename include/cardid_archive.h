@@ -0,0 +1,75 @@
+#pragma once
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+#include "cardid.h"
+#include "cardid_scan.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// PAN discovery in compressed logs without temporary files. gzip (zlib) and
+// zstd (libzstd) are optional build-time dependencies (CARDID_ENABLE_ZLIB,
+// CARDID_ENABLE_ZSTD); cardid_archive_supported says what this build has.
+// Offsets in matches are offsets in the decompressed stream, and the matches
+// are exactly those cardid_scan.h would report on the decompressed bytes.
+//
+// Archives made of independently decodable pieces (the blocks of a bgzip file,
+// the frames of a multi-frame zstd file such as pzstd or seekable-format
+// output) are split into groups decoded and scanned on several threads. Each
+// group is scanned between its first and last "sync" byte (anything other than
+// a digit, ' ' or '-', after which scanner state no longer depends on earlier
+// bytes); the few bytes around each seam are then scanned in order on the
+// calling thread, so PANs that straddle a block boundary are still found.
+// Groups are decoded in fixed-size chunks and only a few groups are in flight,
+// so memory does not grow with how far a block inflates; a group whose seam
+// bytes or matches outgrow their caps is decoded again on the calling thread.
+// Single-stream gzip and single-frame zstd are decoded sequentially in bounded
+// memory.
+
+typedef enum {
+  CARDID_ARCHIVE_PLAIN = 0,  // not compressed (scanned as is)
+  CARDID_ARCHIVE_GZIP,
+  CARDID_ARCHIVE_ZSTD,
+} cardid_archive_format;
+
+// Format from the first bytes of a file (4 are enough).
+cardid_archive_format cardid_archive_detect(const void* head, size_t len);
+
+// Whether this build can decode format (always true for PLAIN).
+bool cardid_archive_supported(cardid_archive_format format);
+
+// "plain", "gzip" or "zstd".
+const char* cardid_archive_format_name(cardid_archive_format format);
+
+typedef struct {
+  cardid_archive_format format;
+  unsigned long long input_bytes;  // compressed bytes consumed
+  unsigned long long bytes;        // decompressed bytes scanned
+  unsigned long long matches;
+  unsigned long long blocks;       // bgzip blocks / zstd frames split out for threads
+  int threads;                     // threads that decoded (1: sequential)
+} cardid_archive_stats;
+
+// Scan the decompressed contents of len bytes at data (typically an mmap'ed
+// file) using up to threads threads (0 selects the online CPUs). cb runs on the
+// calling thread, in offset order. CARDID_ERR_ARG if the format is not built
+// in, CARDID_ERR_FORMAT on corrupt or truncated data. stats may be NULL.
+cardid_status cardid_archive_scan(const void* data,
+                                  size_t len,
+                                  int threads,
+                                  cardid_scan_callback cb,
+                                  void* ctx,
+                                  cardid_archive_stats* stats);
+
+// Same for a non-seekable stream (a pipe, stdin), decoded sequentially as it
+// is read. CARDID_ERR_IO on read errors.
+cardid_status cardid_archive_scan_stream(FILE* in,
+                                         cardid_scan_callback cb,
+                                         void* ctx,
+                                         cardid_archive_stats* stats);
+
+#ifdef __cplusplus
+}
+#endif
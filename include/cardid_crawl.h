@@ -0,0 +1,70 @@
+#pragma once
+#include <stdio.h>
+#include "cardid.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Parallel filesystem sweep for stray PANs (PCI scope audits). Worker threads
+// share a stack of directories and files to visit; each worker reads its files
+// through a small pipeline of fixed buffers and runs them through the
+// cardid_scan.h scanner. On Linux the reads are batched through an io_uring
+// per worker; where io_uring is missing or refused, the same workers fall back
+// to pread. Memory in flight is bounded by threads * queue_depth * buffer_size,
+// plus up to 64 MiB per compressed file being decoded on several threads.
+// Symbolic links and special files are never followed or read.
+//
+// Report lines (one per file that had matches or could not be read), fields
+// separated by tabs, path escaped as in C (\\, \t, \n, \r):
+//
+//   <path> <matches> <offset>:<NETWORK>:<length>[,<offset>:<NETWORK>:<length>...][,+N]
+//   <path> error     <reason>
+//
+// gzip and zstd files (recognized by their magic bytes, whatever their name)
+// are scanned decompressed, with offsets into the decompressed data, when the
+// library was built with zlib / libzstd (see cardid_archive.h); a corrupt one is
+// reported as an error line. Full PANs are never written anywhere. The manifest records, per file read,
+// its size, mtime and match count; files whose size and mtime still match a
+// previous manifest are skipped and carried over to the new one.
+
+typedef enum {
+  CARDID_CRAWL_IO_AUTO = 0,  // io_uring when the kernel allows it, else pread
+  CARDID_CRAWL_IO_URING,     // io_uring or fail with CARDID_ERR_IO
+  CARDID_CRAWL_IO_PREAD,     // blocking pread in each worker
+} cardid_crawl_io;
+
+typedef struct {
+  int threads;                // workers; 0 selects the number of online CPUs
+  int queue_depth;            // reads in flight per worker; 0 selects 4
+  size_t buffer_size;         // bytes per read; 0 selects 256 KiB
+  unsigned max_listed;        // matches listed per report line; 0 selects 1000
+  cardid_crawl_io io;
+  const char* manifest_in;    // previous manifest to skip unchanged files, or NULL
+  const char* manifest_out;   // manifest to write (atomically replaced), or NULL
+} cardid_crawl_config;
+
+typedef struct {
+  unsigned long long files_scanned;
+  unsigned long long files_skipped;  // unchanged since manifest_in
+  unsigned long long files_failed;
+  unsigned long long bytes_scanned;  // decompressed bytes for compressed files
+  unsigned long long matches;        // in files scanned this run
+  unsigned long long files_with_matches;
+  bool io_uring;                     // at least one worker read through io_uring
+  unsigned long long files_decompressed;  // gzip/zstd files among files_scanned
+} cardid_crawl_stats;
+
+// Sweep the given roots (directories or regular files), writing the report to
+// report. Returns CARDID_ERR_IO if the manifest cannot be read or written, the
+// report cannot be written, or io_uring was required but unavailable; files
+// that cannot be read are reported and counted but do not fail the crawl.
+cardid_status cardid_crawl(const char* const* roots,
+                           size_t root_count,
+                           FILE* report,
+                           const cardid_crawl_config* cfg,
+                           cardid_crawl_stats* stats);
+
+#ifdef __cplusplus
+}
+#endif
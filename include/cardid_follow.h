@@ -0,0 +1,70 @@
+#pragma once
+#include <stddef.h>
+#include <stdint.h>
+#include "cardid.h"
+#include "cardid_scan.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Tail-follow scanning of append-only logs. Each followed file keeps a
+// cardid_scan.h scanner alive between polls, so a PAN whose digits arrive in two
+// separate appends is still found, and each poll reads only the bytes appended
+// since the previous one. Between runs the position is kept in a checkpoint
+// file: per path the inode, the bytes consumed and the resume offset of the
+// digit run in progress (cardid_scanner_resume_offset). On restart those few
+// bytes are re-read instead of persisting any digits.
+//
+// Rotation (rename + new file) is detected by the path's inode changing. The
+// new file is read from offset 0 while the renamed one stays open and is
+// drained on every poll until the new file receives data, so lines a writer
+// appends before reopening the path are not lost (offsets in reports are
+// relative to whichever file held the PAN). Only the current file of each path
+// is checkpointed. Truncation (copytruncate) is detected by the size dropping
+// below the consumed offset and restarts the scan at 0. A PAN is reported once
+// its digit run has ended, i.e. once the byte after it has been written.
+
+typedef struct cardid_follow cardid_follow;
+
+// Called for every PAN found; path is the followed path as given.
+typedef void (*cardid_follow_callback)(const char* path, const cardid_scan_match* match, void* ctx);
+
+typedef struct {
+  unsigned long long bytes;        // bytes read
+  unsigned long long matches;
+  unsigned long long rotations;    // path replaced by a new file
+  unsigned long long truncations;  // file shrank below the consumed offset
+} cardid_follow_stats;
+
+// Follow paths (which need not exist yet), resuming from checkpoint_path when
+// it names an existing checkpoint. Paths without a checkpoint entry start at
+// offset 0. Returns NULL on allocation failure or an unreadable checkpoint.
+cardid_follow* cardid_follow_open(const char* const* paths,
+                                  size_t count,
+                                  const char* checkpoint_path);
+
+// Read everything appended since the last poll on every path, handling rotation
+// and truncation, and report PANs through cb. stats (may be NULL) accumulates.
+cardid_status cardid_follow_poll(cardid_follow* f,
+                                 cardid_follow_callback cb,
+                                 void* ctx,
+                                 cardid_follow_stats* stats);
+
+// Block until a followed file or its directory changes (inotify on Linux) or
+// timeout_ms passes, whichever is first. Without inotify this just sleeps, so
+// the caller's poll loop degrades to interval polling.
+void cardid_follow_wait(cardid_follow* f, int timeout_ms);
+
+// Whether change notification is active (false: interval polling).
+bool cardid_follow_uses_inotify(const cardid_follow* f);
+
+// Atomically rewrite the checkpoint file given to cardid_follow_open.
+cardid_status cardid_follow_save(cardid_follow* f);
+
+// Close all files and wipe the scanners. Does not save.
+void cardid_follow_close(cardid_follow* f);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,84 @@
+#pragma once
+#include <stdint.h>
+#include "cardid.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Synthetic PAN corpus generation for load tests and benchmarks. PANs are drawn
+// from the same issuer prefix rules cardid_detect_network uses, so every
+// generated valid PAN is detected as the network it was generated for.
+
+typedef struct {
+  // Relative network mix, indexed by cardid_network (CARD_UNKNOWN is ignored).
+  // All zero selects an even mix.
+  double network_weight[CARD_DISCOVER + 1];
+  // Relative PAN length mix, indexed by length; lengths a network does not issue
+  // are skipped. All zero selects evenly among the network's lengths.
+  double length_weight[CARDID_MAX_DIGITS + 1];
+  double invalid_rate;    // fraction of PANs given a wrong check digit
+  double separator_rate;  // fraction printed in groups split by ' ' or '-'
+  double garbage_rate;    // fraction with 1-3 non-digit junk bytes injected
+  uint64_t seed;          // equal seeds give equal streams
+} cardid_gen_config;
+
+// Generator state; one per thread. Treat as opaque.
+typedef struct {
+  uint64_t rng[4];
+  double rule_cdf[16];
+  double length_weight[CARDID_MAX_DIGITS + 1];
+  double invalid_rate, separator_rate, garbage_rate;
+} cardid_gen;
+
+// Longest text cardid_gen_next can produce (separators and junk included).
+#define CARDID_GEN_MAX_TEXT 48
+
+// Returns CARDID_ERR_ARG for negative weights/rates or a mix with no issuable PAN.
+cardid_status cardid_gen_init(cardid_gen* gen, const cardid_gen_config* cfg);
+
+// Writes one PAN as text (not NUL-terminated) into out, which must hold
+// CARDID_GEN_MAX_TEXT bytes. Returns the number of bytes written.
+int cardid_gen_next(cardid_gen* gen, char* out);
+
+// Output framing for cardid_gen_fill.
+typedef enum {
+  CARDID_GEN_LINES = 0,  // one PAN per line, '\n' terminated
+  CARDID_GEN_BINARY,     // per PAN: one length byte, then that many text bytes
+} cardid_gen_format;
+
+// Fills buf with as many whole records as fit (at most max_records). Returns the
+// number of bytes written and stores the record count in *records.
+size_t cardid_gen_fill(cardid_gen* gen,
+                       cardid_gen_format format,
+                       char* buf,
+                       size_t cap,
+                       size_t max_records,
+                       size_t* records);
+
+// Sequential enumeration of every PAN of one length under a prefix range,
+// in ascending order, each with its correct check digit. The Luhn sum is kept
+// up to date as the account number increments, so each step is amortized O(1)
+// instead of a full Luhn pass.
+typedef struct {
+  char digits[CARDID_MAX_DIGITS + 1];  // current PAN (NUL-terminated)
+  int len;
+  int sum;             // Luhn contribution of the digits before the check digit
+  uint64_t remaining;  // PANs still to emit
+  bool started;
+} cardid_bin_enum;
+
+// Enumerate all len-digit PANs whose leading digits lie in [prefix_lo, prefix_hi]
+// (equal-length digit strings, e.g. "411111" and "411119").
+cardid_status cardid_bin_enum_init(cardid_bin_enum* e,
+                                   const char* prefix_lo,
+                                   const char* prefix_hi,
+                                   int len);
+
+// Next PAN, or NULL when the range is exhausted. The pointer stays valid until
+// the following call.
+const char* cardid_bin_enum_next(cardid_bin_enum* e);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,42 @@
+#pragma once
+#include <stdint.h>
+#include "cardid.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Opt-in analysis metrics. Each thread counts into its own cache-line-padded
+// slot; the slots are only summed when read. Collection is off until
+// cardid_metrics_enable(true), and the whole facility compiles away when the
+// library is built with -DCARDID_ENABLE_METRICS=OFF.
+
+typedef struct {
+  uint64_t outcome[CARDID_OUTCOME_COUNT];  // analyses by cardid_outcome
+  uint64_t network[CARD_DISCOVER + 1];     // valid analyses by network
+} cardid_metrics_snapshot;
+
+// True when the library was built with metrics support.
+bool cardid_metrics_available(void);
+
+// Start or stop counting. Counts already taken are kept.
+void cardid_metrics_enable(bool on);
+bool cardid_metrics_enabled(void);
+
+// Sum the per-thread counters (including those of exited threads).
+void cardid_metrics_read(cardid_metrics_snapshot* out);
+
+// Render every counter and the batch latency histograms in the Prometheus text
+// exposition format. Behaves like snprintf: writes at most cap bytes including
+// the NUL and returns the length the full output needs.
+//
+// Histogram samples are not alike across paths. analyze_batch and
+// tokenize_batch take one sample per call, covering analysis only.
+// record_stream takes one per read buffer of input (1 MiB, more for longer
+// records). That sample covers parsing, analysis and writing the annotated
+// records, so a slow consumer of the output (a full pipe) shows up in it.
+size_t cardid_metrics_format_prometheus(char* buf, size_t cap);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,60 @@
+#pragma once
+#include <stdio.h>
+#include "cardid.h"
+#include "cardid_results.h"
+#include "cardid_token.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Structured record ingestion: validate one column of a CSV/TSV file or one
+// top-level field of an NDJSON file and append the analysis as extra columns,
+// passing every other byte of the record through unchanged.
+
+typedef enum {
+  CARDID_RECORD_CSV = 0,
+  CARDID_RECORD_TSV,
+  CARDID_RECORD_NDJSON,
+} cardid_record_format;
+
+typedef struct {
+  cardid_record_format format;
+  char delimiter;           // CSV field separator; 0 selects ','. TSV always uses '\t'.
+  bool has_header;          // CSV/TSV: the first record holds column names
+  const char* column_name;  // CSV/TSV header name, or NDJSON field name (required there)
+  int column_index;         // CSV/TSV 0-based column, used when column_name is NULL
+  const cardid_token_key* token_key;  // if set, also append cardid_token (hex, "" if invalid)
+  cardid_results_writer* results;     // if set, also add a row per data record (input offset)
+} cardid_record_config;
+
+typedef struct {
+  unsigned long long records;  // data records seen (header and blank lines excluded)
+  unsigned long long valid;    // records whose field passed Luhn with a known network
+  unsigned long long missing;  // records that did not contain the selected field
+} cardid_record_stats;
+
+// Largest single record cardid_record_stream will buffer before giving up.
+#define CARDID_RECORD_MAX_BYTES (64u * 1024u * 1024u)
+
+// Locate the selected field inside one record (without its line terminator).
+// For CSV/TSV column_index selects the column; for NDJSON cfg->column_name is the
+// key. Quoted values are returned without their quotes. Returns false if absent.
+bool cardid_record_field(const cardid_record_config* cfg,
+                         int column_index,
+                         const char* record,
+                         size_t record_len,
+                         const char** field,
+                         size_t* field_len);
+
+// Stream records from in to out in bounded memory. CSV/TSV gain the columns
+// cardid_valid, cardid_network and cardid_length; NDJSON objects gain the keys of
+// the same name. stats may be NULL.
+cardid_status cardid_record_stream(FILE* in,
+                                   FILE* out,
+                                   const cardid_record_config* cfg,
+                                   cardid_record_stats* stats);
+
+#ifdef __cplusplus
+}
+#endif
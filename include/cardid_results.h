@@ -0,0 +1,105 @@
+#pragma once
+#include <stddef.h>
+#include <stdint.h>
+#include "cardid.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Columnar binary result files. A batch run writes one row per data record (its
+// byte offset in the input plus its cardid_result) into a file that readers mmap
+// and query without parsing: pulling "all AMEX" or "everything under BIN 411111"
+// touches only the index entries and the rows selected.
+//
+// Layout (host byte order, so the mapped columns are used as they are; readers
+// reject files of the other order; every section 64-byte aligned):
+//   header    magic "CARDIDRS", version, record count, column widths and the
+//             position of every section below
+//   offsets   input byte offset per record, 4 bytes each when every offset fits
+//             in 32 bits, else 8
+//   networks  one cardid_network byte per record
+//   valid     luhn_valid bitmap, bit i of 64-bit word i / 64
+//   lengths   digit count per record (cardid_result.length), one byte
+//   footer    network directory: per network present, its record count and a
+//             slice of the range table; range table: [start, end) runs of
+//             consecutive records sharing a network, grouped by network
+//             BIN directory: sorted 6-digit BINs, each with a slice of the
+//             posting table; postings: record numbers ascending within a BIN
+//             (4 bytes each below 2^32 records, else 8)
+//
+// Only the leading six digits of PANs that passed validation are stored, in
+// the BIN index; the file never holds a full PAN.
+
+typedef struct cardid_results_writer cardid_results_writer;
+typedef struct cardid_results cardid_results;
+
+// Creates path.tmp at once, so an unwritable path fails here (CARDID_ERR_IO,
+// errno set) rather than after the input has been read. Rows are spilled in
+// blocks to per-column files beside it, so memory stays fixed (about 9 MB, plus
+// up to 32 MB while closing) whatever the record count; needs about 14 bytes per
+// record of disk until close. cardid_results_writer_close renames path.tmp to
+// path, so readers never see a partial file.
+cardid_status cardid_results_writer_open(const char* path, cardid_results_writer** out);
+
+// Append the next record. digits are the extracted digits of a PAN that passed
+// validation, used for the BIN index, or NULL for records that did not.
+cardid_status cardid_results_writer_add(cardid_results_writer* w,
+                                        uint64_t offset,
+                                        const cardid_result* res,
+                                        const char* digits);
+
+// Build the indexes, write and rename the file, and free the writer. Returns the
+// first error from an earlier add, if any, and leaves no file behind on failure.
+cardid_status cardid_results_writer_close(cardid_results_writer* w);
+
+// Free the writer without writing anything (e.g. the input failed midway).
+void cardid_results_writer_discard(cardid_results_writer* w);
+
+// Map path read-only. CARDID_ERR_FORMAT when the file is not a result file or a
+// section points outside it.
+cardid_status cardid_results_open(const char* path, cardid_results** out);
+void cardid_results_close(cardid_results* r);
+
+uint64_t cardid_results_count(const cardid_results* r);
+
+typedef struct {
+  uint64_t record;  // 0-based data record number (header and blank lines excluded)
+  uint64_t offset;  // byte offset of the record in the input
+  cardid_result result;
+} cardid_results_row;
+
+// Row i, or false when i is out of range.
+bool cardid_results_get(const cardid_results* r, uint64_t i, cardid_results_row* row);
+
+// Records with this network (whatever their Luhn result).
+uint64_t cardid_results_network_count(const cardid_results* r, cardid_network network);
+
+typedef struct {
+  bool by_network;
+  cardid_network network;
+  bool by_bin;             // only validated PANs whose BIN lies in [bin_lo, bin_hi]
+  uint32_t bin_lo, bin_hi; // 6-digit BINs; a shorter prefix P is [P*10^k, (P+1)*10^k - 1]
+  bool valid_only;         // only records with luhn_valid set
+} cardid_results_filter;
+
+// Iteration cursor; fields are private.
+typedef struct {
+  const cardid_results* r;
+  cardid_results_filter f;
+  uint64_t a, b, c;
+} cardid_results_iter;
+
+// Start iterating rows matching f (NULL: every row). With by_bin rows come in
+// BIN order and record order within a BIN, driven by the BIN index; otherwise
+// in record order, driven by the network ranges when by_network is set.
+void cardid_results_iter_init(cardid_results_iter* it,
+                              const cardid_results* r,
+                              const cardid_results_filter* f);
+
+// Next matching row, or false when there are no more.
+bool cardid_results_next(cardid_results_iter* it, cardid_results_row* row);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,68 @@
+#pragma once
+#include <stddef.h>
+#include <stdint.h>
+#include "cardid.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Streaming PAN discovery in free text. Bytes are fed in arbitrary chunks; a
+// candidate is a run of digits in which single ' ' or '-' separators may split
+// the digits into groups ("4111 1111-1111 1111"). Every stretch of whole groups
+// holding 13-19 digits that passes Luhn and matches a known network is reported
+// once, longest first, without overlapping an earlier report. Runs glued to a
+// letter or digit on either side (hex strings, identifiers) are not reported.
+// Candidates split across chunk boundaries are found exactly as if the stream
+// had been fed in one piece.
+
+typedef struct {
+  uint64_t offset;         // stream offset of the first digit
+  uint32_t span;           // bytes from the first to the last digit, separators included
+  int length;              // digits in the PAN
+  cardid_network network;  // never CARD_UNKNOWN
+} cardid_scan_match;
+
+typedef void (*cardid_scan_callback)(const cardid_scan_match* match, void* ctx);
+
+// Scanner state. Holds at most a few dozen digits of the run in progress;
+// cardid_scanner_finish wipes them. Treat as opaque.
+typedef struct {
+  uint64_t pos;      // stream offset of the next byte to be fed
+  uint64_t claimed;  // offset just past the last reported PAN
+  char digits[2 * CARDID_MAX_DIGITS + 2];
+  int ndigits;
+  int ngroups;
+  uint64_t group_start[CARDID_MAX_DIGITS + 1];
+  uint64_t group_end[CARDID_MAX_DIGITS + 1];
+  uint8_t group_digits[CARDID_MAX_DIGITS + 1];
+  bool in_run;
+  bool sep_pending;
+  bool overlong;     // current group exceeds CARDID_MAX_DIGITS
+  bool lead_blocked; // the run started right after a letter or digit
+  bool first_is_run_start;
+  unsigned char prev;
+} cardid_scanner;
+
+// Start a scan at stream offset start (0 for a whole stream).
+void cardid_scanner_init(cardid_scanner* s, uint64_t start);
+
+// Scan the next len bytes of the stream, invoking cb for each PAN found.
+void cardid_scanner_feed(cardid_scanner* s,
+                         const char* buf,
+                         size_t len,
+                         cardid_scan_callback cb,
+                         void* ctx);
+
+// End of stream: report a PAN still open at the end, then wipe the state.
+void cardid_scanner_finish(cardid_scanner* s, cardid_scan_callback cb, void* ctx);
+
+// Offset from which a fresh scanner (cardid_scanner_init at that offset, fed
+// from there) reports exactly the PANs this one has yet to report: the byte
+// before the oldest digit group that can still start a PAN, or before pos when
+// no run is open. Lets callers persist a resume point instead of digits.
+uint64_t cardid_scanner_resume_offset(const cardid_scanner* s);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,41 @@
+#pragma once
+#include <stddef.h>
+#include "cardid.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Per-thread scratch arena for sensitive digit buffers. The arena is one
+// page-backed region per thread that is, where the OS allows, locked in RAM
+// (mlock) and excluded from core dumps (MADV_DONTDUMP). Batch entry points
+// take their digit buffers from it and wipe what they used once per batch
+// instead of once per record. The region is wiped and unmapped at thread exit.
+
+typedef struct cardid_scratch cardid_scratch;
+
+#define CARDID_SCRATCH_BYTES (64u * 1024u)
+
+// The calling thread's arena, created on first use; NULL if it cannot be mapped.
+cardid_scratch* cardid_scratch_thread(void);
+
+// Bump-allocate n bytes (16-byte aligned) or return NULL when the arena is full.
+void* cardid_scratch_alloc(cardid_scratch* s, size_t n);
+
+// Position to hand back to cardid_scratch_release.
+size_t cardid_scratch_mark(const cardid_scratch* s);
+
+// Wipe everything allocated since mark with cardid_secure_zero and rewind to it.
+void cardid_scratch_release(cardid_scratch* s, size_t mark);
+
+// Whether the arena pages are locked in RAM / excluded from core dumps. Locking
+// fails silently when RLIMIT_MEMLOCK is too low; the arena still works.
+bool cardid_scratch_locked(const cardid_scratch* s);
+bool cardid_scratch_dontdump(const cardid_scratch* s);
+
+// memset(p, 0, n) that the compiler may not remove as a dead store.
+void cardid_secure_zero(void* p, size_t n);
+
+#ifdef __cplusplus
+}
+#endif
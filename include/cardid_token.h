@@ -0,0 +1,48 @@
+#pragma once
+#include <stdint.h>
+#include "cardid.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Keyed deterministic PAN tokenization. The same key and PAN always give the
+// same token, so tokens can be joined on downstream without exposing the PAN.
+// Tokens are one-way surrogates (SipHash-2-4 PRF), not encryption: keep the key
+// secret and rotate it like any other MAC key.
+
+typedef struct {
+  uint64_t k0, k1;  // 128-bit SipHash key
+} cardid_token_key;
+
+// Numeric value of a digit string of up to 19 digits (fits in 64 bits).
+uint64_t cardid_pack_digits(const char* digits, int len);
+
+// Reference SipHash-2-4 over an arbitrary byte string.
+uint64_t cardid_siphash24(const cardid_token_key* key, const void* data, size_t len);
+
+// 64-bit token of a clean digit string: SipHash-2-4 of the 16 bytes
+// LE64(cardid_pack_digits(digits, len)) || LE64(len). Including the length keeps
+// PANs that differ only in leading zeros apart.
+uint64_t cardid_token64(const cardid_token_key* key, const char* digits, int len);
+
+// Format-preserving surrogate of a 13-19 digit PAN: keeps the first 6 (BIN) and
+// last 4 digits and replaces the middle with a keyed permutation of it, so
+// distinct PANs always get distinct tokens. The result always fails Luhn, so it
+// can never be mistaken for a live card. out needs len + 1 bytes. Returns false
+// for lengths outside 13-19, non-digit input, or input that fails Luhn (which
+// includes these tokens themselves).
+bool cardid_token_fpt(const cardid_token_key* key, const char* digits, int len, char* out);
+
+// Validate and tokenize in one pass: results[i] as cardid_analyze(inputs[i]),
+// tokens[i] = cardid_token64 of the extracted digits for valid PANs (Luhn valid,
+// known network) and 0 otherwise. Hashes several PANs per pass across SIMD lanes.
+void cardid_analyze_tokenize_batch(const cardid_token_key* key,
+                                   const char* const* inputs,
+                                   size_t count,
+                                   cardid_result* results,
+                                   uint64_t* tokens);
+
+#ifdef __cplusplus
+}
+#endif
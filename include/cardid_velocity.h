@@ -0,0 +1,77 @@
+#pragma once
+#include <stddef.h>
+#include <stdint.h>
+#include "cardid.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Approximate "times this PAN was seen in the last N minutes" for fraud rules.
+// Time is cut into slices of slice_ns; the tracker keeps a ring of count-min
+// sketches, one per slice, in memory fixed at creation. Adds are a handful of
+// relaxed atomic increments, so any number of threads can share one tracker;
+// a query sums the slices in the window per row and takes the row minimum.
+//
+// Count-min guarantees, per query: the estimate is never below the true count,
+// and with probability at least 1 - delta it exceeds it by at most
+// epsilon * (events in the window), where epsilon = e / width and
+// delta = e^-depth. The tracker never stores PANs, only hashed counters.
+//
+// A window covers whole slices: the current one and the window_ns / slice_ns
+// (rounded up) - 1 before it, at most slices - 1 in total (one slot is kept
+// cleared ahead of time so advancing the clock never races with writers).
+// Events older than the ring are dropped.
+
+typedef struct cardid_velocity cardid_velocity;
+
+#define CARDID_VELOCITY_MAX_DEPTH 8
+
+typedef struct {
+  uint32_t width;     // counters per row, rounded up to a power of two; 0 selects 65536
+  uint32_t depth;     // rows (independent hashes), 1..CARDID_VELOCITY_MAX_DEPTH; 0 selects 4
+  uint32_t slices;    // ring length, at least 2; 0 selects 61 (an hour of minutes)
+  uint64_t slice_ns;  // slice duration; 0 selects one minute
+  uint64_t seed;      // hash seed; vary it to decorrelate trackers
+} cardid_velocity_config;
+
+// NULL on bad config or allocation failure, and when built without C11 atomics.
+cardid_velocity* cardid_velocity_create(const cardid_velocity_config* cfg);
+void cardid_velocity_destroy(cardid_velocity* v);
+
+// Bytes allocated for counters and slice headers.
+size_t cardid_velocity_memory(const cardid_velocity* v);
+
+// epsilon = e / width and delta = e^-depth for this tracker (see above).
+void cardid_velocity_bounds(const cardid_velocity* v, double* epsilon, double* delta);
+
+// Key for a validated PAN: an invertible 64-bit mix of its digits and length,
+// so distinct digit strings (including ones differing only in leading zeros)
+// never share a key. Being invertible, a key is as sensitive as the PAN.
+uint64_t cardid_velocity_key(const char* digits, int len);
+
+// Count one event for key at time now_ns (any monotonic or event clock).
+void cardid_velocity_add(cardid_velocity* v, uint64_t key, uint64_t now_ns);
+
+// Estimated events for key in the window ending at now_ns.
+uint64_t cardid_velocity_count(const cardid_velocity* v,
+                               uint64_t key,
+                               uint64_t window_ns,
+                               uint64_t now_ns);
+
+// Total events in the window (sums one sketch row; O(width) per slice). Multiply
+// by epsilon for the additive error bound of a count over the same window.
+uint64_t cardid_velocity_total(const cardid_velocity* v, uint64_t window_ns, uint64_t now_ns);
+
+// Analyze input and, if it is a valid PAN, count it and return its windowed
+// count including this event; returns 0 for invalid input. out may be NULL.
+uint64_t cardid_velocity_observe(cardid_velocity* v,
+                                 const char* input,
+                                 size_t input_len,
+                                 uint64_t now_ns,
+                                 uint64_t window_ns,
+                                 cardid_result* out);
+
+#ifdef __cplusplus
+}
+#endif
@@ -1,8 +1,30 @@
 #include "cardid.h"
 #include <ctype.h>
 #include <string.h>
+#include "cardid_internal.h"
+#include "cardid_probes.h"
 
-bool cardid_luhn_digits(const char* d, int n) {
+#ifdef CARDID_HAVE_USDT
+CARDID_PROBE_SEMAPHORE_DEFINE(analyze__entry);
+CARDID_PROBE_SEMAPHORE_DEFINE(analyze__return);
+CARDID_PROBE_SEMAPHORE_DEFINE(reject);
+CARDID_PROBE_SEMAPHORE_DEFINE(extract__entry);
+CARDID_PROBE_SEMAPHORE_DEFINE(extract__return);
+CARDID_PROBE_SEMAPHORE_DEFINE(luhn__entry);
+CARDID_PROBE_SEMAPHORE_DEFINE(luhn__return);
+CARDID_PROBE_SEMAPHORE_DEFINE(detect__entry);
+CARDID_PROBE_SEMAPHORE_DEFINE(detect__return);
+#endif
+
+bool cardid_probes_available(void) {
+#ifdef CARDID_HAVE_USDT
+    return true;
+#else
+    return false;
+#endif
+}
+
+static inline bool luhn_core(const char* d, int n) {
     int sum = 0, pos = 0;
     for (int i = n - 1; i >= 0; --i, ++pos) {
         int v = d[i] - '0';
@@ -13,6 +35,13 @@ bool cardid_luhn_digits(const char* d, int n) {
     return (sum % 10) == 0;
 }
 
+bool cardid_luhn_digits(const char* d, int n) {
+    CARDID_PROBE1(luhn__entry, n);
+    bool valid = luhn_core(d, n);
+    CARDID_PROBE2(luhn__return, n, valid);
+    return valid;
+}
+
 static int prefix_n(const char* s, int n, int total_len) {
     if (total_len < n) return -1;
     int v = 0;
@@ -25,20 +54,37 @@ static int len_in(int len, const int* lens, int count) {
     return 0;
 }
 
+const char* cardid_network_name(cardid_network network) {
+    switch (network) {
+        case CARD_VISA: return "VISA";
+        case CARD_MASTERCARD: return "MASTERCARD";
+        case CARD_AMEX: return "AMEX";
+        case CARD_DISCOVER: return "DISCOVER";
+        default: return "UNKNOWN";
+    }
+}
+
 cardid_extract_result cardid_extract_digits(const char* input, char* out_digits, int out_capacity) {
+    return cardid_extract_digits_n(input, input ? strlen(input) : 0, out_digits, out_capacity);
+}
+
+cardid_extract_result cardid_extract_digits_n(const char* input, size_t input_len,
+                                              char* out_digits, int out_capacity) {
     int idx = 0;
     bool found_non_digit = false, overflowed = false;
+    CARDID_PROBE1(extract__entry, input_len);
     
     // Security: Validate input parameters
     if (!input || !out_digits || out_capacity <= 0) {
         cardid_extract_result r = {0, true, true};
+        CARDID_PROBE3(extract__return, 0, true, true);
         return r;
     }
     
-    // Security: Initialize output buffer to prevent information leakage
-    memset(out_digits, 0, out_capacity);
-    
-    for (int i = 0; input[i] != '\0'; ++i) {
+    // Only digits and the terminator are written; callers holding PANs wipe
+    // their buffers themselves (cardid_secure_zero / cardid_scratch_release).
+
+    for (size_t i = 0; i < input_len; ++i) {
         unsigned char c = (unsigned char)input[i];
         
         // Security: Prevent buffer overflow
@@ -56,82 +102,140 @@ cardid_extract_result cardid_extract_digits(const char* input, char* out_digits,
     out_digits[idx] = '\0';
     
     cardid_extract_result r = { idx, found_non_digit, overflowed };
+    CARDID_PROBE3(extract__return, idx, found_non_digit, overflowed);
     return r;
 }
 
-cardid_network cardid_detect_network(const char* s, int len) {
-    // American Express: 34/37, length 15
-    if (len == 15) {
-        int p2 = prefix_n(s, 2, len);
-        if (p2 == 34 || p2 == 37) return CARD_AMEX;
-    }
+#define LEN(n) (1u << (n))
 
+// Issuer prefix rules, checked in order. The corpus generator draws from the
+// same table, so generated PANs always match what detection accepts.
+const cardid_network_rule cardid_network_rules[] = {
+    // American Express: 34/37, length 15
+    {CARD_AMEX, 2, 34, 34, LEN(15)},
+    {CARD_AMEX, 2, 37, 37, LEN(15)},
     // Visa: prefix 4, lengths 13,16,19
-    if (len == 13 || len == 16 || len == 19) {
-        int p1 = prefix_n(s, 1, len);
-        if (p1 == 4) return CARD_VISA;
-    }
-
+    {CARD_VISA, 1, 4, 4, LEN(13) | LEN(16) | LEN(19)},
     // Mastercard: 51–55 or 2221–2720; length 16
-    if (len == 16) {
-        int p2 = prefix_n(s, 2, len);
-        if (p2 >= 51 && p2 <= 55) return CARD_MASTERCARD;
-        int p4 = prefix_n(s, 4, len);
-        if (p4 >= 2221 && p4 <= 2720) return CARD_MASTERCARD;
-    }
-
+    {CARD_MASTERCARD, 2, 51, 55, LEN(16)},
+    {CARD_MASTERCARD, 4, 2221, 2720, LEN(16)},
     // Discover: 6011, 622126–622925, 644–649, 65; lengths 16 or 19
-    if (len == 16 || len == 19) {
-        int p2 = prefix_n(s, 2, len);
-        int p3 = prefix_n(s, 3, len);
-        int p4 = prefix_n(s, 4, len);
-        int p6 = prefix_n(s, 6, len);
-        if (p4 == 6011) return CARD_DISCOVER;
-        if (p2 == 65) return CARD_DISCOVER;
-        if (p3 >= 644 && p3 <= 649) return CARD_DISCOVER;
-        if (p6 >= 622126 && p6 <= 622925) return CARD_DISCOVER;
-    }
+    {CARD_DISCOVER, 4, 6011, 6011, LEN(16) | LEN(19)},
+    {CARD_DISCOVER, 2, 65, 65, LEN(16) | LEN(19)},
+    {CARD_DISCOVER, 3, 644, 649, LEN(16) | LEN(19)},
+    {CARD_DISCOVER, 6, 622126, 622925, LEN(16) | LEN(19)},
+};
+const int cardid_network_rule_count =
+    (int)(sizeof(cardid_network_rules) / sizeof(cardid_network_rules[0]));
 
+static inline cardid_network detect_core(const char* s, int len) {
+    if (len <= 0 || len > CARDID_MAX_DIGITS) return CARD_UNKNOWN;
+    for (int i = 0; i < cardid_network_rule_count; ++i) {
+        const cardid_network_rule* r = &cardid_network_rules[i];
+        if (!(r->lengths & LEN(len))) continue;
+        int p = prefix_n(s, r->prefix_len, len);
+        if (p >= r->lo && p <= r->hi) return r->network;
+    }
     return CARD_UNKNOWN;
 }
 
+cardid_network cardid_detect_network(const char* s, int len) {
+    CARDID_PROBE1(detect__entry, len);
+    cardid_network network = detect_core(s, len);
+    CARDID_PROBE2(detect__return, len, network);
+    return network;
+}
+
 void cardid_analyze(const char* input, cardid_result* out, cardid_extract_result* extract_meta) {
-    // Security: Validate input parameters
-    if (!input || !out) {
-        if (out) {
-            out->length = 0;
-            out->luhn_valid = false;
-            out->network = CARD_UNKNOWN;
-        }
-        return;
-    }
-    
-    char digits[ CARDID_MAX_DIGITS + 1 ];
-    cardid_extract_result r = cardid_extract_digits(input, digits, (int)sizeof(digits));
+    cardid_analyze_n(input, input ? strlen(input) : 0, out, extract_meta);
+}
+
+// Runs the analysis pipeline and reports which check decided the result.
+static cardid_outcome analyze_core(const char* input, size_t input_len, cardid_result* out,
+                                   cardid_extract_result* extract_meta, char* digits) {
+    cardid_extract_result r = cardid_extract_digits_n(input, input_len, digits, CARDID_MAX_DIGITS + 1);
     if (extract_meta) *extract_meta = r;
 
     out->length = r.digit_count;
-    if (r.digit_count == 0 || r.overflowed) {
-        out->luhn_valid = false;
-        out->network = CARD_UNKNOWN;
-        return;
+    out->luhn_valid = false;
+    out->network = CARD_UNKNOWN;
+    if (r.overflowed) {
+        CARDID_PROBE2(reject, CARDID_OUTCOME_OVERFLOW, r.digit_count);
+        return CARDID_OUTCOME_OVERFLOW;
+    }
+    if (r.digit_count == 0) {
+        CARDID_PROBE2(reject, CARDID_OUTCOME_EMPTY, 0);
+        return CARDID_OUTCOME_EMPTY;
     }
 
     // Security: Validate length bounds
     if (r.digit_count < 13 || r.digit_count > 19) {
-        out->luhn_valid = false;
-        out->network = CARD_UNKNOWN;
-        return;
+        CARDID_PROBE2(reject, CARDID_OUTCOME_BAD_LENGTH, r.digit_count);
+        return CARDID_OUTCOME_BAD_LENGTH;
     }
 
     // Quick length filter: allow only common lengths 13,15,16,19
     static const int allowed[] = {13, 15, 16, 19};
     if (!len_in(r.digit_count, allowed, 4)) {
-        out->luhn_valid = false;
-        out->network = CARD_UNKNOWN;
-        return;
+        CARDID_PROBE2(reject, CARDID_OUTCOME_LENGTH_FILTERED, r.digit_count);
+        return CARDID_OUTCOME_LENGTH_FILTERED;
     }
 
     out->luhn_valid = cardid_luhn_digits(digits, r.digit_count);
-    out->network = out->luhn_valid ? cardid_detect_network(digits, r.digit_count) : CARD_UNKNOWN;
+    if (!out->luhn_valid) {
+        CARDID_PROBE2(reject, CARDID_OUTCOME_LUHN_FAIL, r.digit_count);
+        return CARDID_OUTCOME_LUHN_FAIL;
+    }
+    out->network = cardid_detect_network(digits, r.digit_count);
+    if (out->network == CARD_UNKNOWN) {
+        CARDID_PROBE2(reject, CARDID_OUTCOME_UNKNOWN_NETWORK, r.digit_count);
+        return CARDID_OUTCOME_UNKNOWN_NETWORK;
+    }
+    return CARDID_OUTCOME_VALID;
+}
+
+cardid_outcome cardid_analyze_into(const char* input, size_t input_len, cardid_result* out,
+                                   cardid_extract_result* extract_meta, char* digits) {
+    CARDID_PROBE1(analyze__entry, input_len);
+    // Reading the clock is the only costly probe argument: skip it unless traced.
+    uint64_t t0 = CARDID_PROBE_ENABLED(analyze__return) ? cardid_now_ns() : 0;
+    cardid_outcome outcome = analyze_core(input, input_len, out, extract_meta, digits);
+    CARDID_METRICS_OUTCOME(outcome, out->network);
+    CARDID_PROBE4(analyze__return, out->length, out->network, outcome,
+                  t0 ? cardid_now_ns() - t0 : 0);
+    (void)t0;
+    return outcome;
+}
+
+void cardid_analyze_n(const char* input, size_t input_len, cardid_result* out,
+                      cardid_extract_result* extract_meta) {
+    // Security: Validate input parameters
+    if (!input || !out) {
+        if (out) {
+            out->length = 0;
+            out->luhn_valid = false;
+            out->network = CARD_UNKNOWN;
+        }
+        return;
+    }
+
+    char digits[ CARDID_MAX_DIGITS + 1 ];
+    cardid_analyze_into(input, input_len, out, extract_meta, digits);
+    cardid_secure_zero(digits, sizeof(digits));
+}
+
+void cardid_analyze_batch(const char* const* inputs, size_t count, cardid_result* out) {
+    if (!inputs || !out) return;
+    CARDID_METRICS_BATCH_START(t0);
+    cardid_digit_scratch scratch;
+    cardid_digit_scratch_begin(&scratch);
+    for (size_t i = 0; i < count; ++i) {
+        if (inputs[i]) {
+            cardid_analyze_into(inputs[i], strlen(inputs[i]), &out[i], NULL, scratch.digits);
+        } else {
+            cardid_analyze_n(NULL, 0, &out[i], NULL);
+        }
+    }
+    cardid_digit_scratch_end(&scratch);
+    CARDID_METRICS_BATCH_END(CARDID_PATH_ANALYZE_BATCH, t0);
 }
@@ -0,0 +1,734 @@
+#if !defined(_WIN32) && !defined(_GNU_SOURCE)
+#define _GNU_SOURCE  // _SC_NPROCESSORS_ONLN
+#endif
+#include "cardid_archive.h"
+#include <limits.h>
+#include <stdlib.h>
+#include <string.h>
+#include "cardid_internal.h"
+#ifdef CARDID_HAVE_ZLIB
+#define ZLIB_CONST
+#include <zlib.h>
+#endif
+#ifdef CARDID_HAVE_ZSTD
+#include <zstd.h>
+#endif
+#ifndef _WIN32
+#include <pthread.h>
+#include <unistd.h>
+#endif
+
+#define CHUNK (256u * 1024u)         // decode buffer of the sequential paths
+#define GROUP_MIN (16u * 1024u)      // compressed bytes per parallel work item:
+#define GROUP_MAX (1u << 20)         // about four per thread, within these bounds
+#define PLAIN_FACTOR 4               // plain input: same, times this
+#define MAX_THREADS 256
+
+cardid_archive_format cardid_archive_detect(const void* head, size_t len) {
+    const unsigned char* p = head;
+    if (!p) return CARDID_ARCHIVE_PLAIN;
+    if (len >= 3 && p[0] == 0x1f && p[1] == 0x8b && p[2] == 8) return CARDID_ARCHIVE_GZIP;
+    if (len >= 4 && p[0] == 0x28 && p[1] == 0xb5 && p[2] == 0x2f && p[3] == 0xfd) {
+        return CARDID_ARCHIVE_ZSTD;
+    }
+    return CARDID_ARCHIVE_PLAIN;
+}
+
+bool cardid_archive_supported(cardid_archive_format format) {
+    switch (format) {
+        case CARDID_ARCHIVE_PLAIN:
+            return true;
+        case CARDID_ARCHIVE_GZIP:
+#ifdef CARDID_HAVE_ZLIB
+            return true;
+#else
+            return false;
+#endif
+        case CARDID_ARCHIVE_ZSTD:
+#ifdef CARDID_HAVE_ZSTD
+            return true;
+#else
+            return false;
+#endif
+    }
+    return false;
+}
+
+const char* cardid_archive_format_name(cardid_archive_format format) {
+    switch (format) {
+        case CARDID_ARCHIVE_PLAIN: return "plain";
+        case CARDID_ARCHIVE_GZIP: return "gzip";
+        case CARDID_ARCHIVE_ZSTD: return "zstd";
+    }
+    return "unknown";
+}
+
+// Bytes after which scanner state no longer depends on what came before: the
+// run in progress (if any) ends and only this byte is remembered.
+static bool is_sync(unsigned char c) {
+    return (unsigned char)(c - '0') > 9 && c != ' ' && c != '-';
+}
+
+// ---------------------------------------------------------------------------
+// Decoders: one gzip member / zstd frame after another, or a plain copy.
+
+typedef struct {
+    cardid_archive_format format;
+    bool open;  // inside a member or frame that has not ended yet
+#ifdef CARDID_HAVE_ZLIB
+    z_stream z;
+    bool z_ready;
+#endif
+#ifdef CARDID_HAVE_ZSTD
+    ZSTD_DStream* zs;
+#endif
+} decoder;
+
+static cardid_status decoder_init(decoder* d, cardid_archive_format format) {
+    memset(d, 0, sizeof(*d));
+    d->format = format;
+    if (!cardid_archive_supported(format)) return CARDID_ERR_ARG;
+#ifdef CARDID_HAVE_ZLIB
+    if (format == CARDID_ARCHIVE_GZIP) {
+        if (inflateInit2(&d->z, 16 + MAX_WBITS) != Z_OK) return CARDID_ERR_NOMEM;
+        d->z_ready = true;
+    }
+#endif
+#ifdef CARDID_HAVE_ZSTD
+    if (format == CARDID_ARCHIVE_ZSTD) {
+        d->zs = ZSTD_createDStream();
+        if (!d->zs || ZSTD_isError(ZSTD_initDStream(d->zs))) return CARDID_ERR_NOMEM;
+    }
+#endif
+    return CARDID_OK;
+}
+
+static void decoder_reset(decoder* d) {
+    d->open = false;
+#ifdef CARDID_HAVE_ZLIB
+    if (d->z_ready) inflateReset(&d->z);
+#endif
+#ifdef CARDID_HAVE_ZSTD
+    if (d->zs) ZSTD_initDStream(d->zs);
+#endif
+}
+
+static void decoder_free(decoder* d) {
+#ifdef CARDID_HAVE_ZLIB
+    if (d->z_ready) inflateEnd(&d->z);
+#endif
+#ifdef CARDID_HAVE_ZSTD
+    ZSTD_freeDStream(d->zs);
+#endif
+    memset(d, 0, sizeof(*d));
+}
+
+// Decode from *in (advanced past what was consumed) into out until out is
+// full or the input runs dry. *produced < cap means more input is needed.
+static cardid_status decoder_step(decoder* d, const unsigned char** in, size_t* in_len,
+                                  unsigned char* out, size_t cap, size_t* produced) {
+    *produced = 0;
+    if (d->format == CARDID_ARCHIVE_PLAIN) {
+        size_t n = *in_len < cap ? *in_len : cap;
+        memcpy(out, *in, n);
+        *in += n;
+        *in_len -= n;
+        *produced = n;
+        return CARDID_OK;
+    }
+#ifdef CARDID_HAVE_ZLIB
+    if (d->format == CARDID_ARCHIVE_GZIP) {
+        z_stream* z = &d->z;
+        uInt out_cap = cap > UINT_MAX ? UINT_MAX : (uInt)cap;
+        z->next_out = out;
+        z->avail_out = out_cap;
+        while (z->avail_out > 0 && (*in_len > 0 || d->open)) {
+            uInt in_cap = *in_len > UINT_MAX ? UINT_MAX : (uInt)*in_len;
+            z->next_in = *in;
+            z->avail_in = in_cap;
+            int rc = inflate(z, Z_NO_FLUSH);
+            size_t used = in_cap - z->avail_in;
+            *in += used;
+            *in_len -= used;
+            if (used) d->open = true;
+            if (rc == Z_STREAM_END) {
+                // Concatenated members (gzip -c a >> f, bgzip) form one stream.
+                d->open = false;
+                inflateReset(z);
+            } else if (rc == Z_BUF_ERROR) {
+                break;  // no progress possible without more input
+            } else if (rc == Z_MEM_ERROR) {
+                return CARDID_ERR_NOMEM;
+            } else if (rc != Z_OK) {
+                return CARDID_ERR_FORMAT;
+            }
+        }
+        *produced = out_cap - z->avail_out;
+        return CARDID_OK;
+    }
+#endif
+#ifdef CARDID_HAVE_ZSTD
+    if (d->format == CARDID_ARCHIVE_ZSTD) {
+        ZSTD_inBuffer ib = {*in, *in_len, 0};
+        ZSTD_outBuffer ob = {out, cap, 0};
+        while (ob.pos < ob.size && (ib.pos < ib.size || d->open)) {
+            size_t in_before = ib.pos, out_before = ob.pos;
+            size_t hint = ZSTD_decompressStream(d->zs, &ob, &ib);
+            if (ZSTD_isError(hint)) return CARDID_ERR_FORMAT;
+            d->open = hint != 0;  // 0: frame complete and fully flushed
+            if (ib.pos == in_before && ob.pos == out_before) break;
+        }
+        *in += ib.pos;
+        *in_len -= ib.pos;
+        *produced = ob.pos;
+        return CARDID_OK;
+    }
+#endif
+    return CARDID_ERR_ARG;
+}
+
+// Called once the input is exhausted and drained: a member or frame still
+// open means the data was cut short.
+static cardid_status decoder_end(const decoder* d) {
+    return d->open ? CARDID_ERR_FORMAT : CARDID_OK;
+}
+
+// ---------------------------------------------------------------------------
+// Sequential paths
+
+typedef struct {
+    cardid_scan_callback cb;
+    void* ctx;
+    unsigned long long matches;
+} emitter;
+
+static void emit(const cardid_scan_match* m, void* arg) {
+    emitter* e = arg;
+    e->matches++;
+    e->cb(m, e->ctx);
+}
+
+// Decode everything in [in, in + len) through s; *bytes counts the output.
+static cardid_status decode_into_scanner(decoder* d, const unsigned char* in, size_t len,
+                                         unsigned char* buf, cardid_scanner* s, emitter* e,
+                                         unsigned long long* bytes) {
+    for (;;) {
+        size_t left = len, got;
+        cardid_status st = decoder_step(d, &in, &len, buf, CHUNK, &got);
+        if (st != CARDID_OK) return st;
+        cardid_scanner_feed(s, (const char*)buf, got, emit, e);
+        *bytes += got;
+        if (got < CHUNK && len == 0) return CARDID_OK;
+        if (got == 0 && len == left) return CARDID_ERR_FORMAT;  // stuck: trailing garbage
+    }
+}
+
+static cardid_status scan_sequential(const unsigned char* data, size_t len,
+                                     cardid_archive_format format, emitter* e,
+                                     cardid_archive_stats* stats) {
+    cardid_scanner s;
+    cardid_scanner_init(&s, 0);
+    if (format == CARDID_ARCHIVE_PLAIN) {
+        cardid_scanner_feed(&s, (const char*)data, len, emit, e);
+        cardid_scanner_finish(&s, emit, e);
+        stats->bytes = len;
+        return CARDID_OK;
+    }
+    decoder d;
+    unsigned char* buf = malloc(CHUNK);
+    cardid_status st = decoder_init(&d, format);
+    if (st == CARDID_OK && !buf) st = CARDID_ERR_NOMEM;
+    if (st == CARDID_OK) st = decode_into_scanner(&d, data, len, buf, &s, e, &stats->bytes);
+    if (st == CARDID_OK) st = decoder_end(&d);
+    if (st == CARDID_OK) cardid_scanner_finish(&s, emit, e);
+    cardid_secure_zero(&s, sizeof(s));
+    if (buf) {
+        cardid_secure_zero(buf, CHUNK);
+        free(buf);
+    }
+    decoder_free(&d);
+    return st;
+}
+
+cardid_status cardid_archive_scan_stream(FILE* in, cardid_scan_callback cb, void* ctx,
+                                         cardid_archive_stats* stats) {
+    cardid_archive_stats local;
+    if (!stats) stats = &local;
+    memset(stats, 0, sizeof(*stats));
+    if (!in || !cb) return CARDID_ERR_ARG;
+    stats->threads = 1;
+
+    unsigned char* inbuf = malloc(CHUNK);
+    unsigned char* outbuf = malloc(CHUNK);
+    emitter e = {cb, ctx, 0};
+    cardid_scanner s;
+    cardid_scanner_init(&s, 0);
+    decoder d;
+    memset(&d, 0, sizeof(d));
+    bool first = true;
+    cardid_status st = inbuf && outbuf ? CARDID_OK : CARDID_ERR_NOMEM;
+    while (st == CARDID_OK) {
+        size_t n = fread(inbuf, 1, CHUNK, in);
+        if (n == 0) {
+            if (ferror(in)) st = CARDID_ERR_IO;
+            break;
+        }
+        stats->input_bytes += n;
+        if (first) {
+            first = false;
+            stats->format = cardid_archive_detect(inbuf, n);
+            st = decoder_init(&d, stats->format);
+            if (st != CARDID_OK) break;
+        }
+        if (stats->format == CARDID_ARCHIVE_PLAIN) {
+            cardid_scanner_feed(&s, (const char*)inbuf, n, emit, &e);
+            stats->bytes += n;
+        } else {
+            st = decode_into_scanner(&d, inbuf, n, outbuf, &s, &e, &stats->bytes);
+        }
+    }
+    if (st == CARDID_OK) st = decoder_end(&d);
+    if (st == CARDID_OK) cardid_scanner_finish(&s, emit, &e);
+    cardid_secure_zero(&s, sizeof(s));
+    if (inbuf) cardid_secure_zero(inbuf, CHUNK);
+    if (outbuf) cardid_secure_zero(outbuf, CHUNK);
+    free(inbuf);
+    free(outbuf);
+    decoder_free(&d);
+    stats->matches = e.matches;
+    return st;
+}
+
+// ---------------------------------------------------------------------------
+// Splitting into independently decodable pieces
+
+// Size of the bgzip block at p: a gzip member whose extra field has a 'BC'
+// subfield holding the member size minus one. 0 if p is not one.
+static size_t bgzf_block_size(const unsigned char* p, size_t len) {
+    if (len < 18 || p[0] != 0x1f || p[1] != 0x8b || p[2] != 8 || !(p[3] & 4)) return 0;
+    size_t xend = 12 + (p[10] | (size_t)p[11] << 8);
+    if (xend > len) return 0;
+    for (size_t i = 12; i + 4 <= xend;) {
+        size_t slen = p[i + 2] | (size_t)p[i + 3] << 8;
+        if (p[i] == 'B' && p[i + 1] == 'C' && slen == 2 && i + 6 <= xend) {
+            size_t bsize = (p[i + 4] | (size_t)p[i + 5] << 8) + 1;
+            return bsize >= xend + 8 && bsize <= len ? bsize : 0;
+        }
+        i += 4 + slen;
+    }
+    return 0;
+}
+
+static size_t piece_size(cardid_archive_format format, const unsigned char* p, size_t len) {
+    if (format == CARDID_ARCHIVE_GZIP) return bgzf_block_size(p, len);
+#ifdef CARDID_HAVE_ZSTD
+    if (format == CARDID_ARCHIVE_ZSTD) {
+        size_t n = ZSTD_findFrameCompressedSize(p, len);
+        return ZSTD_isError(n) ? 0 : n;
+    }
+#endif
+    return 0;
+}
+
+#ifndef _WIN32
+
+// One work item: a run of whole pieces, decoded and scanned by a worker in
+// CHUNK steps. The interior (first to last sync byte) is scanned there; head
+// and tail keep the bytes around the seams for the calling thread. Memory per
+// item is bounded: when the head or tail would outgrow SEAM_CAP (a long stretch
+// without a sync byte) or the matches MATCH_CAP, the worker gives up and the
+// calling thread decodes the item itself, straight into its scanner.
+#define SEAM_CAP CHUNK
+#define MATCH_CAP 16384u
+
+typedef struct {
+    const unsigned char* in;
+    size_t in_len;
+    bool done;
+    bool fallback;           // too big to summarize: decode on the calling thread
+    cardid_status status;
+    uint64_t size;           // decompressed bytes
+    bool has_sync;
+    unsigned char* head;     // bytes up to and including the first sync byte
+    size_t head_len;         // (the whole group when it has none)
+    unsigned char* tail;     // bytes from the last sync byte on
+    size_t tail_len;
+    uint64_t tail_at;        // group-relative offset of tail
+    cardid_scan_match* matches;
+    size_t nmatches, cap;
+    bool oom;
+} group;
+
+typedef struct {
+    group* groups;
+    size_t ngroups;
+    size_t next;
+    size_t consumed;         // groups the calling thread has finished with
+    size_t window;           // groups workers may run ahead of consumed
+    cardid_archive_format format;
+    bool stop;
+    pthread_mutex_t lock;
+    pthread_cond_t cond;
+} pool;
+
+// Per-worker scratch, reused for every group.
+typedef struct {
+    unsigned char* buf;      // CHUNK of decoded bytes
+    unsigned char* head;     // SEAM_CAP
+    unsigned char* tail;     // SEAM_CAP
+    size_t head_len, tail_len;
+    bool synced;             // a sync byte has been seen in this group
+    uint64_t pos;            // group-relative offset of the next byte
+    uint64_t tail_at;
+    cardid_scanner sc;
+} worker_state;
+
+static void collect(const cardid_scan_match* m, void* arg) {
+    group* g = arg;
+    if (g->nmatches == g->cap) {
+        if (g->cap >= MATCH_CAP) {
+            g->nmatches++;  // over the cap: the group falls back
+            return;
+        }
+        size_t cap = g->cap ? 2 * g->cap : 64;
+        cardid_scan_match* grown = realloc(g->matches, cap * sizeof(*grown));
+        if (!grown) {
+            g->oom = true;
+            return;
+        }
+        g->matches = grown;
+        g->cap = cap;
+    }
+    if (g->nmatches < g->cap) g->matches[g->nmatches] = *m;
+    g->nmatches++;
+}
+
+static unsigned char* dup_bytes(const unsigned char* p, size_t n) {
+    unsigned char* out = malloc(n ? n : 1);
+    if (out && n) memcpy(out, p, n);
+    return out;
+}
+
+static void wipe_free(unsigned char* p, size_t n) {
+    if (!p) return;
+    cardid_secure_zero(p, n);
+    free(p);
+}
+
+// Takes the next n decoded bytes of g (n <= CHUNK). False when the group no
+// longer fits the caps.
+static bool group_take(worker_state* w, group* g, const unsigned char* data, size_t n) {
+    size_t i = 0;
+    if (!w->synced) {
+        while (i < n && !is_sync(data[i])) ++i;
+        size_t keep = i < n ? i + 1 : n;
+        if (w->head_len + keep > SEAM_CAP) return false;
+        memcpy(w->head + w->head_len, data, keep);
+        w->head_len += keep;
+        if (i == n) {
+            w->pos += n;
+            return true;
+        }
+        // Interior scan starts at the first sync byte, which also opens the tail.
+        w->synced = true;
+        w->tail_at = w->pos + i;
+        cardid_scanner_init(&w->sc, w->tail_at);
+        cardid_scanner_feed(&w->sc, (const char*)data + i, 1, collect, g);
+        w->tail[0] = data[i];
+        w->tail_len = 1;
+        ++i;
+    }
+    size_t t = n;
+    for (size_t j = n; j > i; --j) {
+        if (is_sync(data[j - 1])) {
+            t = j - 1;
+            break;
+        }
+    }
+    if (t == n) {
+        if (w->tail_len + (n - i) > SEAM_CAP) return false;
+        memcpy(w->tail + w->tail_len, data + i, n - i);
+        w->tail_len += n - i;
+    } else {
+        // The old tail (its sync byte already fed) and everything up to the new
+        // last sync byte join the interior.
+        cardid_scanner_feed(&w->sc, (const char*)w->tail + 1, w->tail_len - 1, collect, g);
+        cardid_scanner_feed(&w->sc, (const char*)data + i, t + 1 - i, collect, g);
+        w->tail_at = w->pos + t;
+        w->tail_len = n - t;
+        memcpy(w->tail, data + t, w->tail_len);
+    }
+    w->pos += n;
+    return !g->oom && g->nmatches <= MATCH_CAP;
+}
+
+static cardid_status scan_group(pool* p, worker_state* w, decoder* d, group* g) {
+    w->head_len = w->tail_len = 0;
+    w->synced = false;
+    w->pos = 0;
+    bool fits = true;
+    if (p->format == CARDID_ARCHIVE_PLAIN) {
+        for (size_t off = 0; off < g->in_len && fits; off += CHUNK) {
+            fits = group_take(w, g, g->in + off, g->in_len - off < CHUNK ? g->in_len - off : CHUNK);
+        }
+    } else {
+        decoder_reset(d);
+        const unsigned char* in = g->in;
+        size_t left = g->in_len;
+        while (fits) {
+            size_t before = left, got;
+            cardid_status st = decoder_step(d, &in, &left, w->buf, CHUNK, &got);
+            if (st != CARDID_OK) return st;
+            fits = group_take(w, g, w->buf, got);
+            if (got < CHUNK && left == 0) break;
+            if (got == 0 && left == before) return CARDID_ERR_FORMAT;
+        }
+        if (fits && decoder_end(d) != CARDID_OK) return CARDID_ERR_FORMAT;
+    }
+    if (w->synced) cardid_scanner_finish(&w->sc, collect, g);  // just past a sync byte: no-op
+    cardid_secure_zero(&w->sc, sizeof(w->sc));
+    if (g->oom) return CARDID_ERR_NOMEM;
+    if (!fits || g->nmatches > MATCH_CAP) {
+        g->fallback = true;
+        return CARDID_OK;
+    }
+    g->size = w->pos;
+    g->has_sync = w->synced;
+    g->head = dup_bytes(w->head, w->head_len);
+    g->head_len = w->head_len;
+    if (w->synced) {
+        g->tail = dup_bytes(w->tail, w->tail_len);
+        g->tail_len = w->tail_len;
+        g->tail_at = w->tail_at;
+    }
+    return g->head && (g->tail || !w->synced) ? CARDID_OK : CARDID_ERR_NOMEM;
+}
+
+static void* group_worker(void* arg) {
+    pool* p = arg;
+    decoder d;
+    worker_state w;
+    memset(&w, 0, sizeof(w));
+    w.buf = malloc(CHUNK);
+    w.head = malloc(SEAM_CAP);
+    w.tail = malloc(SEAM_CAP);
+    cardid_status init = w.buf && w.head && w.tail ? CARDID_OK : CARDID_ERR_NOMEM;
+    if (init == CARDID_OK && p->format != CARDID_ARCHIVE_PLAIN) init = decoder_init(&d, p->format);
+    for (;;) {
+        pthread_mutex_lock(&p->lock);
+        while (!p->stop && p->next < p->ngroups && p->next >= p->consumed + p->window) {
+            pthread_cond_wait(&p->cond, &p->lock);
+        }
+        if (p->stop || p->next == p->ngroups) {
+            pthread_mutex_unlock(&p->lock);
+            break;
+        }
+        size_t gi = p->next++;
+        pthread_mutex_unlock(&p->lock);
+
+        group* g = &p->groups[gi];
+        cardid_status st = init == CARDID_OK ? scan_group(p, &w, &d, g) : init;
+
+        pthread_mutex_lock(&p->lock);
+        g->status = st;
+        g->done = true;
+        if (st != CARDID_OK) p->stop = true;
+        pthread_cond_broadcast(&p->cond);
+        pthread_mutex_unlock(&p->lock);
+    }
+    wipe_free(w.buf, CHUNK);
+    wipe_free(w.head, SEAM_CAP);
+    wipe_free(w.tail, SEAM_CAP);
+    if (p->format != CARDID_ARCHIVE_PLAIN) decoder_free(&d);
+    return NULL;
+}
+
+static void group_release(group* g) {
+    wipe_free(g->head, g->head_len);
+    wipe_free(g->tail, g->tail_len);
+    if (g->matches) {
+        cardid_secure_zero(g->matches, g->cap * sizeof(*g->matches));
+        free(g->matches);
+    }
+    g->head = g->tail = NULL;
+    g->matches = NULL;
+}
+
+// A group a worker gave up on, decoded here straight into the seam scanner s.
+static cardid_status replay_group(cardid_archive_format format, decoder* d, bool* d_ready,
+                                  unsigned char** buf, const group* g, cardid_scanner* s,
+                                  emitter* e, unsigned long long* bytes) {
+    if (format == CARDID_ARCHIVE_PLAIN) {
+        cardid_scanner_feed(s, (const char*)g->in, g->in_len, emit, e);
+        *bytes = g->in_len;
+        return CARDID_OK;
+    }
+    if (!*d_ready) {
+        cardid_status st = decoder_init(d, format);
+        if (st != CARDID_OK) return st;
+        *d_ready = true;
+    }
+    if (!*buf && !(*buf = malloc(CHUNK))) return CARDID_ERR_NOMEM;
+    decoder_reset(d);
+    *bytes = 0;
+    cardid_status st = decode_into_scanner(d, g->in, g->in_len, *buf, s, e, bytes);
+    return st == CARDID_OK ? decoder_end(d) : st;
+}
+
+// Hands groups to the callback in order as workers finish them, joining the
+// seams with one scanner that sees only head and tail bytes. Workers stay at
+// most a window of groups ahead, so finished-but-unread groups are bounded too.
+static cardid_status scan_parallel(group* groups, size_t ngroups, cardid_archive_format format,
+                                   int threads, emitter* e, cardid_archive_stats* stats) {
+    pool p;
+    memset(&p, 0, sizeof(p));
+    p.groups = groups;
+    p.ngroups = ngroups;
+    p.window = 2 * (size_t)threads;
+    p.format = format;
+    pthread_mutex_init(&p.lock, NULL);
+    pthread_cond_init(&p.cond, NULL);
+
+    pthread_t tids[MAX_THREADS];
+    int started = 0;
+    for (; started < threads; ++started) {
+        if (pthread_create(&tids[started], NULL, group_worker, &p) != 0) break;
+    }
+    cardid_status st = started > 0 ? CARDID_OK : CARDID_ERR_NOMEM;
+    stats->threads = started;
+
+    decoder d;
+    bool d_ready = false;
+    unsigned char* buf = NULL;
+    cardid_scanner s;
+    cardid_scanner_init(&s, 0);
+    uint64_t base = 0;
+    for (size_t gi = 0; gi < ngroups && st == CARDID_OK; ++gi) {
+        group* g = &groups[gi];
+        pthread_mutex_lock(&p.lock);
+        while (!g->done) pthread_cond_wait(&p.cond, &p.lock);
+        pthread_mutex_unlock(&p.lock);
+        st = g->status;
+        if (st != CARDID_OK) break;
+        if (g->fallback) {
+            unsigned long long bytes = 0;
+            st = replay_group(format, &d, &d_ready, &buf, g, &s, e, &bytes);
+            base += bytes;
+        } else {
+            cardid_scanner_feed(&s, (const char*)g->head, g->head_len, emit, e);
+            if (g->has_sync) {
+                cardid_scanner_finish(&s, emit, e);
+                for (size_t i = 0; i < g->nmatches; ++i) {
+                    cardid_scan_match m = g->matches[i];
+                    m.offset += base;
+                    emit(&m, e);
+                }
+                cardid_scanner_init(&s, base + g->tail_at);
+                cardid_scanner_feed(&s, (const char*)g->tail, g->tail_len, emit, e);
+            }
+            base += g->size;
+        }
+        group_release(g);
+        pthread_mutex_lock(&p.lock);
+        p.consumed = gi + 1;
+        pthread_cond_broadcast(&p.cond);
+        pthread_mutex_unlock(&p.lock);
+    }
+    if (st == CARDID_OK) cardid_scanner_finish(&s, emit, e);
+    cardid_secure_zero(&s, sizeof(s));
+    stats->bytes = base;
+
+    pthread_mutex_lock(&p.lock);
+    p.stop = true;
+    pthread_cond_broadcast(&p.cond);
+    pthread_mutex_unlock(&p.lock);
+    for (int i = 0; i < started; ++i) pthread_join(tids[i], NULL);
+    for (size_t gi = 0; gi < ngroups; ++gi) group_release(&groups[gi]);
+    wipe_free(buf, CHUNK);
+    if (d_ready) decoder_free(&d);
+    pthread_cond_destroy(&p.cond);
+    pthread_mutex_destroy(&p.lock);
+    return st;
+}
+
+#endif  // !_WIN32
+
+cardid_status cardid_archive_scan(const void* data, size_t len, int threads,
+                                  cardid_scan_callback cb, void* ctx,
+                                  cardid_archive_stats* stats) {
+    cardid_archive_stats local;
+    if (!stats) stats = &local;
+    memset(stats, 0, sizeof(*stats));
+    if ((!data && len) || !cb || threads < 0) return CARDID_ERR_ARG;
+    const unsigned char* in = data;
+    cardid_archive_format format = cardid_archive_detect(in, len);
+    stats->format = format;
+    stats->input_bytes = len;
+    stats->threads = 1;
+    if (!cardid_archive_supported(format)) return CARDID_ERR_ARG;
+    emitter e = {cb, ctx, 0};
+    cardid_status st;
+
+#ifndef _WIN32
+    if (threads == 0) {
+        long n = sysconf(_SC_NPROCESSORS_ONLN);
+        threads = n > 0 ? (int)n : 1;
+    }
+    if (threads > MAX_THREADS) threads = MAX_THREADS;
+
+    // Work items of whole pieces, sized so each thread gets several. Whatever
+    // does not parse as a piece (plain gzip, one big frame) becomes a single
+    // item, so a file with no usable structure is decoded sequentially.
+    size_t target = len / ((size_t)threads * 4);
+    if (target < GROUP_MIN) target = GROUP_MIN;
+    if (target > GROUP_MAX) target = GROUP_MAX;
+    if (format == CARDID_ARCHIVE_PLAIN) target *= PLAIN_FACTOR;
+    group* groups = NULL;
+    size_t ngroups = 0, cap = 0;
+    size_t off = 0;
+    bool oom = false;
+    while (threads > 1 && off < len && !oom) {
+        size_t n = 0;
+        if (format == CARDID_ARCHIVE_PLAIN) {
+            n = len - off < target ? len - off : target;
+        } else {
+            size_t piece;
+            while (off + n < len && n < target &&
+                   (piece = piece_size(format, in + off + n, len - off - n)) > 0) {
+                n += piece;
+                stats->blocks++;
+            }
+            if (n == 0) n = len - off;  // unsplittable remainder
+        }
+        if (ngroups == cap) {
+            cap = cap ? 2 * cap : 64;
+            group* grown = realloc(groups, cap * sizeof(*grown));
+            if (!grown) {
+                oom = true;
+                break;
+            }
+            groups = grown;
+        }
+        memset(&groups[ngroups], 0, sizeof(groups[ngroups]));
+        groups[ngroups].in = in + off;
+        groups[ngroups].in_len = n;
+        ++ngroups;
+        off += n;
+    }
+    if (format == CARDID_ARCHIVE_PLAIN) stats->blocks = 0;
+    if (oom) {
+        st = CARDID_ERR_NOMEM;
+    } else if (ngroups >= 2) {
+        st = scan_parallel(groups, ngroups, format, threads < (int)ngroups ? threads : (int)ngroups,
+                           &e, stats);
+    } else {
+        st = scan_sequential(in, len, format, &e, stats);
+    }
+    free(groups);
+#else
+    (void)threads;
+    st = scan_sequential(in, len, format, &e, stats);
+#endif
+    stats->matches = e.matches;
+    return st;
+}
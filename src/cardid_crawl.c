@@ -0,0 +1,1014 @@
+#if !defined(_WIN32) && !defined(_GNU_SOURCE)
+#define _GNU_SOURCE  // O_NOATIME, getline, pread
+#endif
+#include "cardid_crawl.h"
+#include <errno.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include "cardid_archive.h"
+#include "cardid_internal.h"
+#include "cardid_scan.h"
+
+#if defined(_WIN32)
+
+cardid_status cardid_crawl(const char* const* roots, size_t root_count, FILE* report,
+                           const cardid_crawl_config* cfg, cardid_crawl_stats* stats) {
+    (void)roots;
+    (void)root_count;
+    (void)report;
+    (void)cfg;
+    if (stats) memset(stats, 0, sizeof(*stats));
+    return CARDID_ERR_IO;  // directory walking is POSIX-only for now
+}
+
+#else
+
+#include <dirent.h>
+#include <fcntl.h>
+#include <pthread.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#if defined(CARDID_IO_URING) && CARDID_IO_URING && defined(__linux__)
+#include <linux/io_uring.h>
+#include <sys/syscall.h>
+#define CRAWL_HAVE_URING 1
+#endif
+
+#if defined(__APPLE__)
+#define ST_MTIME_SEC(st) ((long long)(st).st_mtimespec.tv_sec)
+#define ST_MTIME_NSEC(st) ((long)(st).st_mtimespec.tv_nsec)
+#else
+#define ST_MTIME_SEC(st) ((long long)(st).st_mtim.tv_sec)
+#define ST_MTIME_NSEC(st) ((long)(st).st_mtim.tv_nsec)
+#endif
+
+#define DEFAULT_DEPTH 4
+#define DEFAULT_BUFFER (256u * 1024u)
+#define DEFAULT_LISTED 1000u
+#define MAX_THREADS 256
+#define MAX_DEPTH 256  // directory nesting; guards against bind-mount loops
+#define ARCHIVE_PARALLEL_MIN (1u << 20)   // smaller archives stream on one thread
+#define ARCHIVE_PARALLEL_MAX (64u << 20)  // larger ones too, to bound memory
+#define MANIFEST_HEADER "# cardid-manifest v1\n"
+
+// ---------------------------------------------------------------------------
+// Growable byte string for report and manifest lines.
+
+typedef struct {
+    char* p;
+    size_t len, cap;
+    bool failed;
+} strbuf;
+
+static void sb_put(strbuf* b, const char* s, size_t n) {
+    if (b->failed) return;
+    if (b->len + n + 1 > b->cap) {
+        size_t cap = b->cap ? b->cap : 256;
+        while (cap < b->len + n + 1) cap *= 2;
+        char* p = realloc(b->p, cap);
+        if (!p) {
+            b->failed = true;
+            return;
+        }
+        b->p = p;
+        b->cap = cap;
+    }
+    memcpy(b->p + b->len, s, n);
+    b->len += n;
+    b->p[b->len] = '\0';
+}
+
+static void sb_puts(strbuf* b, const char* s) {
+    sb_put(b, s, strlen(s));
+}
+
+static void sb_printf_ull(strbuf* b, unsigned long long v) {
+    char tmp[24];
+    int n = snprintf(tmp, sizeof(tmp), "%llu", v);
+    sb_put(b, tmp, (size_t)n);
+}
+
+// Paths are written with \\, \t, \n and \r escaped so every line parses back
+// (cardid_unescape_path reverses it).
+static void sb_put_path(strbuf* b, const char* path) {
+    for (const char* p = path; *p; ++p) {
+        switch (*p) {
+            case '\\': sb_put(b, "\\\\", 2); break;
+            case '\t': sb_put(b, "\\t", 2); break;
+            case '\n': sb_put(b, "\\n", 2); break;
+            case '\r': sb_put(b, "\\r", 2); break;
+            default: sb_put(b, p, 1);
+        }
+    }
+}
+
+// ---------------------------------------------------------------------------
+// Manifest: open-addressed table keyed by path, read-only once loaded.
+
+typedef struct {
+    char* path;
+    unsigned long long size;
+    long long mtime_sec;
+    long mtime_nsec;
+    unsigned long long matches;
+} manifest_entry;
+
+typedef struct {
+    manifest_entry* slots;
+    size_t cap;  // power of two, or 0 when empty
+    size_t count;
+} manifest;
+
+static uint64_t hash_path(const char* s) {
+    uint64_t h = 0xcbf29ce484222325ULL;  // FNV-1a
+    for (; *s; ++s) h = (h ^ (unsigned char)*s) * 0x100000001b3ULL;
+    return h;
+}
+
+static bool manifest_insert(manifest* m, const manifest_entry* e) {
+    if ((m->count + 1) * 2 > m->cap) {
+        size_t cap = m->cap ? m->cap * 2 : 1024;
+        manifest_entry* slots = calloc(cap, sizeof(*slots));
+        if (!slots) return false;
+        for (size_t i = 0; i < m->cap; ++i) {
+            if (!m->slots[i].path) continue;
+            size_t j = hash_path(m->slots[i].path) & (cap - 1);
+            while (slots[j].path) j = (j + 1) & (cap - 1);
+            slots[j] = m->slots[i];
+        }
+        free(m->slots);
+        m->slots = slots;
+        m->cap = cap;
+    }
+    size_t j = hash_path(e->path) & (m->cap - 1);
+    while (m->slots[j].path) {
+        if (strcmp(m->slots[j].path, e->path) == 0) {  // later lines win
+            free(m->slots[j].path);
+            m->slots[j] = *e;
+            return true;
+        }
+        j = (j + 1) & (m->cap - 1);
+    }
+    m->slots[j] = *e;
+    m->count++;
+    return true;
+}
+
+static const manifest_entry* manifest_find(const manifest* m, const char* path) {
+    if (!m->cap) return NULL;
+    size_t j = hash_path(path) & (m->cap - 1);
+    while (m->slots[j].path) {
+        if (strcmp(m->slots[j].path, path) == 0) return &m->slots[j];
+        j = (j + 1) & (m->cap - 1);
+    }
+    return NULL;
+}
+
+static void manifest_free(manifest* m) {
+    for (size_t i = 0; i < m->cap; ++i) free(m->slots[i].path);
+    free(m->slots);
+    memset(m, 0, sizeof(*m));
+}
+
+// Line format: <size>\t<mtime_sec>.<mtime_nsec>\t<matches>\t<escaped path>
+static cardid_status manifest_load(manifest* m, const char* path) {
+    FILE* f = fopen(path, "r");
+    if (!f) return errno == ENOENT ? CARDID_OK : CARDID_ERR_IO;  // first run
+    cardid_status st = CARDID_OK;
+    char* line = NULL;
+    size_t cap = 0;
+    ssize_t n;
+    while (st == CARDID_OK && (n = getline(&line, &cap, f)) > 0) {
+        if (line[n - 1] == '\n') line[--n] = '\0';
+        if (n == 0 || line[0] == '#') continue;
+        manifest_entry e;
+        char* p = line;
+        e.size = strtoull(p, &p, 10);
+        bool ok = *p++ == '\t';
+        e.mtime_sec = ok ? strtoll(p, &p, 10) : 0;
+        ok = ok && *p++ == '.';
+        e.mtime_nsec = ok ? strtol(p, &p, 10) : 0;
+        ok = ok && *p++ == '\t';
+        e.matches = ok ? strtoull(p, &p, 10) : 0;
+        ok = ok && *p++ == '\t' && *p != '\0';
+        if (!ok) {
+            st = CARDID_ERR_FORMAT;
+            break;
+        }
+        e.path = strdup(p);
+        if (!e.path) {
+            st = CARDID_ERR_NOMEM;
+            break;
+        }
+        cardid_unescape_path(e.path);
+        if (!manifest_insert(m, &e)) {
+            free(e.path);
+            st = CARDID_ERR_NOMEM;
+        }
+    }
+    if (st == CARDID_OK && ferror(f)) st = CARDID_ERR_IO;
+    free(line);
+    fclose(f);
+    return st;
+}
+
+// ---------------------------------------------------------------------------
+// io_uring, driven through the raw syscalls so no liburing is needed. One ring
+// per worker, used only by that worker.
+
+#ifdef CRAWL_HAVE_URING
+typedef struct {
+    int fd;
+    unsigned *sq_head, *sq_tail, *sq_mask, *sq_array;
+    unsigned *cq_head, *cq_tail, *cq_mask;
+    struct io_uring_sqe* sqes;
+    struct io_uring_cqe* cqes;
+    void* sq_map;
+    size_t sq_map_len;
+    void* cq_map;
+    size_t cq_map_len;
+    size_t sqes_len;
+    unsigned to_submit;
+} uring;
+
+static void uring_free(uring* r) {
+    if (r->sqes) munmap(r->sqes, r->sqes_len);
+    if (r->cq_map && r->cq_map != r->sq_map) munmap(r->cq_map, r->cq_map_len);
+    if (r->sq_map) munmap(r->sq_map, r->sq_map_len);
+    if (r->fd >= 0) close(r->fd);
+    memset(r, 0, sizeof(*r));
+    r->fd = -1;
+}
+
+// Whether the kernel supports IORING_OP_READ (5.6+); older rings lack it.
+static bool uring_supports_read(int fd) {
+    size_t len = sizeof(struct io_uring_probe) + 256 * sizeof(struct io_uring_probe_op);
+    struct io_uring_probe* probe = calloc(1, len);
+    if (!probe) return false;
+    bool ok = syscall(__NR_io_uring_register, fd, IORING_REGISTER_PROBE, probe, 256) == 0 &&
+              probe->last_op >= IORING_OP_READ &&
+              (probe->ops[IORING_OP_READ].flags & IO_URING_OP_SUPPORTED);
+    free(probe);
+    return ok;
+}
+
+static bool uring_init(uring* r, unsigned entries) {
+    memset(r, 0, sizeof(*r));
+    struct io_uring_params p;
+    memset(&p, 0, sizeof(p));
+    r->fd = (int)syscall(__NR_io_uring_setup, entries, &p);
+    if (r->fd < 0) {
+        r->fd = -1;
+        return false;
+    }
+    if (!uring_supports_read(r->fd)) {
+        uring_free(r);
+        return false;
+    }
+
+    r->sq_map_len = p.sq_off.array + p.sq_entries * sizeof(unsigned);
+    r->cq_map_len = p.cq_off.cqes + p.cq_entries * sizeof(struct io_uring_cqe);
+    bool single = (p.features & IORING_FEAT_SINGLE_MMAP) != 0;
+    if (single && r->cq_map_len > r->sq_map_len) r->sq_map_len = r->cq_map_len;
+    r->sq_map = mmap(NULL, r->sq_map_len, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE,
+                     r->fd, IORING_OFF_SQ_RING);
+    if (r->sq_map == MAP_FAILED) {
+        r->sq_map = NULL;
+        uring_free(r);
+        return false;
+    }
+    r->cq_map = single ? r->sq_map
+                       : mmap(NULL, r->cq_map_len, PROT_READ | PROT_WRITE,
+                              MAP_SHARED | MAP_POPULATE, r->fd, IORING_OFF_CQ_RING);
+    r->sqes_len = p.sq_entries * sizeof(struct io_uring_sqe);
+    void* sqes = mmap(NULL, r->sqes_len, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, r->fd,
+                      IORING_OFF_SQES);
+    if (r->cq_map == MAP_FAILED || sqes == MAP_FAILED) {
+        if (r->cq_map == MAP_FAILED) r->cq_map = NULL;
+        if (sqes != MAP_FAILED) r->sqes = sqes;
+        uring_free(r);
+        return false;
+    }
+    r->sqes = sqes;
+
+    char* sq = r->sq_map;
+    char* cq = r->cq_map;
+    r->sq_head = (unsigned*)(sq + p.sq_off.head);
+    r->sq_tail = (unsigned*)(sq + p.sq_off.tail);
+    r->sq_mask = (unsigned*)(sq + p.sq_off.ring_mask);
+    r->sq_array = (unsigned*)(sq + p.sq_off.array);
+    r->cq_head = (unsigned*)(cq + p.cq_off.head);
+    r->cq_tail = (unsigned*)(cq + p.cq_off.tail);
+    r->cq_mask = (unsigned*)(cq + p.cq_off.ring_mask);
+    r->cqes = (struct io_uring_cqe*)(cq + p.cq_off.cqes);
+    return true;
+}
+
+static void uring_prep_read(uring* r, int fd, void* buf, unsigned len, uint64_t off,
+                            uint64_t user_data) {
+    unsigned tail = *r->sq_tail;
+    unsigned idx = tail & *r->sq_mask;
+    struct io_uring_sqe* sqe = &r->sqes[idx];
+    memset(sqe, 0, sizeof(*sqe));
+    sqe->opcode = IORING_OP_READ;
+    sqe->fd = fd;
+    sqe->off = off;
+    sqe->addr = (uint64_t)(uintptr_t)buf;
+    sqe->len = len;
+    sqe->user_data = user_data;
+    r->sq_array[idx] = idx;
+    __atomic_store_n(r->sq_tail, tail + 1, __ATOMIC_RELEASE);
+    r->to_submit++;
+}
+
+// Submits queued reads and, if wait is set, blocks until one completion exists.
+static int uring_enter(uring* r, bool wait) {
+    if (!wait && r->to_submit == 0) return 0;
+    for (;;) {
+        long n = syscall(__NR_io_uring_enter, r->fd, r->to_submit, wait ? 1 : 0,
+                         wait ? IORING_ENTER_GETEVENTS : 0, NULL, 0);
+        if (n >= 0) {
+            r->to_submit -= (unsigned)n;
+            return 0;
+        }
+        if (errno != EINTR) return errno;
+    }
+}
+
+static bool uring_reap(uring* r, uint64_t* user_data, int* res) {
+    unsigned head = *r->cq_head;
+    if (head == __atomic_load_n(r->cq_tail, __ATOMIC_ACQUIRE)) return false;
+    struct io_uring_cqe* cqe = &r->cqes[head & *r->cq_mask];
+    *user_data = cqe->user_data;
+    *res = cqe->res;
+    __atomic_store_n(r->cq_head, head + 1, __ATOMIC_RELEASE);
+    return true;
+}
+#endif
+
+// ---------------------------------------------------------------------------
+// Crawl state shared by all workers.
+
+typedef struct {
+    char* path;
+    bool dir;
+    int depth;
+} work_item;
+
+typedef struct {
+    pthread_mutex_t lock;
+    pthread_cond_t cond;
+    work_item* items;  // LIFO, so the walk stays depth-first and the stack small
+    size_t count, cap;
+    int active;  // workers processing an item (and so possibly about to push more)
+    int lent;    // threads lent to archive scans (see borrow_threads)
+    bool stop;
+
+    int threads;
+    int depth;
+    size_t buffer_size;
+    unsigned max_listed;
+    cardid_crawl_io io;
+    manifest old;
+
+    pthread_mutex_t out_lock;
+    FILE* report;
+    FILE* manifest_out;
+    cardid_status status;
+} crawl;
+
+typedef struct {
+    crawl* c;
+    pthread_t tid;
+    char* bufs;  // depth buffers of buffer_size bytes
+    int* res;
+    bool* done;
+#ifdef CRAWL_HAVE_URING
+    uring ring;
+#endif
+    bool use_uring;
+    cardid_scanner scanner;
+    strbuf line;
+    unsigned long long file_matches;
+    unsigned listed;
+    cardid_crawl_stats stats;
+} worker;
+
+static void crawl_fail(crawl* c, cardid_status st) {
+    pthread_mutex_lock(&c->lock);
+    if (c->status == CARDID_OK) c->status = st;
+    c->stop = true;
+    pthread_cond_broadcast(&c->cond);
+    pthread_mutex_unlock(&c->lock);
+}
+
+// Takes ownership of path.
+static bool push_work(crawl* c, char* path, bool dir, int depth) {
+    pthread_mutex_lock(&c->lock);
+    if (c->count == c->cap) {
+        size_t cap = c->cap ? c->cap * 2 : 256;
+        work_item* items = realloc(c->items, cap * sizeof(*items));
+        if (!items) {
+            pthread_mutex_unlock(&c->lock);
+            free(path);
+            crawl_fail(c, CARDID_ERR_NOMEM);
+            return false;
+        }
+        c->items = items;
+        c->cap = cap;
+    }
+    c->items[c->count].path = path;
+    c->items[c->count].dir = dir;
+    c->items[c->count].depth = depth;
+    c->count++;
+    pthread_cond_signal(&c->cond);
+    pthread_mutex_unlock(&c->lock);
+    return true;
+}
+
+// Blocks until there is work and a thread to spare for it (threads lent to an
+// archive scan count as busy), or the crawl is over (stack empty, nobody active).
+static bool pop_work(crawl* c, work_item* out) {
+    pthread_mutex_lock(&c->lock);
+    while (!c->stop && (c->count == 0 ? c->active > 0 : c->active + c->lent >= c->threads))
+        pthread_cond_wait(&c->cond, &c->lock);
+    if (c->stop || c->count == 0) {
+        pthread_cond_broadcast(&c->cond);
+        pthread_mutex_unlock(&c->lock);
+        return false;
+    }
+    *out = c->items[--c->count];
+    c->active++;
+    pthread_mutex_unlock(&c->lock);
+    return true;
+}
+
+static void work_done(crawl* c) {
+    pthread_mutex_lock(&c->lock);
+    // With threads lent out, a waiting worker may now fit in the budget.
+    if ((--c->active == 0 && c->count == 0) || c->lent > 0) pthread_cond_broadcast(&c->cond);
+    pthread_mutex_unlock(&c->lock);
+}
+
+static void write_out(crawl* c, const strbuf* report_line, const strbuf* manifest_line) {
+    if ((report_line && report_line->failed) || (manifest_line && manifest_line->failed)) {
+        crawl_fail(c, CARDID_ERR_NOMEM);
+        return;
+    }
+    pthread_mutex_lock(&c->out_lock);
+    bool ok = true;
+    if (report_line && report_line->len)
+        ok = fwrite(report_line->p, 1, report_line->len, c->report) == report_line->len;
+    if (ok && manifest_line && c->manifest_out)
+        ok = fwrite(manifest_line->p, 1, manifest_line->len, c->manifest_out) ==
+             manifest_line->len;
+    pthread_mutex_unlock(&c->out_lock);
+    if (!ok) crawl_fail(c, CARDID_ERR_IO);
+}
+
+static void report_failure(worker* w, const char* path, const char* reason) {
+    strbuf b = {0};
+    sb_put_path(&b, path);
+    sb_puts(&b, "\terror\t");
+    sb_puts(&b, reason);
+    sb_puts(&b, "\n");
+    write_out(w->c, &b, NULL);
+    free(b.p);
+    w->stats.files_failed++;
+}
+
+static void report_error(worker* w, const char* path, int err) {
+    report_failure(w, path, strerror(err));
+}
+
+static void on_match(const cardid_scan_match* m, void* ctx) {
+    worker* w = ctx;
+    if (w->listed < w->c->max_listed) {
+        sb_puts(&w->line, w->listed ? "," : "\t");
+        sb_printf_ull(&w->line, m->offset);
+        sb_puts(&w->line, ":");
+        sb_puts(&w->line, cardid_network_name(m->network));
+        sb_puts(&w->line, ":");
+        sb_printf_ull(&w->line, (unsigned long long)m->length);
+        w->listed++;
+    }
+    w->file_matches++;
+}
+
+size_t cardid_crawl_read_limit = 0;
+
+static size_t read_len(size_t n) {
+    return cardid_crawl_read_limit && n > cardid_crawl_read_limit ? cardid_crawl_read_limit : n;
+}
+
+// Runs the first size bytes of fd through the scanner, keeping up to depth reads
+// in flight and consuming them in file order. A read may return fewer bytes
+// than asked for (signals, network and FUSE filesystems); the rest of the chunk
+// is asked for again, and only a 0-byte read means the file shrank under us.
+// Returns 0 or an errno value.
+static int scan_fd(worker* w, int fd, uint64_t size) {
+    const int depth = w->c->depth;
+    const size_t bsz = w->c->buffer_size;
+    const uint64_t chunks = (size + bsz - 1) / bsz;
+    uint64_t next = 0, cons = 0;
+    int err = 0;
+#ifdef CRAWL_HAVE_URING
+    unsigned inflight = 0;
+#endif
+
+    while (cons < chunks && !err) {
+        for (; next < chunks && next - cons < (uint64_t)depth; ++next) {
+            int slot = (int)(next % (uint64_t)depth);
+            w->done[slot] = false;
+#ifdef CRAWL_HAVE_URING
+            if (w->use_uring) {
+                uint64_t off = next * bsz;
+                size_t len = size - off < bsz ? (size_t)(size - off) : bsz;
+                uring_prep_read(&w->ring, fd, w->bufs + (size_t)slot * bsz,
+                                (unsigned)read_len(len), off, (uint64_t)slot);
+                inflight++;
+            }
+#endif
+        }
+
+        int slot = (int)(cons % (uint64_t)depth);
+        uint64_t off = cons * bsz;
+        size_t want = size - off < bsz ? (size_t)(size - off) : bsz;
+        char* buf = w->bufs + (size_t)slot * bsz;
+#ifdef CRAWL_HAVE_URING
+        if (w->use_uring) {
+            size_t got = 0;
+            err = uring_enter(&w->ring, false);
+            while (!err) {
+                while (!err && !w->done[slot]) {
+                    uint64_t ud;
+                    int res;
+                    if (uring_reap(&w->ring, &ud, &res)) {
+                        w->done[ud] = true;
+                        w->res[ud] = res;
+                        inflight--;
+                    } else {
+                        err = uring_enter(&w->ring, true);
+                    }
+                }
+                if (err) break;
+                int res = w->res[slot];
+                if (res < 0 && res != -EINTR) break;  // reported below
+                if (res == 0) break;                  // truncated while we read it
+                if (res > 0) got += (size_t)res;
+                if (got == want) break;
+                w->done[slot] = false;  // short read: ask for the rest
+                uring_prep_read(&w->ring, fd, buf + got, (unsigned)read_len(want - got),
+                                off + got, (uint64_t)slot);
+                inflight++;
+                err = uring_enter(&w->ring, false);
+            }
+            if (w->res[slot] >= 0) w->res[slot] = (int)got;
+        }
+#endif
+        if (!w->use_uring) {
+            size_t got = 0;
+            while (got < want) {
+                ssize_t n = pread(fd, buf + got, read_len(want - got), (off_t)(off + got));
+                if (n < 0 && errno == EINTR) continue;
+                if (n <= 0) {
+                    if (n < 0) err = errno;
+                    break;
+                }
+                got += (size_t)n;
+            }
+            w->res[slot] = (int)got;
+        }
+        if (err) break;
+        if (w->res[slot] < 0) {
+            err = -w->res[slot];
+            break;
+        }
+        cardid_scanner_feed(&w->scanner, buf, (size_t)w->res[slot], on_match, w);
+        w->stats.bytes_scanned += (unsigned long long)w->res[slot];
+        ++cons;
+        if ((size_t)w->res[slot] < want) break;  // truncated while we read it
+    }
+
+#ifdef CRAWL_HAVE_URING
+    // Buffers still being filled by the kernel must not be reused.
+    while (w->use_uring && inflight > 0) {
+        uint64_t ud;
+        int res;
+        if (uring_reap(&w->ring, &ud, &res)) {
+            inflight--;
+        } else if (uring_enter(&w->ring, true) != 0) {
+            break;
+        }
+    }
+#endif
+    return err;
+}
+
+// Borrows up to want threads from the crawl's budget: busy workers plus threads
+// lent to archive scans never exceed c->threads. Give them back with
+// return_threads.
+static int borrow_threads(crawl* c, int want) {
+    pthread_mutex_lock(&c->lock);
+    int spare = c->threads - c->active - c->lent;
+    int take = spare < want ? spare : want;
+    if (take < 0) take = 0;
+    c->lent += take;
+    pthread_mutex_unlock(&c->lock);
+    return take;
+}
+
+static void return_threads(crawl* c, int n) {
+    if (!n) return;
+    pthread_mutex_lock(&c->lock);
+    c->lent -= n;
+    pthread_cond_broadcast(&c->cond);
+    pthread_mutex_unlock(&c->lock);
+}
+
+// Reads size bytes at offset 0 into buf; *got is short if the file shrank.
+static int read_whole(int fd, unsigned char* buf, size_t size, size_t* got) {
+    *got = 0;
+    while (*got < size) {
+        ssize_t n = pread(fd, buf + *got, read_len(size - *got), (off_t)*got);
+        if (n < 0 && errno == EINTR) continue;
+        if (n < 0) return errno;
+        if (n == 0) break;
+        *got += (size_t)n;
+    }
+    return 0;
+}
+
+// Decompresses and scans a gzip or zstd file. Archives of ARCHIVE_PARALLEL_MIN
+// to ARCHIVE_PARALLEL_MAX bytes are read into memory and decoded through
+// cardid_archive_scan on threads borrowed from idle workers; others, or when
+// no thread is spare, stream through cardid_archive_scan_stream. Files are read,
+// never mmap'ed: one truncated under a mapping would raise SIGBUS. Returns 0 or
+// an errno value; *reason is set instead for corrupt data.
+static int scan_archive(worker* w, int fd, uint64_t size, const char** reason) {
+    crawl* c = w->c;
+    int extra = size >= ARCHIVE_PARALLEL_MIN && size <= ARCHIVE_PARALLEL_MAX
+                    ? borrow_threads(c, c->threads - 1)
+                    : 0;
+    unsigned char* data = extra ? malloc((size_t)size) : NULL;
+    cardid_archive_stats as;
+    cardid_status st;
+    if (data) {
+        size_t got;
+        int err = read_whole(fd, data, (size_t)size, &got);
+        st = err ? CARDID_OK : cardid_archive_scan(data, got, extra + 1, on_match, w, &as);
+        cardid_secure_zero(data, (size_t)size);
+        free(data);
+        return_threads(c, extra);
+        if (err) return err;
+    } else {
+        return_threads(c, extra);
+        int dfd = dup(fd);
+        FILE* f = dfd >= 0 ? fdopen(dfd, "rb") : NULL;
+        if (!f) {
+            int err = errno;
+            if (dfd >= 0) close(dfd);
+            return err;
+        }
+        st = cardid_archive_scan_stream(f, on_match, w, &as);
+        fclose(f);
+    }
+    w->stats.bytes_scanned += as.bytes;
+    if (st == CARDID_ERR_NOMEM) return ENOMEM;
+    if (st == CARDID_ERR_IO) return EIO;
+    if (st != CARDID_OK) {
+        *reason = as.format == CARDID_ARCHIVE_ZSTD ? "corrupt or truncated zstd data"
+                                                   : "corrupt or truncated gzip data";
+        return -1;
+    }
+    w->stats.files_decompressed++;
+    return 0;
+}
+
+static void scan_file(worker* w, const char* path) {
+    crawl* c = w->c;
+    int flags = O_RDONLY | O_CLOEXEC | O_NOFOLLOW | O_NOCTTY | O_NONBLOCK;
+    int fd = -1;
+#ifdef O_NOATIME
+    fd = open(path, flags | O_NOATIME);  // an audit should not touch atimes; needs ownership
+#endif
+    if (fd < 0) fd = open(path, flags);
+    if (fd < 0) {
+        if (errno != ELOOP) report_error(w, path, errno);  // ELOOP: replaced by a symlink
+        return;
+    }
+    struct stat st;
+    if (fstat(fd, &st) != 0 || !S_ISREG(st.st_mode)) {
+        close(fd);
+        return;
+    }
+
+    strbuf mline = {0};
+    const manifest_entry* old = manifest_find(&c->old, path);
+    if (old && old->size == (unsigned long long)st.st_size && old->mtime_sec == ST_MTIME_SEC(st) &&
+        old->mtime_nsec == ST_MTIME_NSEC(st)) {
+        close(fd);
+        w->stats.files_skipped++;
+        if (c->manifest_out) {
+            sb_printf_ull(&mline, old->size);
+            char ts[48];
+            snprintf(ts, sizeof(ts), "\t%lld.%09ld\t", old->mtime_sec, old->mtime_nsec);
+            sb_puts(&mline, ts);
+            sb_printf_ull(&mline, old->matches);
+            sb_puts(&mline, "\t");
+            sb_put_path(&mline, path);
+            sb_puts(&mline, "\n");
+            write_out(c, NULL, &mline);
+            free(mline.p);
+        }
+        return;
+    }
+
+    w->line.len = 0;
+    w->line.failed = false;
+    w->file_matches = 0;
+    w->listed = 0;
+    // Compressed files are scanned decompressed when this build can decode them.
+    unsigned char magic[4];
+    ssize_t mlen = pread(fd, magic, sizeof(magic), 0);
+    cardid_archive_format format = cardid_archive_detect(magic, mlen > 0 ? (size_t)mlen : 0);
+    const char* reason = NULL;
+    int err;
+    if (format != CARDID_ARCHIVE_PLAIN && cardid_archive_supported(format)) {
+        err = scan_archive(w, fd, (uint64_t)st.st_size, &reason);
+    } else {
+        cardid_scanner_init(&w->scanner, 0);
+        err = scan_fd(w, fd, (uint64_t)st.st_size);
+        cardid_scanner_finish(&w->scanner, on_match, w);
+    }
+    close(fd);
+    if (reason) {
+        report_failure(w, path, reason);
+        return;
+    }
+    if (err) {
+        report_error(w, path, err);
+        return;
+    }
+
+    w->stats.files_scanned++;
+    w->stats.matches += w->file_matches;
+    strbuf rline = {0};
+    if (w->file_matches) {
+        w->stats.files_with_matches++;
+        sb_put_path(&rline, path);
+        sb_puts(&rline, "\t");
+        sb_printf_ull(&rline, w->file_matches);
+        if (w->line.len) sb_put(&rline, w->line.p, w->line.len);
+        if (w->file_matches > w->listed) {
+            sb_puts(&rline, ",+");
+            sb_printf_ull(&rline, w->file_matches - w->listed);
+        }
+        sb_puts(&rline, "\n");
+        rline.failed |= w->line.failed;
+    }
+    if (c->manifest_out) {
+        sb_printf_ull(&mline, (unsigned long long)st.st_size);
+        char ts[48];
+        snprintf(ts, sizeof(ts), "\t%lld.%09ld\t", ST_MTIME_SEC(st), ST_MTIME_NSEC(st));
+        sb_puts(&mline, ts);
+        sb_printf_ull(&mline, w->file_matches);
+        sb_puts(&mline, "\t");
+        sb_put_path(&mline, path);
+        sb_puts(&mline, "\n");
+    }
+    write_out(c, &rline, c->manifest_out ? &mline : NULL);
+    free(rline.p);
+    free(mline.p);
+}
+
+static void scan_dir(worker* w, const char* path, int depth) {
+    DIR* d = opendir(path);
+    if (!d) {
+        report_error(w, path, errno);
+        return;
+    }
+    size_t plen = strlen(path);
+    bool slash = plen > 0 && path[plen - 1] == '/';
+    struct dirent* e;
+    while ((e = readdir(d)) != NULL && !w->c->stop) {
+        const char* name = e->d_name;
+        if (name[0] == '.' && (name[1] == '\0' || (name[1] == '.' && name[2] == '\0'))) continue;
+        size_t nlen = strlen(name);
+        char* child = malloc(plen + nlen + 2);
+        if (!child) {
+            crawl_fail(w->c, CARDID_ERR_NOMEM);
+            break;
+        }
+        memcpy(child, path, plen);
+        size_t pos = plen;
+        if (!slash) child[pos++] = '/';
+        memcpy(child + pos, name, nlen + 1);
+
+        int type = -1;  // 1 dir, 0 regular file, -1 anything else (symlinks included)
+#ifdef DT_DIR
+        if (e->d_type == DT_DIR) type = 1;
+        if (e->d_type == DT_REG) type = 0;
+        if (e->d_type == DT_UNKNOWN)
+#endif
+        {
+            struct stat st;
+            if (lstat(child, &st) == 0) type = S_ISDIR(st.st_mode) ? 1 : S_ISREG(st.st_mode) ? 0 : -1;
+        }
+        if (type == 1 && depth + 1 > MAX_DEPTH) {
+            report_error(w, child, ELOOP);
+            type = -1;
+        }
+        if (type < 0) {
+            free(child);
+        } else if (!push_work(w->c, child, type == 1, depth + 1)) {
+            break;
+        }
+    }
+    closedir(d);
+}
+
+static void* worker_main(void* arg) {
+    worker* w = arg;
+    work_item item;
+    while (pop_work(w->c, &item)) {
+        if (item.dir) {
+            scan_dir(w, item.path, item.depth);
+        } else {
+            scan_file(w, item.path);
+        }
+        free(item.path);
+        work_done(w->c);
+    }
+    return NULL;
+}
+
+static bool worker_init(worker* w, crawl* c) {
+    memset(w, 0, sizeof(*w));
+    w->c = c;
+    w->bufs = malloc((size_t)c->depth * c->buffer_size);
+    w->res = calloc((size_t)c->depth, sizeof(int));
+    w->done = calloc((size_t)c->depth, sizeof(bool));
+    if (!w->bufs || !w->res || !w->done) return false;
+#ifdef CRAWL_HAVE_URING
+    w->ring.fd = -1;
+    if (c->io != CARDID_CRAWL_IO_PREAD) w->use_uring = uring_init(&w->ring, (unsigned)c->depth);
+#endif
+    w->stats.io_uring = w->use_uring;
+    return true;
+}
+
+static void worker_free(worker* w) {
+    // Read buffers held file contents, PANs included.
+    if (w->bufs) cardid_secure_zero(w->bufs, (size_t)w->c->depth * w->c->buffer_size);
+    free(w->bufs);
+    free(w->res);
+    free(w->done);
+    free(w->line.p);
+#ifdef CRAWL_HAVE_URING
+    if (w->use_uring) uring_free(&w->ring);
+#endif
+}
+
+// io_uring can be compiled in yet refused at run time (old kernel, seccomp,
+// io_uring_disabled sysctl), so IO_URING mode checks before starting.
+static bool uring_available(void) {
+#ifdef CRAWL_HAVE_URING
+    uring r;
+    if (!uring_init(&r, 1)) return false;
+    uring_free(&r);
+    return true;
+#else
+    return false;
+#endif
+}
+
+cardid_status cardid_crawl(const char* const* roots, size_t root_count, FILE* report,
+                           const cardid_crawl_config* cfg, cardid_crawl_stats* stats) {
+    if (stats) memset(stats, 0, sizeof(*stats));
+    if (!roots || !report || !cfg || cfg->threads < 0 || cfg->queue_depth < 0) return CARDID_ERR_ARG;
+    if (cfg->io == CARDID_CRAWL_IO_URING && !uring_available()) return CARDID_ERR_IO;
+
+    crawl c;
+    memset(&c, 0, sizeof(c));
+    c.depth = cfg->queue_depth ? cfg->queue_depth : DEFAULT_DEPTH;
+    c.buffer_size = cfg->buffer_size ? cfg->buffer_size : DEFAULT_BUFFER;
+    if (c.buffer_size > (1u << 30)) return CARDID_ERR_ARG;  // io_uring read lengths are 32-bit
+    c.max_listed = cfg->max_listed ? cfg->max_listed : DEFAULT_LISTED;
+    c.io = cfg->io;
+    c.report = report;
+
+    int threads = cfg->threads;
+    if (threads == 0) {
+        long n = sysconf(_SC_NPROCESSORS_ONLN);
+        threads = n > 0 ? (int)n : 1;
+    }
+    if (threads > MAX_THREADS) threads = MAX_THREADS;
+    c.threads = threads;
+
+    cardid_status st = cfg->manifest_in ? manifest_load(&c.old, cfg->manifest_in) : CARDID_OK;
+    if (st != CARDID_OK) {
+        manifest_free(&c.old);
+        return st;
+    }
+
+    char* tmp_manifest = NULL;
+    if (cfg->manifest_out) {
+        size_t n = strlen(cfg->manifest_out);
+        tmp_manifest = malloc(n + 5);
+        if (tmp_manifest) {
+            memcpy(tmp_manifest, cfg->manifest_out, n);
+            memcpy(tmp_manifest + n, ".tmp", 5);
+            c.manifest_out = fopen(tmp_manifest, "w");
+        }
+        if (!c.manifest_out || fputs(MANIFEST_HEADER, c.manifest_out) < 0) {
+            if (c.manifest_out) fclose(c.manifest_out);
+            free(tmp_manifest);
+            manifest_free(&c.old);
+            return CARDID_ERR_IO;
+        }
+    }
+
+    pthread_mutex_init(&c.lock, NULL);
+    pthread_cond_init(&c.cond, NULL);
+    pthread_mutex_init(&c.out_lock, NULL);
+
+    worker* workers = calloc((size_t)threads, sizeof(worker));
+    if (!workers) crawl_fail(&c, CARDID_ERR_NOMEM);
+
+    // Roots are followed even when they are symlinks; nothing below them is.
+    unsigned long long root_failed = 0;
+    for (size_t i = 0; workers && i < root_count && !c.stop; ++i) {
+        struct stat sb;
+        char* path = roots[i] ? strdup(roots[i]) : NULL;
+        if (!path) {
+            crawl_fail(&c, roots[i] ? CARDID_ERR_NOMEM : CARDID_ERR_ARG);
+            break;
+        }
+        int err = stat(path, &sb) != 0 ? errno : 0;
+        if (err || (!S_ISDIR(sb.st_mode) && !S_ISREG(sb.st_mode))) {
+            worker tmp;
+            memset(&tmp, 0, sizeof(tmp));
+            tmp.c = &c;
+            report_error(&tmp, path, err ? err : EINVAL);
+            root_failed++;
+            free(path);
+            continue;
+        }
+        push_work(&c, path, S_ISDIR(sb.st_mode), 0);
+    }
+
+    int started = 0;
+    for (; workers && started < threads && !c.stop; ++started) {
+        if (!worker_init(&workers[started], &c)) {
+            worker_free(&workers[started]);
+            crawl_fail(&c, CARDID_ERR_NOMEM);
+            break;
+        }
+        if (pthread_create(&workers[started].tid, NULL, worker_main, &workers[started]) != 0) {
+            worker_free(&workers[started]);
+            if (started == 0) crawl_fail(&c, CARDID_ERR_NOMEM);
+            break;
+        }
+    }
+
+    cardid_crawl_stats total;
+    memset(&total, 0, sizeof(total));
+    total.files_failed = root_failed;
+    for (int i = 0; i < started; ++i) {
+        pthread_join(workers[i].tid, NULL);
+        cardid_crawl_stats* s = &workers[i].stats;
+        total.files_scanned += s->files_scanned;
+        total.files_skipped += s->files_skipped;
+        total.files_failed += s->files_failed;
+        total.bytes_scanned += s->bytes_scanned;
+        total.matches += s->matches;
+        total.files_with_matches += s->files_with_matches;
+        total.io_uring |= s->io_uring;
+        total.files_decompressed += s->files_decompressed;
+        worker_free(&workers[i]);
+    }
+    for (size_t i = 0; i < c.count; ++i) free(c.items[i].path);  // left over after a failure
+    free(c.items);
+    free(workers);
+
+    st = c.status;
+    if (st == CARDID_OK && fflush(report) != 0) st = CARDID_ERR_IO;
+    if (c.manifest_out) {
+        if (fclose(c.manifest_out) != 0 && st == CARDID_OK) st = CARDID_ERR_IO;
+        if (st == CARDID_OK && rename(tmp_manifest, cfg->manifest_out) != 0) st = CARDID_ERR_IO;
+        if (st != CARDID_OK) remove(tmp_manifest);
+    }
+    free(tmp_manifest);
+    manifest_free(&c.old);
+    pthread_mutex_destroy(&c.lock);
+    pthread_cond_destroy(&c.cond);
+    pthread_mutex_destroy(&c.out_lock);
+    if (stats) *stats = total;
+    return st;
+}
+
+#endif
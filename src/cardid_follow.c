@@ -0,0 +1,389 @@
+#if !defined(_WIN32) && !defined(_GNU_SOURCE)
+#define _GNU_SOURCE  // getline, pread, inotify_init1
+#endif
+#include "cardid_follow.h"
+#include <errno.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "cardid_internal.h"
+
+#if defined(_WIN32)
+
+cardid_follow* cardid_follow_open(const char* const* paths, size_t count,
+                                  const char* checkpoint_path) {
+    (void)paths;
+    (void)count;
+    (void)checkpoint_path;
+    return NULL;  // follow mode is POSIX-only for now
+}
+
+cardid_status cardid_follow_poll(cardid_follow* f, cardid_follow_callback cb, void* ctx,
+                                 cardid_follow_stats* stats) {
+    (void)f;
+    (void)cb;
+    (void)ctx;
+    (void)stats;
+    return CARDID_ERR_IO;
+}
+
+void cardid_follow_wait(cardid_follow* f, int timeout_ms) {
+    (void)f;
+    (void)timeout_ms;
+}
+
+bool cardid_follow_uses_inotify(const cardid_follow* f) {
+    (void)f;
+    return false;
+}
+
+cardid_status cardid_follow_save(cardid_follow* f) {
+    (void)f;
+    return CARDID_ERR_IO;
+}
+
+void cardid_follow_close(cardid_follow* f) {
+    (void)f;
+}
+
+#else
+
+#include <fcntl.h>
+#include <poll.h>
+#include <sys/stat.h>
+#include <time.h>
+#include <unistd.h>
+
+#if defined(__linux__)
+#include <sys/inotify.h>
+#define FOLLOW_HAVE_INOTIFY 1
+#endif
+
+#define READ_CHUNK (64u * 1024u)
+#define CHECKPOINT_HEADER "# cardid-follow v1\n"
+
+// One open file being tailed.
+typedef struct {
+    int fd;  // -1 when closed
+    uint64_t dev, ino;
+    uint64_t offset;  // bytes of fd fed to the scanner
+    cardid_scanner scanner;
+} tail;
+
+// A followed path: the file it names now, and the file it named before the last
+// rotation, which writers may still be appending to until they reopen the path.
+typedef struct {
+    char* path;
+    tail cur;
+    tail old;
+} followed;
+
+// Checkpoint entry as loaded; resume <= offset.
+typedef struct {
+    uint64_t dev, ino, offset, resume;
+} checkpoint_entry;
+
+struct cardid_follow {
+    followed* files;
+    size_t count;
+    char* checkpoint;
+    int notify_fd;  // inotify descriptor, or -1 for interval polling
+    char* buf;
+};
+
+// Opens path as t and positions it: at the checkpoint's resume offset when the
+// checkpoint describes this very file (same inode, not shrunk), else at 0.
+static void attach(tail* t, const char* path, const checkpoint_entry* cp) {
+    int fd = open(path, O_RDONLY | O_CLOEXEC | O_NOCTTY | O_NONBLOCK);
+    if (fd < 0) return;
+    struct stat st;
+    if (fstat(fd, &st) != 0 || !S_ISREG(st.st_mode)) {
+        close(fd);
+        return;
+    }
+    t->fd = fd;
+    t->dev = (uint64_t)st.st_dev;
+    t->ino = (uint64_t)st.st_ino;
+    uint64_t start = 0;
+    if (cp && cp->dev == t->dev && cp->ino == t->ino && (uint64_t)st.st_size >= cp->offset)
+        start = cp->resume;
+    t->offset = start;
+    cardid_scanner_init(&t->scanner, start);
+}
+
+static void detach(tail* t) {
+    if (t->fd >= 0) close(t->fd);
+    t->fd = -1;
+    cardid_secure_zero(&t->scanner, sizeof(t->scanner));
+}
+
+// Line format: <dev>\t<ino>\t<offset>\t<resume>\t<escaped path>
+static bool load_checkpoint(cardid_follow* f) {
+    FILE* in = fopen(f->checkpoint, "r");
+    if (!in) return errno == ENOENT;
+    bool ok = true;
+    char* line = NULL;
+    size_t cap = 0;
+    ssize_t n;
+    while (ok && (n = getline(&line, &cap, in)) > 0) {
+        if (line[n - 1] == '\n') line[--n] = '\0';
+        if (n == 0 || line[0] == '#') continue;
+        checkpoint_entry e;
+        char* p = line;
+        uint64_t* fields[4] = {&e.dev, &e.ino, &e.offset, &e.resume};
+        for (int i = 0; i < 4 && ok; ++i) {
+            *fields[i] = strtoull(p, &p, 10);
+            ok = *p++ == '\t';
+        }
+        if (!ok || e.resume > e.offset) {
+            ok = false;
+            break;
+        }
+        cardid_unescape_path(p);
+        for (size_t i = 0; i < f->count; ++i) {
+            followed* fl = &f->files[i];
+            if (fl->cur.fd < 0 && strcmp(fl->path, p) == 0) attach(&fl->cur, fl->path, &e);
+        }
+    }
+    free(line);
+    fclose(in);
+    return ok;
+}
+
+// Watches the parent directory of every path so creation, rename and deletion
+// are seen as well as appends.
+static void start_notify(cardid_follow* f) {
+    f->notify_fd = -1;
+#ifdef FOLLOW_HAVE_INOTIFY
+    int fd = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+    if (fd < 0) return;
+    int watched = 0;
+    for (size_t i = 0; i < f->count; ++i) {
+        const char* path = f->files[i].path;
+        const char* slash = strrchr(path, '/');
+        size_t len = slash ? (size_t)(slash - path) : 0;
+        char* dir = malloc(len + 2);
+        if (!dir) continue;
+        if (!slash) {
+            strcpy(dir, ".");
+        } else {
+            memcpy(dir, path, len ? len : 1);  // "/x" watches "/"
+            dir[len ? len : 1] = '\0';
+        }
+        // Adding the same directory twice returns the existing watch.
+        if (inotify_add_watch(fd, dir, IN_MODIFY | IN_CREATE | IN_MOVED_FROM | IN_MOVED_TO |
+                                           IN_DELETE | IN_CLOSE_WRITE) >= 0)
+            ++watched;
+        free(dir);
+    }
+    if (watched == 0) {
+        close(fd);
+        return;
+    }
+    f->notify_fd = fd;
+#endif
+}
+
+cardid_follow* cardid_follow_open(const char* const* paths, size_t count,
+                                  const char* checkpoint_path) {
+    if (!paths || count == 0) return NULL;
+    cardid_follow* f = calloc(1, sizeof(*f));
+    if (!f) return NULL;
+    f->notify_fd = -1;
+    f->files = calloc(count, sizeof(*f->files));
+    f->buf = malloc(READ_CHUNK);
+    bool ok = f->files && f->buf;
+    for (size_t i = 0; ok && i < count; ++i) {
+        f->files[i].cur.fd = f->files[i].old.fd = -1;
+        f->files[i].path = paths[i] ? strdup(paths[i]) : NULL;
+        ok = f->files[i].path != NULL;
+        f->count = i + 1;
+    }
+    if (ok && checkpoint_path) {
+        f->checkpoint = strdup(checkpoint_path);
+        ok = f->checkpoint && load_checkpoint(f);
+    }
+    if (!ok) {
+        cardid_follow_close(f);
+        return NULL;
+    }
+    for (size_t i = 0; i < count; ++i) {
+        if (f->files[i].cur.fd < 0) attach(&f->files[i].cur, f->files[i].path, NULL);
+    }
+    start_notify(f);
+    return f;
+}
+
+typedef struct {
+    cardid_follow_callback cb;
+    void* ctx;
+    const char* path;
+    cardid_follow_stats* stats;
+} match_sink;
+
+static void on_match(const cardid_scan_match* m, void* ctx) {
+    match_sink* sink = ctx;
+    sink->stats->matches++;
+    if (sink->cb) sink->cb(sink->path, m, sink->ctx);
+}
+
+// Feeds everything from t->offset to the current end of the file.
+static cardid_status drain(cardid_follow* f, tail* t, match_sink* sink) {
+    for (;;) {
+        ssize_t n = pread(t->fd, f->buf, READ_CHUNK, (off_t)t->offset);
+        if (n < 0 && errno == EINTR) continue;
+        if (n < 0) return CARDID_ERR_IO;
+        if (n == 0) return CARDID_OK;
+        cardid_scanner_feed(&t->scanner, f->buf, (size_t)n, on_match, sink);
+        t->offset += (uint64_t)n;
+        sink->stats->bytes += (uint64_t)n;
+    }
+}
+
+// End of a file for good: a PAN at its very end is complete, so report it.
+static void retire(tail* t, match_sink* sink) {
+    cardid_scanner_finish(&t->scanner, on_match, sink);
+    detach(t);
+}
+
+static cardid_status poll_file(cardid_follow* f, followed* fl, match_sink* sink) {
+    cardid_status status = CARDID_OK;
+    if (fl->old.fd >= 0) status = drain(f, &fl->old, sink);
+
+    // Two passes at most: the file we hold, then its replacement after a rotation.
+    for (int pass = 0; pass < 2 && status == CARDID_OK; ++pass) {
+        if (fl->cur.fd < 0) {
+            attach(&fl->cur, fl->path, NULL);
+            if (fl->cur.fd < 0) break;  // not there (yet)
+        }
+        struct stat st;
+        if (fstat(fl->cur.fd, &st) != 0) return CARDID_ERR_IO;
+        if ((uint64_t)st.st_size < fl->cur.offset) {
+            // Truncated in place: what was consumed is gone, start over at 0.
+            cardid_scanner_finish(&fl->cur.scanner, on_match, sink);
+            cardid_scanner_init(&fl->cur.scanner, 0);
+            fl->cur.offset = 0;
+            sink->stats->truncations++;
+        }
+        status = drain(f, &fl->cur, sink);
+
+        struct stat now;
+        if (status != CARDID_OK ||
+            (stat(fl->path, &now) == 0 && (uint64_t)now.st_dev == fl->cur.dev &&
+             (uint64_t)now.st_ino == fl->cur.ino))
+            break;
+        // Renamed away or deleted. A deleted file gets no more data; a renamed
+        // one may, until the writer reopens the path, so keep draining it.
+        sink->stats->rotations++;
+        if (fl->old.fd >= 0) retire(&fl->old, sink);
+        if (fstat(fl->cur.fd, &st) == 0 && st.st_nlink > 0) {
+            fl->old = fl->cur;
+            fl->cur.fd = -1;
+            cardid_secure_zero(&fl->cur.scanner, sizeof(fl->cur.scanner));
+        } else {
+            retire(&fl->cur, sink);
+        }
+    }
+
+    // Once the writer has moved on to the new file the old one is finished.
+    if (status == CARDID_OK && fl->old.fd >= 0 && fl->cur.fd >= 0 && fl->cur.offset > 0) {
+        status = drain(f, &fl->old, sink);
+        retire(&fl->old, sink);
+    }
+    return status;
+}
+
+cardid_status cardid_follow_poll(cardid_follow* f, cardid_follow_callback cb, void* ctx,
+                                 cardid_follow_stats* stats) {
+    if (!f) return CARDID_ERR_ARG;
+    cardid_follow_stats local;
+    memset(&local, 0, sizeof(local));
+    match_sink sink = {cb, ctx, NULL, stats ? stats : &local};
+    cardid_status result = CARDID_OK;
+    for (size_t i = 0; i < f->count; ++i) {
+        sink.path = f->files[i].path;
+        cardid_status st = poll_file(f, &f->files[i], &sink);
+        if (st != CARDID_OK) result = st;
+    }
+    return result;
+}
+
+void cardid_follow_wait(cardid_follow* f, int timeout_ms) {
+    if (timeout_ms < 0) timeout_ms = 0;
+    if (f && f->notify_fd >= 0) {
+        struct pollfd p = {f->notify_fd, POLLIN, 0};
+        if (poll(&p, 1, timeout_ms) > 0) {
+            char events[4096];
+            while (read(f->notify_fd, events, sizeof(events)) > 0) {
+            }  // contents do not matter: the next poll checks every file
+        }
+        return;
+    }
+    struct timespec ts = {timeout_ms / 1000, (long)(timeout_ms % 1000) * 1000000L};
+    while (nanosleep(&ts, &ts) != 0 && errno == EINTR) {
+    }
+}
+
+bool cardid_follow_uses_inotify(const cardid_follow* f) {
+    return f && f->notify_fd >= 0;
+}
+
+static void fput_path(const char* path, FILE* out) {
+    for (const char* p = path; *p; ++p) {
+        switch (*p) {
+            case '\\': fputs("\\\\", out); break;
+            case '\t': fputs("\\t", out); break;
+            case '\n': fputs("\\n", out); break;
+            case '\r': fputs("\\r", out); break;
+            default: fputc(*p, out);
+        }
+    }
+}
+
+cardid_status cardid_follow_save(cardid_follow* f) {
+    if (!f || !f->checkpoint) return CARDID_ERR_ARG;
+    size_t n = strlen(f->checkpoint);
+    char* tmp = malloc(n + 5);
+    if (!tmp) return CARDID_ERR_NOMEM;
+    memcpy(tmp, f->checkpoint, n);
+    memcpy(tmp + n, ".tmp", 5);
+    FILE* out = fopen(tmp, "w");
+    if (!out) {
+        free(tmp);
+        return CARDID_ERR_IO;
+    }
+    fputs(CHECKPOINT_HEADER, out);
+    for (size_t i = 0; i < f->count; ++i) {
+        const tail* t = &f->files[i].cur;
+        if (t->fd < 0) continue;
+        fprintf(out, "%llu\t%llu\t%llu\t%llu\t", (unsigned long long)t->dev,
+                (unsigned long long)t->ino, (unsigned long long)t->offset,
+                (unsigned long long)cardid_scanner_resume_offset(&t->scanner));
+        fput_path(f->files[i].path, out);
+        fputc('\n', out);
+    }
+    // Durable before it replaces the old checkpoint; a crash leaves either one.
+    bool ok = fflush(out) == 0 && fsync(fileno(out)) == 0;
+    ok = fclose(out) == 0 && ok;
+    ok = ok && rename(tmp, f->checkpoint) == 0;
+    if (!ok) remove(tmp);
+    free(tmp);
+    return ok ? CARDID_OK : CARDID_ERR_IO;
+}
+
+void cardid_follow_close(cardid_follow* f) {
+    if (!f) return;
+    for (size_t i = 0; i < f->count; ++i) {
+        detach(&f->files[i].cur);
+        detach(&f->files[i].old);
+        free(f->files[i].path);
+    }
+    if (f->buf) cardid_secure_zero(f->buf, READ_CHUNK);
+    if (f->notify_fd >= 0) close(f->notify_fd);
+    free(f->buf);
+    free(f->files);
+    free(f->checkpoint);
+    free(f);
+}
+
+#endif
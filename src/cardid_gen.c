@@ -0,0 +1,242 @@
+#include "cardid_gen.h"
+#include <string.h>
+#include "cardid_internal.h"
+
+// Luhn contribution of digit d, undoubled and doubled.
+static const int luhn_contrib[2][10] = {
+    {0, 1, 2, 3, 4, 5, 6, 7, 8, 9},
+    {0, 2, 4, 6, 8, 1, 3, 5, 7, 9},
+};
+
+static const char junk[] = "abcdefxyzXYZ#$%&*+/:;=?@_|~.,";
+
+// xoshiro256** seeded through splitmix64.
+static uint64_t splitmix64(uint64_t* x) {
+    uint64_t z = (*x += 0x9e3779b97f4a7c15ULL);
+    z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ULL;
+    z = (z ^ (z >> 27)) * 0x94d049bb133111ebULL;
+    return z ^ (z >> 31);
+}
+
+static inline uint64_t rotl(uint64_t x, int k) {
+    return (x << k) | (x >> (64 - k));
+}
+
+static inline uint64_t next_u64(cardid_gen* g) {
+    uint64_t* s = g->rng;
+    uint64_t result = rotl(s[1] * 5, 7) * 9;
+    uint64_t t = s[1] << 17;
+    s[2] ^= s[0];
+    s[3] ^= s[1];
+    s[1] ^= s[2];
+    s[0] ^= s[3];
+    s[2] ^= t;
+    s[3] = rotl(s[3], 45);
+    return result;
+}
+
+static inline double next_unit(cardid_gen* g) {
+    return (double)(next_u64(g) >> 11) * 0x1.0p-53;
+}
+
+static inline uint32_t next_below(cardid_gen* g, uint32_t n) {
+    return (uint32_t)(((next_u64(g) >> 32) * n) >> 32);
+}
+
+static double rule_weight(const cardid_network_rule* r, const double* length_weight,
+                          bool any_length_weight) {
+    if (any_length_weight) {
+        bool issuable = false;
+        for (int len = 0; len <= CARDID_MAX_DIGITS; ++len) {
+            if ((r->lengths & (1u << len)) && length_weight[len] > 0) issuable = true;
+        }
+        if (!issuable) return 0;
+    }
+    // Share of the network's six-digit BIN space covered by this rule.
+    double span = (double)(r->hi - r->lo + 1);
+    for (int i = r->prefix_len; i < 6; ++i) span *= 10;
+    return span;
+}
+
+cardid_status cardid_gen_init(cardid_gen* gen, const cardid_gen_config* cfg) {
+    if (!gen || !cfg) return CARDID_ERR_ARG;
+    if (cardid_network_rule_count > (int)(sizeof(gen->rule_cdf) / sizeof(gen->rule_cdf[0]))) {
+        return CARDID_ERR_ARG;
+    }
+    if (cfg->invalid_rate < 0 || cfg->separator_rate < 0 || cfg->garbage_rate < 0) {
+        return CARDID_ERR_ARG;
+    }
+    memset(gen, 0, sizeof(*gen));
+
+    bool any_network = false, any_length = false;
+    for (int n = CARD_VISA; n <= CARD_DISCOVER; ++n) {
+        if (cfg->network_weight[n] < 0) return CARDID_ERR_ARG;
+        if (cfg->network_weight[n] > 0) any_network = true;
+    }
+    for (int len = 0; len <= CARDID_MAX_DIGITS; ++len) {
+        if (cfg->length_weight[len] < 0) return CARDID_ERR_ARG;
+        if (cfg->length_weight[len] > 0) any_length = true;
+    }
+    for (int len = 0; len <= CARDID_MAX_DIGITS; ++len) {
+        gen->length_weight[len] = any_length ? cfg->length_weight[len] : 1.0;
+    }
+
+    // Network weight is split across its rules by prefix space, then cumulated.
+    double network_total[CARD_DISCOVER + 1] = {0};
+    for (int i = 0; i < cardid_network_rule_count; ++i) {
+        const cardid_network_rule* r = &cardid_network_rules[i];
+        network_total[r->network] += rule_weight(r, cfg->length_weight, any_length);
+    }
+    double total = 0;
+    for (int i = 0; i < cardid_network_rule_count; ++i) {
+        const cardid_network_rule* r = &cardid_network_rules[i];
+        double w = any_network ? cfg->network_weight[r->network] : 1.0;
+        double share = rule_weight(r, cfg->length_weight, any_length);
+        if (network_total[r->network] > 0) total += w * share / network_total[r->network];
+        gen->rule_cdf[i] = total;
+    }
+    if (total <= 0) return CARDID_ERR_ARG;
+    for (int i = 0; i < cardid_network_rule_count; ++i) gen->rule_cdf[i] /= total;
+
+    uint64_t seed = cfg->seed;
+    for (int i = 0; i < 4; ++i) gen->rng[i] = splitmix64(&seed);
+    gen->invalid_rate = cfg->invalid_rate;
+    gen->separator_rate = cfg->separator_rate;
+    gen->garbage_rate = cfg->garbage_rate;
+    return CARDID_OK;
+}
+
+static int pick_length(cardid_gen* g, unsigned lengths) {
+    double total = 0;
+    for (int len = 0; len <= CARDID_MAX_DIGITS; ++len) {
+        if (lengths & (1u << len)) total += g->length_weight[len];
+    }
+    double u = next_unit(g) * total;
+    int last = 0;
+    for (int len = 0; len <= CARDID_MAX_DIGITS; ++len) {
+        if (!(lengths & (1u << len)) || g->length_weight[len] <= 0) continue;
+        last = len;
+        if (u < g->length_weight[len]) return len;
+        u -= g->length_weight[len];
+    }
+    return last;
+}
+
+int cardid_gen_next(cardid_gen* g, char* out) {
+    double u = next_unit(g);
+    int rule = 0;
+    while (rule < cardid_network_rule_count - 1 && u >= g->rule_cdf[rule]) ++rule;
+    const cardid_network_rule* r = &cardid_network_rules[rule];
+    int len = pick_length(g, r->lengths);
+
+    char pan[CARDID_MAX_DIGITS];
+    int prefix = r->lo + (int)next_below(g, (uint32_t)(r->hi - r->lo + 1));
+    for (int i = r->prefix_len - 1; i >= 0; --i, prefix /= 10) pan[i] = (char)('0' + prefix % 10);
+    uint64_t bits = next_u64(g);
+    for (int i = r->prefix_len; i < len - 1; ++i) {
+        pan[i] = (char)('0' + bits % 10);
+        bits /= 10;
+        if (bits < 10) bits = next_u64(g);
+    }
+
+    int sum = 0;
+    for (int i = 0; i < len - 1; ++i) sum += luhn_contrib[(len - 1 - i) & 1][pan[i] - '0'];
+    int check = (10 - sum % 10) % 10;
+    if (next_unit(g) < g->invalid_rate) check = (check + 1 + (int)next_below(g, 9)) % 10;
+    pan[len - 1] = (char)('0' + check);
+
+    int n = 0;
+    if (next_unit(g) < g->separator_rate) {
+        char sep = next_u64(g) & 1 ? ' ' : '-';
+        for (int i = 0; i < len; ++i) {
+            bool split = len == 15 ? (i == 4 || i == 10) : (i > 0 && i % 4 == 0);
+            if (split) out[n++] = sep;
+            out[n++] = pan[i];
+        }
+    } else {
+        memcpy(out, pan, (size_t)len);
+        n = len;
+    }
+
+    if (next_unit(g) < g->garbage_rate) {
+        int count = 1 + (int)next_below(g, 3);
+        for (int k = 0; k < count; ++k) {
+            int at = (int)next_below(g, (uint32_t)n + 1);
+            memmove(out + at + 1, out + at, (size_t)(n - at));
+            out[at] = junk[next_below(g, (uint32_t)(sizeof(junk) - 1))];
+            ++n;
+        }
+    }
+    return n;
+}
+
+size_t cardid_gen_fill(cardid_gen* gen, cardid_gen_format format, char* buf, size_t cap,
+                       size_t max_records, size_t* records) {
+    size_t used = 0, count = 0;
+    while (count < max_records && cap - used >= CARDID_GEN_MAX_TEXT + 1) {
+        if (format == CARDID_GEN_BINARY) {
+            int n = cardid_gen_next(gen, buf + used + 1);
+            buf[used] = (char)n;
+            used += (size_t)n + 1;
+        } else {
+            int n = cardid_gen_next(gen, buf + used);
+            buf[used + (size_t)n] = '\n';
+            used += (size_t)n + 1;
+        }
+        ++count;
+    }
+    if (records) *records = count;
+    return used;
+}
+
+cardid_status cardid_bin_enum_init(cardid_bin_enum* e, const char* prefix_lo, const char* prefix_hi,
+                                   int len) {
+    if (!e || !prefix_lo || !prefix_hi) return CARDID_ERR_ARG;
+    size_t plen = strlen(prefix_lo);
+    if (plen == 0 || plen != strlen(prefix_hi) || len > CARDID_MAX_DIGITS || (int)plen >= len) {
+        return CARDID_ERR_ARG;
+    }
+    for (size_t i = 0; i < plen; ++i) {
+        if ((unsigned)(prefix_lo[i] - '0') > 9 || (unsigned)(prefix_hi[i] - '0') > 9) {
+            return CARDID_ERR_ARG;
+        }
+    }
+    if (strcmp(prefix_lo, prefix_hi) > 0) return CARDID_ERR_ARG;
+
+    memset(e, 0, sizeof(*e));
+    e->len = len;
+    memcpy(e->digits, prefix_lo, plen);
+    memset(e->digits + plen, '0', (size_t)len - plen);
+    // Count = (hi - lo + 1) * 10^(account digits); at most 10^18 for 19 digits.
+    uint64_t lo = 0, hi = 0;
+    for (size_t i = 0; i < plen; ++i) {
+        lo = lo * 10 + (uint64_t)(prefix_lo[i] - '0');
+        hi = hi * 10 + (uint64_t)(prefix_hi[i] - '0');
+    }
+    e->remaining = hi - lo + 1;
+    for (int i = (int)plen; i < len - 1; ++i) e->remaining *= 10;
+
+    for (int i = 0; i < len - 1; ++i) e->sum += luhn_contrib[(len - 1 - i) & 1][e->digits[i] - '0'];
+    return CARDID_OK;
+}
+
+const char* cardid_bin_enum_next(cardid_bin_enum* e) {
+    if (!e || e->remaining == 0) return NULL;
+    if (e->started) {
+        // Increment the digits before the check digit, patching the Luhn sum for
+        // each digit that changes. Carries average out to O(1) per step.
+        int i = e->len - 2;
+        while (e->digits[i] == '9') {
+            e->sum -= luhn_contrib[(e->len - 1 - i) & 1][9];
+            e->digits[i--] = '0';
+        }
+        int d = e->digits[i] - '0';
+        int odd = (e->len - 1 - i) & 1;
+        e->sum += luhn_contrib[odd][d + 1] - luhn_contrib[odd][d];
+        e->digits[i] = (char)('0' + d + 1);
+    }
+    e->started = true;
+    e->digits[e->len - 1] = (char)('0' + (10 - e->sum % 10) % 10);
+    e->remaining--;
+    return e->digits;
+}
@@ -0,0 +1,200 @@
+#pragma once
+// Internal helpers shared by the library translation units. Not installed.
+
+#include <stddef.h>
+#include <stdint.h>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define CARDID_HAVE_SSE2 1
+#include <emmintrin.h>
+#endif
+
+#if defined(_MSC_VER)
+#include <intrin.h>
+static __inline int cardid_ctz32(unsigned x) {
+    unsigned long i;
+    _BitScanForward(&i, x);
+    return (int)i;
+}
+#else
+#define cardid_ctz32(x) __builtin_ctz(x)
+#endif
+
+// Structural scan: first byte in [p, end) equal to a, b or c, or end if none.
+// Processes 16 bytes per step with SSE2 and falls back to a byte loop elsewhere.
+static inline const char* cardid_find_any3(const char* p, const char* end, char a, char b,
+                                           char c) {
+#ifdef CARDID_HAVE_SSE2
+    const __m128i va = _mm_set1_epi8(a);
+    const __m128i vb = _mm_set1_epi8(b);
+    const __m128i vc = _mm_set1_epi8(c);
+    while (end - p >= 16) {
+        __m128i x = _mm_loadu_si128((const __m128i*)p);
+        __m128i hit = _mm_or_si128(_mm_or_si128(_mm_cmpeq_epi8(x, va), _mm_cmpeq_epi8(x, vb)),
+                                   _mm_cmpeq_epi8(x, vc));
+        int mask = _mm_movemask_epi8(hit);
+        if (mask) return p + cardid_ctz32((unsigned)mask);
+        p += 16;
+    }
+#endif
+    for (; p < end; ++p) {
+        if (*p == a || *p == b || *p == c) return p;
+    }
+    return end;
+}
+
+// First ASCII digit in [p, end), or end if none. Same 16-byte stepping as above:
+// a byte is a digit when min(x - '0', 9) == x - '0' (unsigned).
+static inline const char* cardid_find_digit(const char* p, const char* end) {
+#ifdef CARDID_HAVE_SSE2
+    const __m128i zero = _mm_set1_epi8('0');
+    const __m128i nine = _mm_set1_epi8(9);
+    while (end - p >= 16) {
+        __m128i x = _mm_sub_epi8(_mm_loadu_si128((const __m128i*)p), zero);
+        int mask = _mm_movemask_epi8(_mm_cmpeq_epi8(_mm_min_epu8(x, nine), x));
+        if (mask) return p + cardid_ctz32((unsigned)mask);
+        p += 16;
+    }
+#endif
+    for (; p < end; ++p) {
+        if ((unsigned char)(*p - '0') <= 9) return p;
+    }
+    return end;
+}
+
+// Testing only: when nonzero, every read cardid_crawl issues asks for at most
+// this many bytes, so its short-read handling runs on any filesystem. Set it
+// before the crawl starts.
+extern size_t cardid_crawl_read_limit;
+
+// Testing only: record numbers cardid_results_writer_close places per pass when
+// building the BIN postings. Lower it to run the multi-pass path on small files.
+extern size_t cardid_results_posting_chunk;
+
+// Paths in line-oriented state files (crawl manifest, follow checkpoint) are
+// stored with \\, \t, \n and \r escaped; this undoes that in place.
+static inline void cardid_unescape_path(char* s) {
+    char* out = s;
+    for (const char* p = s; *p; ++p) {
+        if (*p == '\\' && p[1]) {
+            ++p;
+            *out++ = *p == 't' ? '\t' : *p == 'n' ? '\n' : *p == 'r' ? '\r' : *p;
+        } else {
+            *out++ = *p;
+        }
+    }
+    *out = '\0';
+}
+
+// cardid_analyze_n without the argument checks that also hands back the
+// extracted digits (digits must hold CARDID_MAX_DIGITS + 1 bytes). Batch paths
+// use it to post-process the PAN without extracting it twice.
+#include "cardid.h"
+cardid_outcome cardid_analyze_into(const char* input, size_t input_len, cardid_result* out,
+                                   cardid_extract_result* extract_meta, char* digits);
+
+// Digit buffer for a batch: taken from the thread's scratch arena when one is
+// available (locked, not dumped) and wiped once when the batch ends.
+#include "cardid_scratch.h"
+typedef struct {
+    cardid_scratch* arena;
+    size_t mark;
+    char* digits;
+    char local[CARDID_MAX_DIGITS + 1];
+} cardid_digit_scratch;
+
+static inline void cardid_digit_scratch_begin(cardid_digit_scratch* s) {
+    s->arena = cardid_scratch_thread();
+    s->mark = cardid_scratch_mark(s->arena);
+    s->digits = (char*)cardid_scratch_alloc(s->arena, CARDID_MAX_DIGITS + 1);
+    if (!s->digits) s->digits = s->local;
+}
+
+static inline void cardid_digit_scratch_end(cardid_digit_scratch* s) {
+    if (s->digits == s->local) {
+        cardid_secure_zero(s->local, sizeof(s->local));
+    } else {
+        cardid_scratch_release(s->arena, s->mark);
+    }
+}
+
+// One issuer prefix range: PANs whose first prefix_len digits fall in [lo, hi]
+// and whose length has its bit set in lengths belong to network.
+typedef struct {
+    cardid_network network;
+    int prefix_len;
+    int lo, hi;
+    unsigned lengths;
+} cardid_network_rule;
+
+extern const cardid_network_rule cardid_network_rules[];
+extern const int cardid_network_rule_count;
+
+// Monotonic clock in nanoseconds.
+uint64_t cardid_now_ns(void);
+
+// ---------------------------------------------------------------------------
+// Metrics hooks (see cardid_metrics.h). CARDID_METRICS is set by the build; with
+// it off, or without C11 atomics, every hook below expands to nothing.
+
+#if defined(CARDID_METRICS) && CARDID_METRICS && !defined(__STDC_NO_ATOMICS__)
+#include <stdatomic.h>
+#include <stdint.h>
+#include "cardid.h"
+
+#if defined(_MSC_VER)
+#define CARDID_THREAD_LOCAL __declspec(thread)
+#else
+#define CARDID_THREAD_LOCAL _Thread_local
+#endif
+
+// Batch entry points with a latency histogram.
+typedef enum {
+    CARDID_PATH_ANALYZE_BATCH = 0,
+    CARDID_PATH_RECORD_STREAM,
+    CARDID_PATH_TOKENIZE_BATCH,
+    CARDID_PATH_COUNT
+} cardid_metrics_path;
+
+#define CARDID_HIST_BUCKETS 12  // <=1us, <=4us, ... <=1s (x4 steps), +Inf
+
+// One per thread, owned and written only by that thread; readers sum them.
+// Aligned and sized to whole cache lines so neighbouring slots never share one.
+typedef struct cardid_metrics_slot {
+    _Alignas(64) _Atomic uint64_t outcome[CARDID_OUTCOME_COUNT];
+    _Atomic uint64_t network[CARD_DISCOVER + 1];
+    _Atomic uint64_t hist[CARDID_PATH_COUNT][CARDID_HIST_BUCKETS];
+    _Atomic uint64_t hist_sum_ns[CARDID_PATH_COUNT];
+    struct cardid_metrics_slot* next;
+} cardid_metrics_slot;
+
+extern atomic_bool cardid_metrics_on;
+extern CARDID_THREAD_LOCAL cardid_metrics_slot* cardid_metrics_tls;
+cardid_metrics_slot* cardid_metrics_attach(void);
+void cardid_metrics_batch(cardid_metrics_path path, uint64_t start_ns);
+
+// Single writer per slot, so a relaxed load/store pair is enough (a plain add).
+#define CARDID_BUMP(counter) \
+    atomic_store_explicit(&(counter), atomic_load_explicit(&(counter), memory_order_relaxed) + 1, \
+                          memory_order_relaxed)
+
+static inline void cardid_metrics_outcome(cardid_outcome o, cardid_network n) {
+    if (!atomic_load_explicit(&cardid_metrics_on, memory_order_relaxed)) return;
+    cardid_metrics_slot* s = cardid_metrics_tls;
+    if (!s && !(s = cardid_metrics_attach())) return;
+    CARDID_BUMP(s->outcome[o]);
+    if (o == CARDID_OUTCOME_VALID) CARDID_BUMP(s->network[n]);
+}
+
+#define CARDID_METRICS_OUTCOME(o, n) cardid_metrics_outcome((o), (n))
+#define CARDID_METRICS_BATCH_START(var) \
+    uint64_t var = atomic_load_explicit(&cardid_metrics_on, memory_order_relaxed) ? cardid_now_ns() : 0
+#define CARDID_METRICS_BATCH_END(path, var) \
+    do { \
+        if (var) cardid_metrics_batch((path), var); \
+    } while (0)
+#else
+#define CARDID_METRICS_OUTCOME(o, n) ((void)0)
+#define CARDID_METRICS_BATCH_START(var) ((void)0)
+#define CARDID_METRICS_BATCH_END(path, var) ((void)0)
+#endif
@@ -0,0 +1,189 @@
+#if !defined(_WIN32) && !defined(_POSIX_C_SOURCE)
+#define _POSIX_C_SOURCE 200809L
+#endif
+#include "cardid_metrics.h"
+#include <stdarg.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "cardid_internal.h"
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <time.h>
+#endif
+
+uint64_t cardid_now_ns(void) {
+#ifdef _WIN32
+    static LARGE_INTEGER freq;
+    LARGE_INTEGER now;
+    if (!freq.QuadPart) QueryPerformanceFrequency(&freq);
+    QueryPerformanceCounter(&now);
+    return (uint64_t)((double)now.QuadPart * 1e9 / (double)freq.QuadPart);
+#else
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000u + (uint64_t)ts.tv_nsec;
+#endif
+}
+
+#if defined(CARDID_METRICS) && CARDID_METRICS && !defined(__STDC_NO_ATOMICS__)
+
+atomic_bool cardid_metrics_on = false;
+CARDID_THREAD_LOCAL cardid_metrics_slot* cardid_metrics_tls = NULL;
+static _Atomic(cardid_metrics_slot*) slots = NULL;
+
+static const char* const outcome_labels[CARDID_OUTCOME_COUNT] = {
+    "valid", "empty", "overflow", "bad_length", "length_filtered", "luhn_fail", "unknown_network",
+};
+static const char* const path_labels[CARDID_PATH_COUNT] = {
+    "analyze_batch", "record_stream", "tokenize_batch",
+};
+static const char* const bucket_labels[CARDID_HIST_BUCKETS - 1] = {
+    "1e-06", "4e-06", "1.6e-05", "6.4e-05", "0.000256", "0.001024",
+    "0.004096", "0.016384", "0.065536", "0.262144", "1.048576",
+};
+
+// Slots are never freed: a thread's counts must survive the thread.
+cardid_metrics_slot* cardid_metrics_attach(void) {
+    cardid_metrics_slot* s;
+    void* raw = calloc(1, sizeof(*s) + 64);
+    if (!raw) return NULL;
+    s = (cardid_metrics_slot*)(((uintptr_t)raw + 63) & ~(uintptr_t)63);
+    cardid_metrics_slot* head = atomic_load_explicit(&slots, memory_order_relaxed);
+    do {
+        s->next = head;
+    } while (!atomic_compare_exchange_weak_explicit(&slots, &head, s, memory_order_release,
+                                                    memory_order_relaxed));
+    cardid_metrics_tls = s;
+    return s;
+}
+
+// Buckets grow by x4 from 1us: index = ceil(log4(ns / 1000)), clamped.
+static int bucket_of(uint64_t ns) {
+    int b = 0;
+    for (uint64_t limit = 1000; b < CARDID_HIST_BUCKETS - 1 && ns > limit; limit <<= 2) ++b;
+    return b;
+}
+
+void cardid_metrics_batch(cardid_metrics_path path, uint64_t start_ns) {
+    cardid_metrics_slot* s = cardid_metrics_tls;
+    if (!s && !(s = cardid_metrics_attach())) return;
+    uint64_t ns = cardid_now_ns() - start_ns;
+    CARDID_BUMP(s->hist[path][bucket_of(ns)]);
+    atomic_store_explicit(&s->hist_sum_ns[path],
+                          atomic_load_explicit(&s->hist_sum_ns[path], memory_order_relaxed) + ns,
+                          memory_order_relaxed);
+}
+
+bool cardid_metrics_available(void) {
+    return true;
+}
+
+void cardid_metrics_enable(bool on) {
+    atomic_store_explicit(&cardid_metrics_on, on, memory_order_relaxed);
+}
+
+bool cardid_metrics_enabled(void) {
+    return atomic_load_explicit(&cardid_metrics_on, memory_order_relaxed);
+}
+
+#define LOAD(c) atomic_load_explicit(&(c), memory_order_relaxed)
+
+void cardid_metrics_read(cardid_metrics_snapshot* out) {
+    if (!out) return;
+    memset(out, 0, sizeof(*out));
+    for (cardid_metrics_slot* s = atomic_load_explicit(&slots, memory_order_acquire); s;
+         s = s->next) {
+        for (int i = 0; i < CARDID_OUTCOME_COUNT; ++i) out->outcome[i] += LOAD(s->outcome[i]);
+        for (int i = 0; i <= CARD_DISCOVER; ++i) out->network[i] += LOAD(s->network[i]);
+    }
+}
+
+typedef struct {
+    char* buf;
+    size_t cap;
+    size_t len;
+} text_out;
+
+static void emit(text_out* t, const char* fmt, ...) {
+    va_list ap;
+    va_start(ap, fmt);
+    size_t room = t->len < t->cap ? t->cap - t->len : 0;
+    int n = vsnprintf(room ? t->buf + t->len : NULL, room, fmt, ap);
+    va_end(ap);
+    if (n > 0) t->len += (size_t)n;
+}
+
+size_t cardid_metrics_format_prometheus(char* buf, size_t cap) {
+    text_out t = {buf, buf ? cap : 0, 0};
+    if (t.cap) buf[0] = '\0';
+
+    cardid_metrics_snapshot snap;
+    cardid_metrics_read(&snap);
+    uint64_t hist[CARDID_PATH_COUNT][CARDID_HIST_BUCKETS] = {{0}};
+    uint64_t sum_ns[CARDID_PATH_COUNT] = {0};
+    for (cardid_metrics_slot* s = atomic_load_explicit(&slots, memory_order_acquire); s;
+         s = s->next) {
+        for (int p = 0; p < CARDID_PATH_COUNT; ++p) {
+            for (int b = 0; b < CARDID_HIST_BUCKETS; ++b) hist[p][b] += LOAD(s->hist[p][b]);
+            sum_ns[p] += LOAD(s->hist_sum_ns[p]);
+        }
+    }
+
+    emit(&t, "# HELP cardid_analyze_total Analyses by outcome.\n"
+             "# TYPE cardid_analyze_total counter\n");
+    for (int i = 0; i < CARDID_OUTCOME_COUNT; ++i) {
+        emit(&t, "cardid_analyze_total{outcome=\"%s\"} %llu\n", outcome_labels[i],
+             (unsigned long long)snap.outcome[i]);
+    }
+    emit(&t, "# HELP cardid_network_total Valid analyses by card network.\n"
+             "# TYPE cardid_network_total counter\n");
+    for (int i = CARD_VISA; i <= CARD_DISCOVER; ++i) {
+        emit(&t, "cardid_network_total{network=\"%s\"} %llu\n",
+             cardid_network_name((cardid_network)i), (unsigned long long)snap.network[i]);
+    }
+    emit(&t, "# HELP cardid_batch_duration_seconds Wall time per batch call; record_stream: "
+             "per 1 MiB input buffer, output writes included.\n"
+             "# TYPE cardid_batch_duration_seconds histogram\n");
+    for (int p = 0; p < CARDID_PATH_COUNT; ++p) {
+        unsigned long long cumulative = 0;
+        for (int b = 0; b < CARDID_HIST_BUCKETS; ++b) {
+            cumulative += hist[p][b];
+            emit(&t, "cardid_batch_duration_seconds_bucket{path=\"%s\",le=\"%s\"} %llu\n",
+                 path_labels[p], b < CARDID_HIST_BUCKETS - 1 ? bucket_labels[b] : "+Inf",
+                 cumulative);
+        }
+        emit(&t, "cardid_batch_duration_seconds_sum{path=\"%s\"} %.9f\n", path_labels[p],
+             (double)sum_ns[p] / 1e9);
+        emit(&t, "cardid_batch_duration_seconds_count{path=\"%s\"} %llu\n", path_labels[p],
+             cumulative);
+    }
+    return t.len;
+}
+
+#else  // metrics compiled out
+
+bool cardid_metrics_available(void) {
+    return false;
+}
+
+void cardid_metrics_enable(bool on) {
+    (void)on;
+}
+
+bool cardid_metrics_enabled(void) {
+    return false;
+}
+
+void cardid_metrics_read(cardid_metrics_snapshot* out) {
+    if (out) memset(out, 0, sizeof(*out));
+}
+
+size_t cardid_metrics_format_prometheus(char* buf, size_t cap) {
+    if (buf && cap) buf[0] = '\0';
+    return 0;
+}
+
+#endif
@@ -0,0 +1,63 @@
+#pragma once
+// SystemTap-compatible USDT tracepoints (provider "cardid"), usable from
+// bpftrace, perf and stap without rebuilding:
+//
+//   bpftrace -e 'usdt:./cardid:cardid:reject { @[arg0] = count(); }'
+//
+// Probes carry lengths, networks and cardid_outcome codes only, never digits.
+// Each probe site is a single NOP until a tracer attaches. Argument prep that
+// costs more than a register move is guarded by the probe's semaphore, which a
+// tracer increments while attached. Without CARDID_USDT or <sys/sdt.h> every
+// macro below expands to nothing.
+
+#if defined(CARDID_USDT) && CARDID_USDT && defined(__has_include)
+#if __has_include(<sys/sdt.h>)
+#define _SDT_HAS_SEMAPHORES 1
+#include <sys/sdt.h>
+#define CARDID_HAVE_USDT 1
+#endif
+#endif
+
+#ifdef CARDID_HAVE_USDT
+
+// sdt.h locates each probe's semaphore by the name provider_probe_semaphore.
+#define CARDID_PROBE_SEMAPHORE(name) cardid_##name##_semaphore
+#define CARDID_PROBE_SEMAPHORE_DEFINE(name) \
+    __attribute__((section(".probes"), used, visibility("hidden"))) \
+    unsigned short CARDID_PROBE_SEMAPHORE(name)
+#define CARDID_PROBE_ENABLED(name) __builtin_expect(CARDID_PROBE_SEMAPHORE(name) != 0, 0)
+
+#define CARDID_PROBE_PEDANTIC_OFF \
+    _Pragma("GCC diagnostic push") _Pragma("GCC diagnostic ignored \"-Wpedantic\"")
+#define CARDID_PROBE_PEDANTIC_ON _Pragma("GCC diagnostic pop")
+
+#define CARDID_PROBE1(name, a) \
+    do { \
+        CARDID_PROBE_PEDANTIC_OFF STAP_PROBE1(cardid, name, a); \
+        CARDID_PROBE_PEDANTIC_ON \
+    } while (0)
+#define CARDID_PROBE2(name, a, b) \
+    do { \
+        CARDID_PROBE_PEDANTIC_OFF STAP_PROBE2(cardid, name, a, b); \
+        CARDID_PROBE_PEDANTIC_ON \
+    } while (0)
+#define CARDID_PROBE3(name, a, b, c) \
+    do { \
+        CARDID_PROBE_PEDANTIC_OFF STAP_PROBE3(cardid, name, a, b, c); \
+        CARDID_PROBE_PEDANTIC_ON \
+    } while (0)
+#define CARDID_PROBE4(name, a, b, c, d) \
+    do { \
+        CARDID_PROBE_PEDANTIC_OFF STAP_PROBE4(cardid, name, a, b, c, d); \
+        CARDID_PROBE_PEDANTIC_ON \
+    } while (0)
+
+#else
+
+#define CARDID_PROBE_ENABLED(name) 0
+#define CARDID_PROBE1(name, a) ((void)0)
+#define CARDID_PROBE2(name, a, b) ((void)0)
+#define CARDID_PROBE3(name, a, b, c) ((void)0)
+#define CARDID_PROBE4(name, a, b, c, d) ((void)0)
+
+#endif
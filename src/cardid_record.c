@@ -0,0 +1,336 @@
+#include "cardid_record.h"
+#include <stdlib.h>
+#include <string.h>
+#include "cardid_internal.h"
+
+#define READ_CHUNK (1u << 20)
+
+static char field_delimiter(const cardid_record_config* cfg) {
+    if (cfg->format == CARDID_RECORD_TSV) return '\t';
+    return cfg->delimiter ? cfg->delimiter : ',';
+}
+
+static int is_ws(char c) {
+    return c == ' ' || c == '\t' || c == '\r' || c == '\n';
+}
+
+// Returns the closing quote of the JSON string whose opening quote precedes p.
+static const char* json_string_end(const char* p, const char* end) {
+    for (;;) {
+        p = cardid_find_any3(p, end, '"', '\\', '\\');
+        if (p >= end) return end;
+        if (*p == '"') return p;
+        p += 2;  // skip the escaped character
+        if (p >= end) return end;
+    }
+}
+
+// Skips one JSON value starting at p; returns the first byte after it.
+static const char* json_skip_value(const char* p, const char* end) {
+    if (p < end && *p == '"') {
+        p = json_string_end(p + 1, end);
+        return p < end ? p + 1 : end;
+    }
+    if (p < end && (*p == '{' || *p == '[')) {
+        int depth = 0;
+        while (p < end) {
+            char c = *p;
+            if (c == '"') {
+                p = json_string_end(p + 1, end);
+                if (p >= end) return end;
+            } else if (c == '{' || c == '[') {
+                ++depth;
+            } else if (c == '}' || c == ']') {
+                if (--depth == 0) return p + 1;
+            }
+            ++p;
+        }
+        return end;
+    }
+    while (p < end && *p != ',' && *p != '}' && *p != ']' && !is_ws(*p)) ++p;
+    return p;
+}
+
+static bool ndjson_field(const char* key, const char* p, const char* end, const char** field,
+                         size_t* field_len) {
+    size_t key_len = strlen(key);
+    while (p < end && is_ws(*p)) ++p;
+    if (p >= end || *p != '{') return false;
+    ++p;
+    for (;;) {
+        while (p < end && (is_ws(*p) || *p == ',')) ++p;
+        if (p >= end || *p != '"') return false;
+        const char* k = p + 1;
+        const char* k_end = json_string_end(k, end);
+        if (k_end >= end) return false;
+        p = k_end + 1;
+        while (p < end && is_ws(*p)) ++p;
+        if (p >= end || *p != ':') return false;
+        ++p;
+        while (p < end && is_ws(*p)) ++p;
+        if (p >= end) return false;
+
+        if ((size_t)(k_end - k) == key_len && memcmp(k, key, key_len) == 0) {
+            if (*p == '"') {
+                const char* v_end = json_string_end(p + 1, end);
+                if (v_end >= end) return false;
+                *field = p + 1;
+                *field_len = (size_t)(v_end - p - 1);
+            } else {
+                const char* v_end = json_skip_value(p, end);
+                *field = p;
+                *field_len = (size_t)(v_end - p);
+            }
+            return true;
+        }
+        p = json_skip_value(p, end);
+    }
+}
+
+static bool delimited_field(char delim, bool quoting, int column_index, const char* p,
+                            const char* end, const char** field, size_t* field_len) {
+    if (column_index < 0) return false;
+    for (int col = 0;; ++col) {
+        const char* start = p;
+        const char* stop;
+        if (quoting && p < end && *p == '"') {
+            // Quoted field: "" is an escaped quote, the field ends at a lone quote.
+            const char* q = p + 1;
+            for (;;) {
+                q = cardid_find_any3(q, end, '"', '"', '"');
+                if (q + 1 < end && q[1] == '"') {
+                    q += 2;
+                    continue;
+                }
+                break;
+            }
+            if (col == column_index) {
+                *field = p + 1;
+                *field_len = (size_t)((q < end ? q : end) - (p + 1));
+                return true;
+            }
+            stop = q < end ? cardid_find_any3(q + 1, end, delim, delim, delim) : end;
+        } else {
+            // A stray quote inside an unquoted field is plain data.
+            stop = cardid_find_any3(p, end, delim, delim, delim);
+            if (col == column_index) {
+                *field = start;
+                *field_len = (size_t)(stop - start);
+                return true;
+            }
+        }
+        if (stop >= end) return false;
+        p = stop + 1;
+    }
+}
+
+bool cardid_record_field(const cardid_record_config* cfg, int column_index, const char* record,
+                         size_t record_len, const char** field, size_t* field_len) {
+    if (!cfg || !record || !field || !field_len) return false;
+    const char* end = record + record_len;
+    if (cfg->format == CARDID_RECORD_NDJSON) {
+        if (!cfg->column_name) return false;
+        return ndjson_field(cfg->column_name, record, end, field, field_len);
+    }
+    return delimited_field(field_delimiter(cfg), cfg->format == CARDID_RECORD_CSV, column_index,
+                           record, end, field, field_len);
+}
+
+// Returns the '\n' that terminates the record starting at p, or NULL if the
+// buffer ends first. CSV newlines inside quoted fields do not end a record; as
+// in delimited_field, a field is quoted only when it starts with '"', and a
+// stray quote inside an unquoted field is plain data.
+static const char* record_end(const cardid_record_config* cfg, const char* p, const char* end) {
+    if (cfg->format != CARDID_RECORD_CSV) {
+        return memchr(p, '\n', (size_t)(end - p));
+    }
+    char delim = field_delimiter(cfg);
+    for (;;) {
+        if (p < end && *p == '"') {
+            // Quoted field: "" is an escaped quote, the field ends at a lone quote.
+            for (++p;; p += 2) {
+                p = cardid_find_any3(p, end, '"', '"', '"');
+                if (p + 1 >= end) return NULL;  // unterminated, or "" undecidable yet
+                if (p[1] != '"') break;
+            }
+            ++p;
+        }
+        p = cardid_find_any3(p, end, '\n', delim, delim);
+        if (p >= end) return NULL;
+        if (*p == '\n') return p;
+        ++p;  // next field
+    }
+}
+
+static int column_by_name(const cardid_record_config* cfg, const char* rec, size_t len) {
+    size_t name_len = strlen(cfg->column_name);
+    for (int col = 0;; ++col) {
+        const char* f;
+        size_t f_len;
+        if (!cardid_record_field(cfg, col, rec, len, &f, &f_len)) return -1;
+        if (f_len == name_len && memcmp(f, cfg->column_name, name_len) == 0) return col;
+    }
+}
+
+static void put(FILE* out, const char* s, size_t n) {
+    if (n) fwrite(s, 1, n, out);
+}
+
+static void append_result(const cardid_record_config* cfg, FILE* out, const char* rec,
+                          size_t len, const cardid_result* res, uint64_t token) {
+    bool ok = res->luhn_valid && res->network != CARD_UNKNOWN;
+    char token_hex[17] = "";
+    if (ok && cfg->token_key) {
+        snprintf(token_hex, sizeof(token_hex), "%016llx", (unsigned long long)token);
+    }
+    if (cfg->format == CARDID_RECORD_NDJSON) {
+        const char* close = rec + len;
+        while (close > rec && close[-1] != '}') --close;
+        if (close == rec) {  // not an object: leave the record untouched
+            put(out, rec, len);
+            return;
+        }
+        --close;
+        const char* prev = close;
+        while (prev > rec && is_ws(prev[-1])) --prev;
+        put(out, rec, (size_t)(prev - rec));
+        fprintf(out, "%s\"cardid_valid\":%s,\"cardid_network\":\"%s\",\"cardid_length\":%d",
+                (prev > rec && prev[-1] == '{') ? "" : ",", ok ? "true" : "false",
+                cardid_network_name(res->network), res->length);
+        if (cfg->token_key) fprintf(out, ",\"cardid_token\":\"%s\"", token_hex);
+        put(out, prev, (size_t)(rec + len - prev));
+        return;
+    }
+    char d = field_delimiter(cfg);
+    put(out, rec, len);
+    fprintf(out, "%c%s%c%s%c%d", d, ok ? "true" : "false", d, cardid_network_name(res->network),
+            d, res->length);
+    if (cfg->token_key) fprintf(out, "%c%s", d, token_hex);
+}
+
+cardid_status cardid_record_stream(FILE* in, FILE* out, const cardid_record_config* cfg,
+                                   cardid_record_stats* stats) {
+    if (!in || !out || !cfg) return CARDID_ERR_ARG;
+    if (cfg->format == CARDID_RECORD_NDJSON && !cfg->column_name) return CARDID_ERR_ARG;
+    if (cfg->format != CARDID_RECORD_NDJSON && cfg->column_name && !cfg->has_header) {
+        return CARDID_ERR_ARG;
+    }
+
+    cardid_record_stats local = {0, 0, 0};
+    size_t cap = READ_CHUNK, len = 0;
+    char* buf = malloc(cap);
+    if (!buf) return CARDID_ERR_NOMEM;
+
+    cardid_status status = CARDID_OK;
+    cardid_digit_scratch scratch;
+    cardid_digit_scratch_begin(&scratch);
+    char* digits = scratch.digits;
+    bool header_pending = cfg->format != CARDID_RECORD_NDJSON && cfg->has_header;
+    int column = cfg->column_index;
+    bool eof = false;
+    uint64_t consumed = 0;  // input bytes before buf[0]
+
+    while (status == CARDID_OK) {
+        if (!eof && len < cap) {
+            size_t n = fread(buf + len, 1, cap - len, in);
+            len += n;
+            if (n == 0) {
+                if (ferror(in)) {
+                    status = CARDID_ERR_IO;
+                    break;
+                }
+                eof = true;
+            }
+        }
+
+        // One latency sample per buffer, output writes included (see cardid_metrics.h).
+        size_t pos = 0;
+        CARDID_METRICS_BATCH_START(t0);
+        while (pos < len) {
+            const char* rec = buf + pos;
+            const char* nl = record_end(cfg, rec, buf + len);
+            if (!nl && !eof) break;
+            const char* stop = nl ? nl : buf + len;
+            size_t rec_len = (size_t)(stop - rec);
+            const char* term = nl ? "\n" : "";
+            if (rec_len && rec[rec_len - 1] == '\r') {
+                --rec_len;
+                term = nl ? "\r\n" : "\r";
+            }
+            pos = (size_t)(stop - buf) + (nl ? 1 : 0);
+
+            if (rec_len == 0) {  // blank line: pass through
+                put(out, term, strlen(term));
+                continue;
+            }
+            if (header_pending) {
+                header_pending = false;
+                if (cfg->column_name) {
+                    column = column_by_name(cfg, rec, rec_len);
+                    if (column < 0) {
+                        status = CARDID_ERR_ARG;
+                        break;
+                    }
+                }
+                char d = field_delimiter(cfg);
+                put(out, rec, rec_len);
+                fprintf(out, "%ccardid_valid%ccardid_network%ccardid_length%s", d, d, d,
+                        cfg->token_key ? "" : term);
+                if (cfg->token_key) fprintf(out, "%ccardid_token%s", d, term);
+                continue;
+            }
+
+            const char* field;
+            size_t field_len;
+            cardid_result res = {CARD_UNKNOWN, false, 0};
+            uint64_t token = 0;
+            bool valid = false;
+            ++local.records;
+            if (cardid_record_field(cfg, column, rec, rec_len, &field, &field_len)) {
+                if (cardid_analyze_into(field, field_len, &res, NULL, digits) ==
+                    CARDID_OUTCOME_VALID) {
+                    valid = true;
+                    ++local.valid;
+                    if (cfg->token_key) token = cardid_token64(cfg->token_key, digits, res.length);
+                }
+            } else {
+                ++local.missing;
+            }
+            if (cfg->results) {
+                status = cardid_results_writer_add(cfg->results, consumed + (uint64_t)(rec - buf),
+                                                   &res, valid ? digits : NULL);
+                if (status != CARDID_OK) break;
+            }
+            append_result(cfg, out, rec, rec_len, &res, token);
+            put(out, term, strlen(term));
+        }
+        if (pos) CARDID_METRICS_BATCH_END(CARDID_PATH_RECORD_STREAM, t0);
+        if (status != CARDID_OK) break;
+
+        memmove(buf, buf + pos, len - pos);
+        len -= pos;
+        consumed += pos;
+        if (eof && len == 0) break;
+        if (len == cap) {
+            // A single record fills the buffer: grow it, within limits.
+            if (cap >= CARDID_RECORD_MAX_BYTES) {
+                status = CARDID_ERR_FORMAT;
+                break;
+            }
+            char* grown = realloc(buf, cap * 2);
+            if (!grown) {
+                status = CARDID_ERR_NOMEM;
+                break;
+            }
+            buf = grown;
+            cap *= 2;
+        }
+    }
+
+    cardid_digit_scratch_end(&scratch);
+    cardid_secure_zero(buf, cap);  // raw records hold PANs too
+    free(buf);
+    if (status == CARDID_OK && (fflush(out) != 0 || ferror(out))) status = CARDID_ERR_IO;
+    if (stats) *stats = local;
+    return status;
+}
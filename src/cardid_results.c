@@ -0,0 +1,701 @@
+#if !defined(_WIN32) && !defined(_POSIX_C_SOURCE)
+#define _POSIX_C_SOURCE 200809L
+#endif
+#include "cardid_results.h"
+#include "cardid_internal.h"
+#include <errno.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#ifndef _WIN32
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#define RESULTS_MAGIC "CARDIDRS"
+#define RESULTS_VERSION 1u
+#define RESULTS_BYTE_ORDER 0x01020304u  // reads back differently on a big-endian host
+#define RESULTS_ALIGN 64u
+#define BIN_DIGITS 6
+#define BIN_COUNT 1000000u
+#define NETWORK_COUNT (CARD_DISCOVER + 1)
+
+// On-disk structures, written in host order (see RESULTS_BYTE_ORDER). All fields
+// are naturally aligned, so the structs have no padding.
+typedef struct {
+    char magic[8];
+    uint32_t version;
+    uint32_t byte_order;
+    uint64_t records;
+    uint32_t offset_width;  // 4 or 8
+    uint32_t id_width;      // 4 or 8, for postings
+    uint64_t offsets_pos, networks_pos, valid_pos, lengths_pos;
+    uint64_t netdir_pos, netdir_count, ranges_pos, ranges_count;
+    uint64_t bindir_pos, bindir_count, postings_pos, postings_count;
+    uint64_t file_size;
+} results_header;
+
+typedef struct {
+    uint32_t network;
+    uint32_t reserved;
+    uint64_t records;
+    uint64_t first_range;
+    uint64_t range_count;
+} results_netdir;
+
+typedef struct {
+    uint64_t start, end;
+} results_range;
+
+typedef struct {
+    uint32_t bin;
+    uint32_t reserved;
+    uint64_t first_posting;
+    uint64_t count;
+} results_bindir;
+
+#define NO_BIN UINT32_MAX
+
+// ---------------------------------------------------------------------------
+// Writer
+//
+// Rows are collected in fixed blocks and appended, one file per column, to
+// spill files next to the output (path.tmp.0 ... path.tmp.4, on the output's
+// filesystem rather than /tmp). POSIX unlinks them as soon as they are open;
+// Windows cannot remove an open file, so there they go when the writer is freed.
+// Close streams the columns back into path.tmp behind the header and builds the
+// indexes from per-network and per-BIN counts kept while rows arrive.
+
+#define ROW_BLOCK 4096u  // rows per spill write, a multiple of 64
+
+// Record numbers placed per pass over the BIN column (32 MiB).
+size_t cardid_results_posting_chunk = 1u << 22;
+
+enum { COL_OFFSETS, COL_NETWORKS, COL_LENGTHS, COL_BINS, COL_VALID, COL_COUNT };
+
+struct cardid_results_writer {
+    char* path;
+    char* name;  // scratch: path plus a suffix
+    size_t path_len;
+    FILE* out;   // path.tmp, open from cardid_results_writer_open on
+    FILE* spill[COL_COUNT];
+    uint64_t count;
+    size_t fill;  // rows in the current block
+    uint64_t offsets[ROW_BLOCK];
+    uint8_t networks[ROW_BLOCK];
+    uint8_t lengths[ROW_BLOCK];
+    uint32_t bins[ROW_BLOCK];
+    uint64_t valid[ROW_BLOCK / 64];
+    uint64_t max_offset;
+    uint64_t net_records[NETWORK_COUNT];
+    uint64_t net_runs[NETWORK_COUNT];
+    int last_network;
+    uint64_t* bin_counts;  // BIN_COUNT entries
+    cardid_status status;
+};
+
+static const char* writer_name(cardid_results_writer* w, const char* suffix) {
+    memcpy(w->name, w->path, w->path_len);
+    strcpy(w->name + w->path_len, suffix);
+    return w->name;
+}
+
+static const char* spill_name(cardid_results_writer* w, int col) {
+    char suffix[] = ".tmp.0";
+    suffix[5] = (char)('0' + col);
+    return writer_name(w, suffix);
+}
+
+static void writer_free(cardid_results_writer* w, bool remove_out) {
+    for (int k = 0; k < COL_COUNT; ++k) {
+        if (!w->spill[k]) continue;
+        fclose(w->spill[k]);
+#ifdef _WIN32
+        remove(spill_name(w, k));
+#endif
+    }
+    if (w->out) fclose(w->out);
+    if (remove_out) remove(writer_name(w, ".tmp"));
+    free(w->path);
+    free(w->name);
+    free(w->bin_counts);
+    free(w);
+}
+
+cardid_status cardid_results_writer_open(const char* path, cardid_results_writer** out) {
+    if (!path || !out) return CARDID_ERR_ARG;
+    *out = NULL;
+    cardid_results_writer* w = calloc(1, sizeof(*w));
+    if (!w) return CARDID_ERR_NOMEM;
+    w->path_len = strlen(path);
+    w->path = malloc(w->path_len + 1);
+    w->name = malloc(w->path_len + sizeof(".tmp.0"));
+    w->bin_counts = calloc(BIN_COUNT, sizeof(uint64_t));
+    w->last_network = -1;
+    if (!w->path || !w->name || !w->bin_counts) {
+        writer_free(w, false);
+        return CARDID_ERR_NOMEM;
+    }
+    memcpy(w->path, path, w->path_len + 1);
+    w->out = fopen(writer_name(w, ".tmp"), "wb");
+    for (int k = 0; w->out && k < COL_COUNT; ++k) {
+        if (!(w->spill[k] = fopen(spill_name(w, k), "w+b"))) break;
+#ifndef _WIN32
+        remove(w->name);
+#endif
+    }
+    if (!w->out || !w->spill[COL_COUNT - 1]) {
+        int err = errno;  // for the caller's perror
+        writer_free(w, w->out != NULL);
+        errno = err;
+        return CARDID_ERR_IO;
+    }
+    *out = w;
+    return CARDID_OK;
+}
+
+static cardid_status writer_flush(cardid_results_writer* w) {
+    size_t n = w->fill, words = (n + 63) / 64;
+    bool ok = fwrite(w->offsets, sizeof(uint64_t), n, w->spill[COL_OFFSETS]) == n &&
+              fwrite(w->networks, 1, n, w->spill[COL_NETWORKS]) == n &&
+              fwrite(w->lengths, 1, n, w->spill[COL_LENGTHS]) == n &&
+              fwrite(w->bins, sizeof(uint32_t), n, w->spill[COL_BINS]) == n &&
+              fwrite(w->valid, sizeof(uint64_t), words, w->spill[COL_VALID]) == words;
+    w->fill = 0;
+    return ok ? CARDID_OK : (w->status = CARDID_ERR_IO);
+}
+
+cardid_status cardid_results_writer_add(cardid_results_writer* w, uint64_t offset,
+                                        const cardid_result* res, const char* digits) {
+    if (!w || !res) return CARDID_ERR_ARG;
+    if (w->status != CARDID_OK) return w->status;
+
+    size_t i = w->fill;
+    uint8_t network = (unsigned)res->network < NETWORK_COUNT ? (uint8_t)res->network : CARD_UNKNOWN;
+    w->offsets[i] = offset;
+    if (offset > w->max_offset) w->max_offset = offset;
+    w->networks[i] = network;
+    w->lengths[i] = (uint8_t)(res->length < 0 ? 0 : res->length > 255 ? 255 : res->length);
+    if (i % 64 == 0) w->valid[i / 64] = 0;
+    if (res->luhn_valid) w->valid[i / 64] |= 1ull << (i % 64);
+    uint32_t bin = NO_BIN;
+    if (digits && res->length >= BIN_DIGITS) {
+        bin = 0;
+        for (int k = 0; k < BIN_DIGITS; ++k) bin = bin * 10 + (uint32_t)(digits[k] - '0');
+        ++w->bin_counts[bin];
+    }
+    w->bins[i] = bin;
+
+    ++w->net_records[network];
+    if (network != w->last_network) ++w->net_runs[network];
+    w->last_network = network;
+    ++w->count;
+    return ++w->fill == ROW_BLOCK ? writer_flush(w) : CARDID_OK;
+}
+
+static uint64_t align_up(uint64_t pos) {
+    return (pos + RESULTS_ALIGN - 1) & ~(uint64_t)(RESULTS_ALIGN - 1);
+}
+
+// Sequential section writer: pads with zeros up to pos, then writes data.
+typedef struct {
+    FILE* f;
+    uint64_t pos;
+    bool ok;
+} section_out;
+
+static void put_at(section_out* o, uint64_t pos, const void* data, size_t len) {
+    static const char zeros[RESULTS_ALIGN];
+    while (o->ok && o->pos < pos) {
+        size_t n = pos - o->pos < sizeof(zeros) ? (size_t)(pos - o->pos) : sizeof(zeros);
+        o->ok = fwrite(zeros, 1, n, o->f) == n;
+        o->pos += n;
+    }
+    if (o->ok && len) o->ok = fwrite(data, 1, len, o->f) == len;
+    o->pos += len;
+}
+
+// Writes values as 4- or 8-byte integers, converting in blocks.
+static void put_ids(section_out* o, uint64_t pos, const uint64_t* v, uint64_t n, uint32_t width) {
+    if (width == 8) {
+        put_at(o, pos, v, (size_t)n * sizeof(uint64_t));
+        return;
+    }
+    uint32_t block[1024];
+    put_at(o, pos, NULL, 0);
+    for (uint64_t i = 0; i < n;) {
+        size_t m = n - i < 1024 ? (size_t)(n - i) : 1024;
+        for (size_t k = 0; k < m; ++k) block[k] = (uint32_t)v[i + k];
+        put_at(o, o->pos, block, m * sizeof(uint32_t));
+        i += m;
+    }
+}
+
+// Next elements of a spilled column; rewind the column to start a pass.
+static size_t spill_read(cardid_results_writer* w, int col, void* buf, size_t size, size_t max) {
+    size_t n = fread(buf, size, max, w->spill[col]);
+    if (n < max && ferror(w->spill[col])) w->status = CARDID_ERR_IO;
+    return n;
+}
+
+// Offsets convert to the header's width; the byte columns and the bitmap copy as
+// they are. The row block arrays are free once the last block is flushed.
+static void put_column(cardid_results_writer* w, section_out* o, uint64_t pos, int col,
+                       uint32_t width) {
+    rewind(w->spill[col]);
+    put_at(o, pos, NULL, 0);
+    size_t n;
+    if (col == COL_OFFSETS) {
+        while ((n = spill_read(w, col, w->offsets, sizeof(uint64_t), ROW_BLOCK)) > 0)
+            put_ids(o, o->pos, w->offsets, n, width);
+    } else {
+        while ((n = spill_read(w, col, w->offsets, 1, sizeof(w->offsets))) > 0)
+            put_at(o, o->pos, w->offsets, n);
+    }
+}
+
+// Range table entries of one network: one pass over the network column.
+static void put_ranges(cardid_results_writer* w, section_out* o, uint8_t network) {
+    results_range runs[256];
+    size_t nruns = 0, n;
+    uint64_t row = 0, start = 0;
+    bool in_run = false;
+    rewind(w->spill[COL_NETWORKS]);
+    while ((n = spill_read(w, COL_NETWORKS, w->networks, 1, ROW_BLOCK)) > 0) {
+        for (size_t k = 0; k < n; ++k, ++row) {
+            bool hit = w->networks[k] == network;
+            if (hit && !in_run) start = row;
+            if (!hit && in_run) runs[nruns++] = (results_range){start, row};
+            in_run = hit;
+            if (nruns == 256) {
+                put_at(o, o->pos, runs, sizeof(runs));
+                nruns = 0;
+            }
+        }
+    }
+    if (in_run) runs[nruns++] = (results_range){start, row};
+    put_at(o, o->pos, runs, nruns * sizeof(*runs));
+}
+
+// Postings by counting sort, a chunk of BINs at a time: each pass over the BIN
+// column places the record numbers of consecutive BINs whose postings fit buf.
+// A single BIN with more postings than that is written out in record order as
+// its rows come. bin_counts is reused as the per-BIN cursor.
+static void put_postings(cardid_results_writer* w, section_out* o, uint64_t pos, uint32_t width,
+                         uint64_t* buf, uint64_t cap) {
+    uint64_t* cursor = w->bin_counts;
+    put_at(o, pos, NULL, 0);
+    uint32_t b = 0;
+    while (b < BIN_COUNT && o->ok && w->status == CARDID_OK) {
+        if (!cursor[b]) {
+            ++b;
+            continue;
+        }
+        uint32_t lo = b;
+        uint64_t total = 0;
+        while (b < BIN_COUNT && (b == lo || total + cursor[b] <= cap)) total += cursor[b++];
+        bool fits = total <= cap;
+        uint64_t next = 0, fill = 0, row = 0;
+        for (uint32_t k = lo; fits && k < b; ++k) {
+            uint64_t c = cursor[k];
+            cursor[k] = next;
+            next += c;
+        }
+        size_t n;
+        rewind(w->spill[COL_BINS]);
+        while ((n = spill_read(w, COL_BINS, w->bins, sizeof(uint32_t), ROW_BLOCK)) > 0) {
+            for (size_t k = 0; k < n; ++k, ++row) {
+                uint32_t v = w->bins[k];  // NO_BIN is never in [lo, b)
+                if (v < lo || v >= b) continue;
+                if (fits) {
+                    buf[cursor[v]++] = row;
+                } else {
+                    buf[fill++] = row;
+                    if (fill == cap) {
+                        put_ids(o, o->pos, buf, fill, width);
+                        fill = 0;
+                    }
+                }
+            }
+        }
+        put_ids(o, o->pos, buf, fits ? total : fill, width);
+    }
+}
+
+static cardid_status writer_emit(cardid_results_writer* w) {
+    results_header h;
+    memset(&h, 0, sizeof(h));
+    memcpy(h.magic, RESULTS_MAGIC, sizeof(h.magic));
+    h.version = RESULTS_VERSION;
+    h.byte_order = RESULTS_BYTE_ORDER;
+    h.records = w->count;
+    h.offset_width = w->max_offset <= UINT32_MAX ? 4 : 8;
+    h.id_width = w->count <= UINT32_MAX ? 4 : 8;
+
+    // Network directory: ranges grouped by network, record order within each.
+    results_netdir netdir[NETWORK_COUNT];
+    for (int n = 0; n < NETWORK_COUNT; ++n) {
+        if (!w->net_records[n]) continue;
+        netdir[h.netdir_count++] =
+            (results_netdir){(uint32_t)n, 0, w->net_records[n], h.ranges_count, w->net_runs[n]};
+        h.ranges_count += w->net_runs[n];
+    }
+    for (uint32_t b = 0; b < BIN_COUNT; ++b) {
+        h.postings_count += w->bin_counts[b];
+        h.bindir_count += w->bin_counts[b] != 0;
+    }
+    uint64_t cap = h.postings_count < cardid_results_posting_chunk ? h.postings_count
+                                                                   : cardid_results_posting_chunk;
+    uint64_t* postings = malloc((size_t)(cap ? cap : 1) * sizeof(uint64_t));
+    if (!postings) return CARDID_ERR_NOMEM;
+
+    uint64_t pos = align_up(sizeof(h));
+    h.offsets_pos = pos;
+    pos = align_up(pos + h.records * h.offset_width);
+    h.networks_pos = pos;
+    pos = align_up(pos + h.records);
+    h.valid_pos = pos;
+    pos = align_up(pos + (h.records + 63) / 64 * 8);
+    h.lengths_pos = pos;
+    pos = align_up(pos + h.records);
+    h.netdir_pos = pos;
+    pos = align_up(pos + h.netdir_count * sizeof(results_netdir));
+    h.ranges_pos = pos;
+    pos = align_up(pos + h.ranges_count * sizeof(results_range));
+    h.bindir_pos = pos;
+    pos = align_up(pos + h.bindir_count * sizeof(results_bindir));
+    h.postings_pos = pos;
+    h.file_size = pos + h.postings_count * h.id_width;
+
+    section_out o = {w->out, 0, true};
+    put_at(&o, 0, &h, sizeof(h));
+    put_column(w, &o, h.offsets_pos, COL_OFFSETS, h.offset_width);
+    put_column(w, &o, h.networks_pos, COL_NETWORKS, 1);
+    put_column(w, &o, h.valid_pos, COL_VALID, 8);
+    put_column(w, &o, h.lengths_pos, COL_LENGTHS, 1);
+    put_at(&o, h.netdir_pos, netdir, (size_t)h.netdir_count * sizeof(results_netdir));
+    put_at(&o, h.ranges_pos, NULL, 0);
+    for (uint64_t i = 0; i < h.netdir_count; ++i) put_ranges(w, &o, (uint8_t)netdir[i].network);
+
+    results_bindir bindir[256];
+    size_t nbins = 0;
+    uint64_t next = 0;
+    put_at(&o, h.bindir_pos, NULL, 0);
+    for (uint32_t b = 0; b < BIN_COUNT; ++b) {
+        if (!w->bin_counts[b]) continue;
+        bindir[nbins++] = (results_bindir){b, 0, next, w->bin_counts[b]};
+        next += w->bin_counts[b];
+        if (nbins == 256) {
+            put_at(&o, o.pos, bindir, sizeof(bindir));
+            nbins = 0;
+        }
+    }
+    put_at(&o, o.pos, bindir, nbins * sizeof(*bindir));
+    put_postings(w, &o, h.postings_pos, h.id_width, postings, cap ? cap : 1);
+    free(postings);
+    if (w->status != CARDID_OK) return w->status;
+    return o.ok && o.pos == h.file_size ? CARDID_OK : CARDID_ERR_IO;
+}
+
+cardid_status cardid_results_writer_close(cardid_results_writer* w) {
+    if (!w) return CARDID_ERR_ARG;
+    if (w->status == CARDID_OK) writer_flush(w);
+    cardid_status st = w->status == CARDID_OK ? writer_emit(w) : w->status;
+    if (fclose(w->out) != 0 && st == CARDID_OK) st = CARDID_ERR_IO;
+    w->out = NULL;
+    if (st == CARDID_OK && rename(writer_name(w, ".tmp"), w->path) != 0) st = CARDID_ERR_IO;
+    writer_free(w, st != CARDID_OK);
+    return st;
+}
+
+void cardid_results_writer_discard(cardid_results_writer* w) {
+    if (w) writer_free(w, true);
+}
+
+// ---------------------------------------------------------------------------
+// Reader
+
+struct cardid_results {
+    const unsigned char* base;
+    size_t size;
+    results_header h;
+    const uint8_t* networks;
+    const uint64_t* valid;
+    const uint8_t* lengths;
+    const results_netdir* netdir;
+    const results_range* ranges;
+    const results_bindir* bindir;
+};
+
+static bool section_ok(const results_header* h, uint64_t pos, uint64_t count, uint64_t elem) {
+    if (pos % 8 || pos > h->file_size) return false;
+    return count <= (h->file_size - pos) / elem;
+}
+
+static cardid_status results_parse(cardid_results* r) {
+    results_header* h = &r->h;
+    if (r->size < sizeof(*h)) return CARDID_ERR_FORMAT;
+    memcpy(h, r->base, sizeof(*h));
+    if (memcmp(h->magic, RESULTS_MAGIC, sizeof(h->magic)) != 0 || h->version != RESULTS_VERSION ||
+        h->byte_order != RESULTS_BYTE_ORDER || h->file_size != r->size ||
+        (h->offset_width != 4 && h->offset_width != 8) || (h->id_width != 4 && h->id_width != 8))
+        return CARDID_ERR_FORMAT;
+    if (!section_ok(h, h->offsets_pos, h->records, h->offset_width) ||
+        !section_ok(h, h->networks_pos, h->records, 1) ||
+        !section_ok(h, h->valid_pos, (h->records + 63) / 64, 8) ||
+        !section_ok(h, h->lengths_pos, h->records, 1) ||
+        !section_ok(h, h->netdir_pos, h->netdir_count, sizeof(results_netdir)) ||
+        !section_ok(h, h->ranges_pos, h->ranges_count, sizeof(results_range)) ||
+        !section_ok(h, h->bindir_pos, h->bindir_count, sizeof(results_bindir)) ||
+        !section_ok(h, h->postings_pos, h->postings_count, h->id_width))
+        return CARDID_ERR_FORMAT;
+    r->networks = r->base + h->networks_pos;
+    r->valid = (const uint64_t*)(const void*)(r->base + h->valid_pos);
+    r->lengths = r->base + h->lengths_pos;
+    r->netdir = (const results_netdir*)(const void*)(r->base + h->netdir_pos);
+    r->ranges = (const results_range*)(const void*)(r->base + h->ranges_pos);
+    r->bindir = (const results_bindir*)(const void*)(r->base + h->bindir_pos);
+    // The directories are small; check their slices here so iteration needn't.
+    for (uint64_t i = 0; i < h->netdir_count; ++i) {
+        const results_netdir* d = &r->netdir[i];
+        if (d->first_range > h->ranges_count || d->range_count > h->ranges_count - d->first_range)
+            return CARDID_ERR_FORMAT;
+    }
+    for (uint64_t i = 0; i < h->bindir_count; ++i) {
+        const results_bindir* d = &r->bindir[i];
+        if (d->first_posting > h->postings_count || d->count > h->postings_count - d->first_posting ||
+            (i && d->bin <= r->bindir[i - 1].bin))
+            return CARDID_ERR_FORMAT;
+    }
+    return CARDID_OK;
+}
+
+#if defined(_WIN32)
+
+// No mmap here: read the whole file instead.
+cardid_status cardid_results_open(const char* path, cardid_results** out) {
+    if (!path || !out) return CARDID_ERR_ARG;
+    *out = NULL;
+    FILE* f = fopen(path, "rb");
+    if (!f) return CARDID_ERR_IO;
+    cardid_results* r = calloc(1, sizeof(*r));
+    unsigned char* data = NULL;
+    size_t cap = 0, len = 0;
+    cardid_status st = r ? CARDID_OK : CARDID_ERR_NOMEM;
+    while (st == CARDID_OK) {
+        if (len == cap) {
+            unsigned char* grown = realloc(data, cap ? cap * 2 : 1 << 16);
+            if (!grown) {
+                st = CARDID_ERR_NOMEM;
+                break;
+            }
+            data = grown;
+            cap = cap ? cap * 2 : 1 << 16;
+        }
+        size_t n = fread(data + len, 1, cap - len, f);
+        len += n;
+        if (n == 0) {
+            if (ferror(f)) st = CARDID_ERR_IO;
+            break;
+        }
+    }
+    fclose(f);
+    if (st == CARDID_OK) {
+        r->base = data;
+        r->size = len;
+        st = results_parse(r);
+    }
+    if (st != CARDID_OK) {
+        free(data);
+        free(r);
+        return st;
+    }
+    *out = r;
+    return CARDID_OK;
+}
+
+void cardid_results_close(cardid_results* r) {
+    if (!r) return;
+    free((void*)r->base);
+    free(r);
+}
+
+#else
+
+cardid_status cardid_results_open(const char* path, cardid_results** out) {
+    if (!path || !out) return CARDID_ERR_ARG;
+    *out = NULL;
+    int fd = open(path, O_RDONLY | O_CLOEXEC);
+    if (fd < 0) return CARDID_ERR_IO;
+    struct stat st;
+    if (fstat(fd, &st) != 0 || (uint64_t)st.st_size > SIZE_MAX) {
+        close(fd);
+        return CARDID_ERR_IO;
+    }
+    if ((size_t)st.st_size < sizeof(results_header)) {
+        close(fd);
+        return CARDID_ERR_FORMAT;
+    }
+    void* map = mmap(NULL, (size_t)st.st_size, PROT_READ, MAP_SHARED, fd, 0);
+    close(fd);
+    if (map == MAP_FAILED) return CARDID_ERR_IO;
+    cardid_results* r = calloc(1, sizeof(*r));
+    if (!r) {
+        munmap(map, (size_t)st.st_size);
+        return CARDID_ERR_NOMEM;
+    }
+    r->base = map;
+    r->size = (size_t)st.st_size;
+    cardid_status status = results_parse(r);
+    if (status != CARDID_OK) {
+        cardid_results_close(r);
+        return status;
+    }
+    *out = r;
+    return CARDID_OK;
+}
+
+void cardid_results_close(cardid_results* r) {
+    if (!r) return;
+    munmap((void*)r->base, r->size);
+    free(r);
+}
+
+#endif
+
+uint64_t cardid_results_count(const cardid_results* r) {
+    return r ? r->h.records : 0;
+}
+
+static uint64_t load_width(const unsigned char* p, uint32_t width, uint64_t i) {
+    if (width == 4) return ((const uint32_t*)(const void*)p)[i];
+    return ((const uint64_t*)(const void*)p)[i];
+}
+
+static void fill_row(const cardid_results* r, uint64_t i, cardid_results_row* row) {
+    row->record = i;
+    row->offset = load_width(r->base + r->h.offsets_pos, r->h.offset_width, i);
+    row->result.network = (cardid_network)r->networks[i];
+    row->result.luhn_valid = (r->valid[i / 64] >> (i % 64)) & 1;
+    row->result.length = r->lengths[i];
+}
+
+bool cardid_results_get(const cardid_results* r, uint64_t i, cardid_results_row* row) {
+    if (!r || !row || i >= r->h.records) return false;
+    fill_row(r, i, row);
+    return true;
+}
+
+static const results_netdir* find_network(const cardid_results* r, cardid_network network) {
+    for (uint64_t i = 0; i < r->h.netdir_count; ++i) {
+        if (r->netdir[i].network == (uint32_t)network) return &r->netdir[i];
+    }
+    return NULL;
+}
+
+uint64_t cardid_results_network_count(const cardid_results* r, cardid_network network) {
+    const results_netdir* d = r ? find_network(r, network) : NULL;
+    return d ? d->records : 0;
+}
+
+// First BIN directory entry with bin >= key.
+static uint64_t bin_lower_bound(const cardid_results* r, uint32_t key) {
+    uint64_t lo = 0, hi = r->h.bindir_count;
+    while (lo < hi) {
+        uint64_t mid = lo + (hi - lo) / 2;
+        if (r->bindir[mid].bin < key) {
+            lo = mid + 1;
+        } else {
+            hi = mid;
+        }
+    }
+    return lo;
+}
+
+// Iterator state per mode:
+//   by_bin      a = BIN directory entry, b = posting within it, c = end entry
+//   by_network  a = range index, b = next record in that range, c = end range
+//   otherwise   b = next record, c = record count
+void cardid_results_iter_init(cardid_results_iter* it, const cardid_results* r,
+                              const cardid_results_filter* f) {
+    if (!it) return;
+    memset(it, 0, sizeof(*it));
+    it->r = r;
+    if (f) it->f = *f;
+    if (!r) return;
+    if (it->f.by_bin) {
+        if (it->f.bin_lo > it->f.bin_hi) return;
+        it->a = bin_lower_bound(r, it->f.bin_lo);
+        it->c = it->f.bin_hi == UINT32_MAX ? r->h.bindir_count : bin_lower_bound(r, it->f.bin_hi + 1);
+    } else if (it->f.by_network) {
+        const results_netdir* d = find_network(r, it->f.network);
+        if (!d) return;
+        it->a = d->first_range;
+        it->c = d->first_range + d->range_count;
+        if (it->a < it->c) it->b = r->ranges[it->a].start;
+    } else {
+        it->c = r->h.records;
+    }
+}
+
+static bool row_matches(const cardid_results_iter* it, uint64_t i) {
+    const cardid_results* r = it->r;
+    if (it->f.by_network && r->networks[i] != (uint8_t)it->f.network) return false;
+    if (it->f.valid_only && !((r->valid[i / 64] >> (i % 64)) & 1)) return false;
+    return true;
+}
+
+bool cardid_results_next(cardid_results_iter* it, cardid_results_row* row) {
+    if (!it || !it->r || !row) return false;
+    const cardid_results* r = it->r;
+    if (it->f.by_bin) {
+        const unsigned char* postings = r->base + r->h.postings_pos;
+        while (it->a < it->c) {
+            const results_bindir* d = &r->bindir[it->a];
+            if (it->b >= d->count) {
+                ++it->a;
+                it->b = 0;
+                continue;
+            }
+            uint64_t i = load_width(postings, r->h.id_width, d->first_posting + it->b++);
+            if (i < r->h.records && row_matches(it, i)) {
+                fill_row(r, i, row);
+                return true;
+            }
+        }
+        return false;
+    }
+    if (it->f.by_network) {
+        while (it->a < it->c) {
+            const results_range* g = &r->ranges[it->a];
+            uint64_t end = g->end < r->h.records ? g->end : r->h.records;
+            if (it->b < g->start) it->b = g->start;
+            if (it->b >= end) {
+                if (++it->a < it->c) it->b = r->ranges[it->a].start;
+                continue;
+            }
+            uint64_t i = it->b++;
+            if (row_matches(it, i)) {
+                fill_row(r, i, row);
+                return true;
+            }
+        }
+        return false;
+    }
+    while (it->b < it->c) {
+        uint64_t i = it->b;
+        // Skip whole words of invalid records without touching their rows.
+        if (it->f.valid_only && i % 64 == 0 && r->valid[i / 64] == 0) {
+            it->b += 64;
+            continue;
+        }
+        ++it->b;
+        if (row_matches(it, i)) {
+            fill_row(r, i, row);
+            return true;
+        }
+    }
+    return false;
+}
@@ -0,0 +1,147 @@
+#include "cardid_scan.h"
+#include <string.h>
+#include "cardid_internal.h"
+
+static bool is_alnum(unsigned char c) {
+    return (unsigned char)(c - '0') <= 9 || (unsigned char)((c | 0x20) - 'a') < 26;
+}
+
+static bool is_alpha(unsigned char c) {
+    return (unsigned char)((c | 0x20) - 'a') < 26;
+}
+
+void cardid_scanner_init(cardid_scanner* s, uint64_t start) {
+    memset(s, 0, sizeof(*s));
+    s->pos = start;
+    s->claimed = start;
+}
+
+// Drops the oldest n retained groups and their digits.
+static void drop_groups(cardid_scanner* s, int n) {
+    if (n <= 0) return;
+    int nd = 0;
+    for (int g = 0; g < n; ++g) nd += s->group_digits[g];
+    s->ngroups -= n;
+    s->ndigits -= nd;
+    memmove(s->digits, s->digits + nd, (size_t)s->ndigits);
+    memmove(s->group_start, s->group_start + n, (size_t)s->ngroups * sizeof(s->group_start[0]));
+    memmove(s->group_end, s->group_end + n, (size_t)s->ngroups * sizeof(s->group_end[0]));
+    memmove(s->group_digits, s->group_digits + n, (size_t)s->ngroups);
+    s->first_is_run_start = false;
+}
+
+// The newest group just ended. Tries every stretch of groups ending with it,
+// longest first, then forgets groups that can no longer start a PAN: those
+// before the last report and those already 19+ digits away from the end.
+static void close_group(cardid_scanner* s, bool trailing_ok, cardid_scan_callback cb, void* ctx) {
+    int last = s->ngroups - 1;
+    if (s->overlong) {
+        s->ngroups = s->ndigits = 0;
+        s->overlong = false;
+        s->first_is_run_start = false;
+        return;
+    }
+
+    int total = s->ndigits;
+    for (int first = 0; first <= last && trailing_ok; ++first) {
+        int n = total;
+        total -= s->group_digits[first];
+        if (n < 13) break;
+        if (n > CARDID_MAX_DIGITS) continue;
+        if (first == 0 && s->first_is_run_start && s->lead_blocked) continue;
+        if (s->group_start[first] < s->claimed) continue;
+
+        const char* d = s->digits + (s->ndigits - n);
+        if (!cardid_luhn_digits(d, n)) continue;
+        cardid_network network = cardid_detect_network(d, n);
+        if (network == CARD_UNKNOWN) continue;
+
+        cardid_scan_match m;
+        m.offset = s->group_start[first];
+        m.span = (uint32_t)(s->group_end[last] - s->group_start[first] + 1);
+        m.length = n;
+        m.network = network;
+        s->claimed = s->group_end[last] + 1;
+        if (cb) cb(&m, ctx);
+        break;
+    }
+
+    int drop = 0, rest = s->ndigits;
+    while (drop <= last &&
+           (s->group_start[drop] < s->claimed || rest >= CARDID_MAX_DIGITS)) {
+        rest -= s->group_digits[drop++];
+    }
+    drop_groups(s, drop);
+}
+
+static void end_run(cardid_scanner* s, bool trailing_ok, cardid_scan_callback cb, void* ctx) {
+    close_group(s, trailing_ok, cb, ctx);
+    s->ngroups = s->ndigits = 0;
+    s->in_run = s->sep_pending = false;
+}
+
+void cardid_scanner_feed(cardid_scanner* s, const char* buf, size_t len, cardid_scan_callback cb,
+                         void* ctx) {
+    if (!s || !buf) return;
+    const char* p = buf;
+    const char* end = buf + len;
+    while (p < end) {
+        if (!s->in_run) {
+            // Outside a run only the next digit matters: skip to it 16 bytes at a time.
+            const char* q = cardid_find_digit(p, end);
+            if (q == end) {
+                if (q > p) s->prev = (unsigned char)end[-1];
+                s->pos += (uint64_t)(end - p);
+                return;
+            }
+            if (q > p) s->prev = (unsigned char)q[-1];
+            s->pos += (uint64_t)(q - p);
+            p = q;
+            s->in_run = true;
+            s->lead_blocked = is_alnum(s->prev);
+            s->first_is_run_start = true;
+            s->ngroups = 1;
+            s->group_start[0] = s->pos;
+            s->group_digits[0] = 0;
+        }
+
+        unsigned char c = (unsigned char)*p;
+        if ((unsigned char)(c - '0') <= 9) {
+            if (s->sep_pending) {
+                close_group(s, true, cb, ctx);
+                s->sep_pending = false;
+                int g = s->ngroups++;
+                s->group_start[g] = s->pos;
+                s->group_digits[g] = 0;
+            }
+            int g = s->ngroups - 1;
+            if (s->group_digits[g] < CARDID_MAX_DIGITS) {
+                s->digits[s->ndigits++] = (char)c;
+                s->group_digits[g]++;
+            } else {
+                s->overlong = true;  // too long for any PAN; dropped when it ends
+            }
+            s->group_end[g] = s->pos;
+        } else if ((c == ' ' || c == '-') && !s->sep_pending) {
+            s->sep_pending = true;
+        } else {
+            end_run(s, s->sep_pending || !is_alpha(c), cb, ctx);
+        }
+        s->prev = c;
+        ++s->pos;
+        ++p;
+    }
+}
+
+void cardid_scanner_finish(cardid_scanner* s, cardid_scan_callback cb, void* ctx) {
+    if (!s) return;
+    if (s->in_run) end_run(s, true, cb, ctx);
+    cardid_secure_zero(s->digits, sizeof(s->digits));
+}
+
+uint64_t cardid_scanner_resume_offset(const cardid_scanner* s) {
+    // One byte early so the fresh scanner sees what preceded the run (or the
+    // next one) for its boundary check; that byte is never a digit.
+    uint64_t first = s->in_run ? s->group_start[0] : s->pos;
+    return first > s->claimed ? first - 1 : s->claimed;
+}
@@ -0,0 +1,135 @@
+#if !defined(_WIN32) && !defined(_DEFAULT_SOURCE)
+#define _DEFAULT_SOURCE  // explicit_bzero, MAP_ANONYMOUS, madvise
+#endif
+#include "cardid_scratch.h"
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#if defined(_WIN32)
+#include <windows.h>
+#else
+#include <pthread.h>
+#include <sys/mman.h>
+#include <unistd.h>
+#endif
+
+struct cardid_scratch {
+    unsigned char* base;
+    size_t size;
+    size_t used;
+    size_t high_water;  // bytes that may hold data since the arena was created
+    bool locked;
+    bool dontdump;
+};
+
+void cardid_secure_zero(void* p, size_t n) {
+    if (!p || !n) return;
+#if defined(_WIN32)
+    SecureZeroMemory(p, n);
+#elif defined(__GLIBC__) && (__GLIBC__ > 2 || (__GLIBC__ == 2 && __GLIBC_MINOR__ >= 25))
+    explicit_bzero(p, n);
+#else
+    // A volatile function pointer keeps the call opaque to dead-store elimination.
+    static void* (*const volatile wipe)(void*, int, size_t) = memset;
+    wipe(p, 0, n);
+#endif
+}
+
+#if defined(_WIN32)
+
+static __declspec(thread) cardid_scratch* tls_scratch;
+
+static cardid_scratch* scratch_create(void) {
+    cardid_scratch* s = calloc(1, sizeof(*s));
+    if (!s) return NULL;
+    s->size = CARDID_SCRATCH_BYTES;
+    s->base = VirtualAlloc(NULL, s->size, MEM_COMMIT | MEM_RESERVE, PAGE_READWRITE);
+    if (!s->base) {
+        free(s);
+        return NULL;
+    }
+    s->locked = VirtualLock(s->base, s->size) != 0;
+    return s;
+}
+
+// No portable thread-exit hook here: the arena lives until process exit.
+cardid_scratch* cardid_scratch_thread(void) {
+    if (!tls_scratch) tls_scratch = scratch_create();
+    return tls_scratch;
+}
+
+#else
+
+static pthread_key_t scratch_key;
+static pthread_once_t scratch_once = PTHREAD_ONCE_INIT;
+
+static void scratch_destroy(void* p) {
+    cardid_scratch* s = (cardid_scratch*)p;
+    cardid_secure_zero(s->base, s->high_water);
+    if (s->locked) munlock(s->base, s->size);
+    munmap(s->base, s->size);
+    free(s);
+}
+
+static void scratch_key_init(void) {
+    pthread_key_create(&scratch_key, scratch_destroy);
+}
+
+static cardid_scratch* scratch_create(void) {
+    cardid_scratch* s = calloc(1, sizeof(*s));
+    if (!s) return NULL;
+    s->size = CARDID_SCRATCH_BYTES;
+    void* base = mmap(NULL, s->size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (base == MAP_FAILED) {
+        free(s);
+        return NULL;
+    }
+    s->base = base;
+    s->locked = mlock(s->base, s->size) == 0;
+#ifdef MADV_DONTDUMP
+    s->dontdump = madvise(s->base, s->size, MADV_DONTDUMP) == 0;
+#endif
+    return s;
+}
+
+cardid_scratch* cardid_scratch_thread(void) {
+    pthread_once(&scratch_once, scratch_key_init);
+    cardid_scratch* s = pthread_getspecific(scratch_key);
+    if (!s && (s = scratch_create()) != NULL) {
+        if (pthread_setspecific(scratch_key, s) != 0) {
+            scratch_destroy(s);
+            return NULL;
+        }
+    }
+    return s;
+}
+
+#endif
+
+void* cardid_scratch_alloc(cardid_scratch* s, size_t n) {
+    if (!s) return NULL;
+    size_t start = (s->used + 15) & ~(size_t)15;
+    if (start > s->size || n > s->size - start) return NULL;
+    s->used = start + n;
+    if (s->used > s->high_water) s->high_water = s->used;
+    return s->base + start;
+}
+
+size_t cardid_scratch_mark(const cardid_scratch* s) {
+    return s ? s->used : 0;
+}
+
+void cardid_scratch_release(cardid_scratch* s, size_t mark) {
+    if (!s || mark >= s->used) return;
+    cardid_secure_zero(s->base + mark, s->used - mark);
+    s->used = mark;
+}
+
+bool cardid_scratch_locked(const cardid_scratch* s) {
+    return s && s->locked;
+}
+
+bool cardid_scratch_dontdump(const cardid_scratch* s) {
+    return s && s->dontdump;
+}
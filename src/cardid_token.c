@@ -0,0 +1,216 @@
+#include "cardid_token.h"
+#include <string.h>
+#include "cardid_internal.h"
+
+// PANs hashed per pass of the lane kernel. The kernel is written as plain loops
+// over lane arrays so the compiler maps them onto whatever vector width the
+// target has (2 lanes per SSE2 register, 4 with AVX2, 8 with AVX-512).
+#define TOKEN_LANES 8
+
+#define ROTL64(x, b) (uint64_t)(((x) << (b)) | ((x) >> (64 - (b))))
+
+#define SIPROUND(v0, v1, v2, v3) \
+    do { \
+        v0 += v1; \
+        v1 = ROTL64(v1, 13); \
+        v1 ^= v0; \
+        v0 = ROTL64(v0, 32); \
+        v2 += v3; \
+        v3 = ROTL64(v3, 16); \
+        v3 ^= v2; \
+        v0 += v3; \
+        v3 = ROTL64(v3, 21); \
+        v3 ^= v0; \
+        v2 += v1; \
+        v1 = ROTL64(v1, 17); \
+        v1 ^= v2; \
+        v2 = ROTL64(v2, 32); \
+    } while (0)
+
+// Message word domain tag for cardid_token_fpt, so its round values are
+// independent of the cardid_token64 value for the same PAN.
+#define FPT_DOMAIN ((uint64_t)1 << 63)
+
+// Feistel rounds of the cardid_token_fpt permutation (as in FF1).
+#define FPT_ROUNDS 10
+
+static uint64_t load_le64(const unsigned char* p) {
+    uint64_t v = 0;
+    for (int i = 7; i >= 0; --i) v = (v << 8) | p[i];
+    return v;
+}
+
+uint64_t cardid_pack_digits(const char* digits, int len) {
+    uint64_t v = 0;
+    for (int i = 0; i < len; ++i) v = v * 10 + (uint64_t)(digits[i] - '0');
+    return v;
+}
+
+uint64_t cardid_siphash24(const cardid_token_key* key, const void* data, size_t len) {
+    const unsigned char* in = (const unsigned char*)data;
+    uint64_t v0 = 0x736f6d6570736575ULL ^ key->k0;
+    uint64_t v1 = 0x646f72616e646f6dULL ^ key->k1;
+    uint64_t v2 = 0x6c7967656e657261ULL ^ key->k0;
+    uint64_t v3 = 0x7465646279746573ULL ^ key->k1;
+
+    size_t full = len & ~(size_t)7;
+    for (size_t i = 0; i < full; i += 8) {
+        uint64_t m = load_le64(in + i);
+        v3 ^= m;
+        SIPROUND(v0, v1, v2, v3);
+        SIPROUND(v0, v1, v2, v3);
+        v0 ^= m;
+    }
+    uint64_t b = (uint64_t)len << 56;
+    for (size_t i = full; i < len; ++i) b |= (uint64_t)in[i] << (8 * (i - full));
+
+    v3 ^= b;
+    SIPROUND(v0, v1, v2, v3);
+    SIPROUND(v0, v1, v2, v3);
+    v0 ^= b;
+    v2 ^= 0xff;
+    for (int i = 0; i < 4; ++i) SIPROUND(v0, v1, v2, v3);
+    return v0 ^ v1 ^ v2 ^ v3;
+}
+
+// SipHash-2-4 of the 16-byte message LE64(m0) || LE64(m1), one word per step.
+static uint64_t sip16(const cardid_token_key* key, uint64_t m0, uint64_t m1) {
+    uint64_t v0 = 0x736f6d6570736575ULL ^ key->k0;
+    uint64_t v1 = 0x646f72616e646f6dULL ^ key->k1;
+    uint64_t v2 = 0x6c7967656e657261ULL ^ key->k0;
+    uint64_t v3 = 0x7465646279746573ULL ^ key->k1;
+    const uint64_t m[3] = {m0, m1, (uint64_t)16 << 56};
+    for (int w = 0; w < 3; ++w) {
+        v3 ^= m[w];
+        SIPROUND(v0, v1, v2, v3);
+        SIPROUND(v0, v1, v2, v3);
+        v0 ^= m[w];
+    }
+    v2 ^= 0xff;
+    for (int i = 0; i < 4; ++i) SIPROUND(v0, v1, v2, v3);
+    return v0 ^ v1 ^ v2 ^ v3;
+}
+
+// sip16 on TOKEN_LANES independent messages at once (structure of arrays).
+static void sip16_lanes(const cardid_token_key* key, const uint64_t* m0, const uint64_t* m1,
+                        uint64_t* out) {
+    uint64_t v0[TOKEN_LANES], v1[TOKEN_LANES], v2[TOKEN_LANES], v3[TOKEN_LANES];
+    for (int l = 0; l < TOKEN_LANES; ++l) {
+        v0[l] = 0x736f6d6570736575ULL ^ key->k0;
+        v1[l] = 0x646f72616e646f6dULL ^ key->k1;
+        v2[l] = 0x6c7967656e657261ULL ^ key->k0;
+        v3[l] = 0x7465646279746573ULL ^ key->k1;
+    }
+    uint64_t final[TOKEN_LANES];
+    for (int l = 0; l < TOKEN_LANES; ++l) final[l] = (uint64_t)16 << 56;
+    const uint64_t* words[3] = {m0, m1, final};
+    for (int w = 0; w < 3; ++w) {
+        const uint64_t* m = words[w];
+        for (int l = 0; l < TOKEN_LANES; ++l) {
+            v3[l] ^= m[l];
+            SIPROUND(v0[l], v1[l], v2[l], v3[l]);
+            SIPROUND(v0[l], v1[l], v2[l], v3[l]);
+            v0[l] ^= m[l];
+        }
+    }
+    for (int l = 0; l < TOKEN_LANES; ++l) {
+        v2[l] ^= 0xff;
+        for (int i = 0; i < 4; ++i) SIPROUND(v0[l], v1[l], v2[l], v3[l]);
+        out[l] = v0[l] ^ v1[l] ^ v2[l] ^ v3[l];
+    }
+}
+
+uint64_t cardid_token64(const cardid_token_key* key, const char* digits, int len) {
+    if (!key || !digits || len < 0 || len > CARDID_MAX_DIGITS) return 0;
+    return sip16(key, cardid_pack_digits(digits, len), (uint64_t)len);
+}
+
+static uint64_t pow10u(int n) {
+    uint64_t p = 1;
+    while (n-- > 0) p *= 10;
+    return p;
+}
+
+// Round value of the cardid_token_fpt Feistel network: SipHash-2-4 of the
+// tweak (BIN and last 4) and the round index, length and half being mixed in.
+static uint64_t fpt_round(const cardid_token_key* key, uint64_t tweak, int round, int len,
+                          uint64_t half) {
+    return sip16(key, tweak, half | (uint64_t)round << 32 | (uint64_t)len << 40 | FPT_DOMAIN);
+}
+
+bool cardid_token_fpt(const cardid_token_key* key, const char* digits, int len, char* out) {
+    if (!key || !digits || !out || len < 13 || len > CARDID_MAX_DIGITS) return false;
+    for (int i = 0; i < len; ++i) {
+        if ((unsigned)(digits[i] - '0') > 9) return false;
+    }
+    if (!cardid_luhn_digits(digits, len)) return false;
+
+    // Given BIN, last 4 and the other middle digits, Luhn fixes the last middle
+    // digit, so the n digits before it identify the PAN. Those go
+    // through a keyed permutation (an FF1-style Feistel network over decimal
+    // halves, tweaked by BIN and last 4); the last middle digit is then chosen
+    // so the token fails Luhn. Distinct PANs thus never share a token.
+    int n = len - 11, u = n / 2, v = n - u;
+    uint64_t tweak =
+        cardid_pack_digits(digits, 6) * 10000 + cardid_pack_digits(digits + len - 4, 4);
+    uint64_t a = cardid_pack_digits(digits + 6, u), b = cardid_pack_digits(digits + 6 + u, v);
+    for (int round = 0; round < FPT_ROUNDS; ++round) {
+        uint64_t mod = pow10u(round % 2 ? v : u);
+        uint64_t c = (a + fpt_round(key, tweak, round, len, b) % mod) % mod;
+        a = b;
+        b = c;
+    }
+    // FPT_ROUNDS is even, so a has u digits and b has v again.
+    uint64_t x = a * pow10u(v) + b;
+    uint64_t h = fpt_round(key, tweak, FPT_ROUNDS, len, x);
+
+    memcpy(out, digits, (size_t)len);
+    out[len] = '\0';
+    for (int i = len - 6; i >= 6; --i) {
+        out[i] = (char)('0' + x % 10);
+        x /= 10;
+    }
+    // Changing any one digit changes the Luhn sum mod 10, so one bump suffices.
+    out[len - 5] = (char)('0' + h % 10);
+    if (cardid_luhn_digits(out, len)) out[len - 5] = (char)('0' + (out[len - 5] - '0' + 1) % 10);
+    return true;
+}
+
+void cardid_analyze_tokenize_batch(const cardid_token_key* key, const char* const* inputs,
+                                   size_t count, cardid_result* results, uint64_t* tokens) {
+    if (!key || !inputs || !results || !tokens) return;
+    CARDID_METRICS_BATCH_START(t0);
+
+    cardid_digit_scratch scratch;
+    cardid_digit_scratch_begin(&scratch);
+    char* digits = scratch.digits;
+    uint64_t m0[TOKEN_LANES], m1[TOKEN_LANES], h[TOKEN_LANES];
+    bool ok[TOKEN_LANES];
+
+    for (size_t base = 0; base < count; base += TOKEN_LANES) {
+        int n = count - base < TOKEN_LANES ? (int)(count - base) : TOKEN_LANES;
+        for (int l = 0; l < TOKEN_LANES; ++l) {
+            m0[l] = m1[l] = 0;
+            ok[l] = false;
+            if (l >= n) continue;
+            const char* in = inputs[base + l];
+            cardid_result* r = &results[base + l];
+            if (!in) {
+                cardid_analyze_n(NULL, 0, r, NULL);
+                continue;
+            }
+            ok[l] = cardid_analyze_into(in, strlen(in), r, NULL, digits) == CARDID_OUTCOME_VALID;
+            if (ok[l]) {
+                m0[l] = cardid_pack_digits(digits, r->length);
+                m1[l] = (uint64_t)r->length;
+            }
+        }
+        sip16_lanes(key, m0, m1, h);
+        for (int l = 0; l < n; ++l) tokens[base + l] = ok[l] ? h[l] : 0;
+    }
+    // Packed PANs are as sensitive as the digits they came from.
+    cardid_secure_zero(m0, sizeof(m0));
+    cardid_digit_scratch_end(&scratch);
+
+    CARDID_METRICS_BATCH_END(CARDID_PATH_TOKENIZE_BATCH, t0);
+}
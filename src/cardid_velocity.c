@@ -0,0 +1,314 @@
+#if !defined(_WIN32) && !defined(_POSIX_C_SOURCE)
+#define _POSIX_C_SOURCE 200809L
+#endif
+#include "cardid_velocity.h"
+#include <stdlib.h>
+#include <string.h>
+#include "cardid_internal.h"
+#include "cardid_token.h"
+
+// splitmix64 finalizer: full avalanche, so the two halves act as independent hashes.
+// A bijection on 64-bit values.
+static uint64_t mix64(uint64_t x) {
+    x ^= x >> 30;
+    x *= 0xbf58476d1ce4e5b9ULL;
+    x ^= x >> 27;
+    x *= 0x94d049bb133111ebULL;
+    return x ^ (x >> 31);
+}
+
+uint64_t cardid_velocity_key(const char* digits, int len) {
+    if (!digits || len < 0 || len > CARDID_MAX_DIGITS) return 0;
+    // Offsetting by 1...1 (len ones, the count of shorter digit strings) numbers
+    // every string of up to 19 digits uniquely below 1.12e19 < 2^64.
+    uint64_t shorter = 0;
+    for (int i = 0; i < len; ++i) shorter = shorter * 10 + 1;
+    return mix64(cardid_pack_digits(digits, len) + shorter);
+}
+
+#if !defined(__STDC_NO_ATOMICS__)
+
+#include <stdatomic.h>
+#ifdef _WIN32
+#include <windows.h>
+#define cpu_yield() SwitchToThread()
+#else
+#include <sched.h>
+#define cpu_yield() sched_yield()
+#endif
+
+#define DEFAULT_WIDTH 65536u
+#define DEFAULT_DEPTH 4u
+#define DEFAULT_SLICES 61u
+#define DEFAULT_SLICE_NS 60000000000ull
+
+// Slice stamps are epoch + 1, so 0 means "never used"; CLEARING marks a slice
+// whose counters are being zeroed for a new epoch.
+#define STAMP_CLEARING UINT64_MAX
+
+// One header per slice, on its own cache line so writers polling one slice's
+// stamp never contend with the clock advancing another.
+typedef struct {
+    _Alignas(64) _Atomic uint64_t stamp;
+} slice_header;
+
+struct cardid_velocity {
+    uint32_t width, mask, depth, slices;
+    uint64_t slice_ns;
+    uint64_t seed;
+    _Atomic uint64_t newest;  // newest epoch + 1 the clock has advanced to (0: none yet)
+    slice_header* headers;
+    _Atomic uint32_t* counters;  // [slice][row][width]
+    void* raw;
+    size_t bytes;
+};
+
+// Row r's column is h1 + r * h2 (Kirsch-Mitzenmacher double hashing).
+static void columns(const cardid_velocity* v, uint64_t key, uint32_t* col) {
+    uint64_t h = mix64(key ^ v->seed);
+    uint32_t h1 = (uint32_t)h, h2 = (uint32_t)(h >> 32) | 1u;
+    for (uint32_t r = 0; r < v->depth; ++r) col[r] = (h1 + r * h2) & v->mask;
+}
+
+static _Atomic uint32_t* slice_row(const cardid_velocity* v, uint64_t slot, uint32_t row) {
+    return v->counters + ((size_t)slot * v->depth + row) * v->width;
+}
+
+cardid_velocity* cardid_velocity_create(const cardid_velocity_config* cfg) {
+    cardid_velocity_config c;
+    if (cfg) {
+        c = *cfg;
+    } else {
+        memset(&c, 0, sizeof(c));
+    }
+    if (!c.width) c.width = DEFAULT_WIDTH;
+    if (!c.depth) c.depth = DEFAULT_DEPTH;
+    if (!c.slices) c.slices = DEFAULT_SLICES;
+    if (!c.slice_ns) c.slice_ns = DEFAULT_SLICE_NS;
+    if (c.depth > CARDID_VELOCITY_MAX_DEPTH || c.slices < 2 || c.width > (1u << 31)) return NULL;
+    uint32_t width = 1;
+    while (width < c.width) width <<= 1;
+
+    size_t counters = (size_t)c.slices * c.depth * width;
+    if (counters / c.slices / c.depth != width) return NULL;
+    size_t header_bytes = (size_t)c.slices * sizeof(slice_header);
+    size_t bytes = header_bytes + counters * sizeof(_Atomic uint32_t);
+    cardid_velocity* v = calloc(1, sizeof(*v));
+    void* raw = calloc(1, bytes + 64);
+    if (!v || !raw) {
+        free(v);
+        free(raw);
+        return NULL;
+    }
+    v->raw = raw;
+    v->bytes = bytes;
+    v->headers = (slice_header*)(((uintptr_t)raw + 63) & ~(uintptr_t)63);
+    v->counters = (_Atomic uint32_t*)((char*)v->headers + header_bytes);
+    v->width = width;
+    v->mask = width - 1;
+    v->depth = c.depth;
+    v->slices = c.slices;
+    v->slice_ns = c.slice_ns;
+    v->seed = mix64(c.seed ^ 0x6a09e667f3bcc909ULL);
+    for (uint32_t s = 0; s < v->slices; ++s) atomic_init(&v->headers[s].stamp, 0);
+    for (size_t i = 0; i < counters; ++i) atomic_init(&v->counters[i], 0);
+    atomic_init(&v->newest, 0);
+    return v;
+}
+
+void cardid_velocity_destroy(cardid_velocity* v) {
+    if (!v) return;
+    free(v->raw);
+    free(v);
+}
+
+size_t cardid_velocity_memory(const cardid_velocity* v) {
+    return v ? v->bytes : 0;
+}
+
+void cardid_velocity_bounds(const cardid_velocity* v, double* epsilon, double* delta) {
+    const double e = 2.718281828459045;
+    double d = v ? 1.0 : 0;
+    for (uint32_t r = 0; v && r < v->depth; ++r) d /= e;
+    if (epsilon) *epsilon = v ? e / v->width : 0;
+    if (delta) *delta = d;
+}
+
+// Re-purpose a slice for epoch. Stamps only move forward: if a concurrent
+// advance already claimed the slice for a later epoch, this one backs off.
+static void clear_slice(cardid_velocity* v, uint64_t epoch) {
+    slice_header* h = &v->headers[epoch % v->slices];
+    uint64_t stamp = atomic_load_explicit(&h->stamp, memory_order_acquire);
+    for (;;) {
+        if (stamp != STAMP_CLEARING && stamp >= epoch + 1) return;
+        if (stamp == STAMP_CLEARING) {
+            cpu_yield();
+            stamp = atomic_load_explicit(&h->stamp, memory_order_acquire);
+            continue;
+        }
+        if (atomic_compare_exchange_weak_explicit(&h->stamp, &stamp, STAMP_CLEARING,
+                                                  memory_order_acquire, memory_order_acquire))
+            break;
+    }
+    for (uint32_t r = 0; r < v->depth; ++r) {
+        _Atomic uint32_t* row = slice_row(v, epoch % v->slices, r);
+        for (uint32_t i = 0; i < v->width; ++i)
+            atomic_store_explicit(&row[i], 0, memory_order_relaxed);
+    }
+    atomic_store_explicit(&h->stamp, epoch + 1, memory_order_release);
+}
+
+// Moves the clock to epoch. The thread that wins the advance zeroes the slices
+// for every epoch it skipped, plus epoch + 1 ahead of time, so in steady state
+// writers find their slice ready and never race with a reset.
+static void advance(cardid_velocity* v, uint64_t epoch) {
+    uint64_t newest = atomic_load_explicit(&v->newest, memory_order_acquire);
+    while (newest < epoch + 1) {
+        if (atomic_compare_exchange_weak_explicit(&v->newest, &newest, epoch + 1,
+                                                  memory_order_acq_rel, memory_order_acquire)) {
+            uint64_t lo = epoch + 2 >= v->slices ? epoch + 2 - v->slices : 0;
+            if (newest != 0 && newest + 1 > lo) lo = newest + 1;  // up to old epoch + 1 is ready
+            for (uint64_t e = lo; e <= epoch + 1; ++e) clear_slice(v, e);
+            return;
+        }
+    }
+}
+
+void cardid_velocity_add(cardid_velocity* v, uint64_t key, uint64_t now_ns) {
+    if (!v) return;
+    uint64_t epoch = now_ns / v->slice_ns;
+    if (atomic_load_explicit(&v->newest, memory_order_relaxed) < epoch + 1) advance(v, epoch);
+
+    slice_header* h = &v->headers[epoch % v->slices];
+    uint64_t stamp;
+    while ((stamp = atomic_load_explicit(&h->stamp, memory_order_acquire)) != epoch + 1) {
+        // Reused for a later epoch, or older than the ring: the event is too old.
+        if (stamp != STAMP_CLEARING && stamp > epoch + 1) return;
+        uint64_t newest = atomic_load_explicit(&v->newest, memory_order_acquire);
+        if (epoch + v->slices < newest + 1) return;
+        cpu_yield();  // the advancing thread is still zeroing this slice
+    }
+
+    uint32_t col[CARDID_VELOCITY_MAX_DEPTH];
+    columns(v, key, col);
+    for (uint32_t r = 0; r < v->depth; ++r)
+        atomic_fetch_add_explicit(&slice_row(v, epoch % v->slices, r)[col[r]], 1,
+                                  memory_order_relaxed);
+}
+
+// Epochs [first, epoch] covered by a window ending at now_ns.
+static uint64_t window_slices(const cardid_velocity* v, uint64_t window_ns) {
+    uint64_t n = (window_ns + v->slice_ns - 1) / v->slice_ns;
+    if (n == 0) n = 1;
+    if (n > v->slices - 1) n = v->slices - 1;
+    return n;
+}
+
+uint64_t cardid_velocity_count(const cardid_velocity* v, uint64_t key, uint64_t window_ns,
+                               uint64_t now_ns) {
+    if (!v) return 0;
+    uint32_t col[CARDID_VELOCITY_MAX_DEPTH];
+    uint64_t sum[CARDID_VELOCITY_MAX_DEPTH] = {0};
+    columns(v, key, col);
+    uint64_t epoch = now_ns / v->slice_ns;
+    uint64_t n = window_slices(v, window_ns);
+    for (uint64_t i = 0; i < n && i <= epoch; ++i) {
+        uint64_t e = epoch - i;
+        uint64_t slot = e % v->slices;
+        if (atomic_load_explicit(&v->headers[slot].stamp, memory_order_acquire) != e + 1) continue;
+        for (uint32_t r = 0; r < v->depth; ++r)
+            sum[r] += atomic_load_explicit(&slice_row(v, slot, r)[col[r]], memory_order_relaxed);
+    }
+    uint64_t best = sum[0];
+    for (uint32_t r = 1; r < v->depth; ++r)
+        if (sum[r] < best) best = sum[r];
+    return best;
+}
+
+uint64_t cardid_velocity_total(const cardid_velocity* v, uint64_t window_ns, uint64_t now_ns) {
+    if (!v) return 0;
+    uint64_t epoch = now_ns / v->slice_ns;
+    uint64_t n = window_slices(v, window_ns), total = 0;
+    for (uint64_t i = 0; i < n && i <= epoch; ++i) {
+        uint64_t e = epoch - i;
+        uint64_t slot = e % v->slices;
+        if (atomic_load_explicit(&v->headers[slot].stamp, memory_order_acquire) != e + 1) continue;
+        const _Atomic uint32_t* row = slice_row(v, slot, 0);
+        for (uint32_t c = 0; c < v->width; ++c)
+            total += atomic_load_explicit(&row[c], memory_order_relaxed);
+    }
+    return total;
+}
+
+uint64_t cardid_velocity_observe(cardid_velocity* v, const char* input, size_t input_len,
+                                 uint64_t now_ns, uint64_t window_ns, cardid_result* out) {
+    cardid_result local;
+    if (!out) out = &local;
+    if (!input) {
+        cardid_analyze_n(NULL, 0, out, NULL);
+        return 0;
+    }
+    char digits[CARDID_MAX_DIGITS + 1];
+    cardid_outcome o = cardid_analyze_into(input, input_len, out, NULL, digits);
+    uint64_t key = o == CARDID_OUTCOME_VALID ? cardid_velocity_key(digits, out->length) : 0;
+    cardid_secure_zero(digits, sizeof(digits));
+    if (o != CARDID_OUTCOME_VALID || !v) return 0;
+    cardid_velocity_add(v, key, now_ns);
+    return cardid_velocity_count(v, key, window_ns, now_ns);
+}
+
+#else
+
+cardid_velocity* cardid_velocity_create(const cardid_velocity_config* cfg) {
+    (void)cfg;
+    return NULL;
+}
+
+void cardid_velocity_destroy(cardid_velocity* v) {
+    (void)v;
+}
+
+size_t cardid_velocity_memory(const cardid_velocity* v) {
+    (void)v;
+    return 0;
+}
+
+void cardid_velocity_bounds(const cardid_velocity* v, double* epsilon, double* delta) {
+    (void)v;
+    if (epsilon) *epsilon = 0;
+    if (delta) *delta = 0;
+}
+
+void cardid_velocity_add(cardid_velocity* v, uint64_t key, uint64_t now_ns) {
+    (void)v;
+    (void)key;
+    (void)now_ns;
+}
+
+uint64_t cardid_velocity_count(const cardid_velocity* v, uint64_t key, uint64_t window_ns,
+                               uint64_t now_ns) {
+    (void)v;
+    (void)key;
+    (void)window_ns;
+    (void)now_ns;
+    return 0;
+}
+
+uint64_t cardid_velocity_total(const cardid_velocity* v, uint64_t window_ns, uint64_t now_ns) {
+    (void)v;
+    (void)window_ns;
+    (void)now_ns;
+    return 0;
+}
+
+uint64_t cardid_velocity_observe(cardid_velocity* v, const char* input, size_t input_len,
+                                 uint64_t now_ns, uint64_t window_ns, cardid_result* out) {
+    (void)v;
+    (void)now_ns;
+    (void)window_ns;
+    cardid_result local;
+    cardid_analyze_n(input, input_len, out ? out : &local, NULL);
+    return 0;
+}
+
+#endif
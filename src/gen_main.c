@@ -0,0 +1,222 @@
+// cardid-gen: synthetic PAN corpus generator and BIN range enumerator.
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "cardid_gen.h"
+
+#ifndef _WIN32
+#include <pthread.h>
+#include <unistd.h>
+#define GEN_THREADS 1
+#endif
+
+#define GEN_BUFFER (1u << 20)
+#define GEN_MAX_THREADS 256
+
+static void usage(void) {
+    fprintf(stderr,
+            "Usage: cardid-gen [-n COUNT] [-t THREADS] [--mix NET=W,...] [--lengths LEN=W,...]\n"
+            "                  [--invalid-rate R] [--separator-rate R] [--garbage-rate R]\n"
+            "                  [--seed S] [--binary]\n"
+            "       cardid-gen --enumerate LO[-HI] --length N [--binary]\n"
+            "  NET is visa, mastercard, amex or discover. Rates are fractions in [0, 1].\n"
+            "  --binary writes a length byte before each PAN instead of a newline after it.\n");
+}
+
+static int network_by_name(const char* name, size_t len) {
+    for (int n = CARD_VISA; n <= CARD_DISCOVER; ++n) {
+        const char* upper = cardid_network_name((cardid_network)n);
+        if (strlen(upper) != len) continue;
+        size_t i = 0;
+        while (i < len && (name[i] == upper[i] || name[i] == upper[i] - 'A' + 'a')) ++i;
+        if (i == len) return n;
+    }
+    return -1;
+}
+
+// Parses "key=weight,key=weight" into weights[]; keys are network names when
+// by_network is set and PAN lengths otherwise.
+static int parse_weights(const char* spec, double* weights, int count, int by_network) {
+    while (*spec) {
+        const char* eq = strchr(spec, '=');
+        if (!eq) return -1;
+        int idx = by_network ? network_by_name(spec, (size_t)(eq - spec)) : atoi(spec);
+        if (idx < 0 || idx >= count) return -1;
+        char* end;
+        weights[idx] = strtod(eq + 1, &end);
+        if (end == eq + 1 || weights[idx] < 0) return -1;
+        spec = *end == ',' ? end + 1 : end;
+        if (*end != ',' && *end != '\0') return -1;
+    }
+    return 0;
+}
+
+typedef struct {
+    cardid_gen_config cfg;
+    cardid_gen_format format;
+    unsigned long long quota;
+    int failed;
+} worker_args;
+
+#ifdef GEN_THREADS
+static pthread_mutex_t out_lock = PTHREAD_MUTEX_INITIALIZER;
+static int out_stop;  // under out_lock: the run is being abandoned, write nothing more
+#endif
+
+// Generates args->quota PANs in 1 MiB blocks; each block is written whole so
+// records from different threads never interleave.
+static void* worker(void* p) {
+    worker_args* args = (worker_args*)p;
+    cardid_gen gen;
+    char* buf = malloc(GEN_BUFFER);
+    if (!buf || cardid_gen_init(&gen, &args->cfg) != CARDID_OK) {
+        args->failed = 1;
+        free(buf);
+        return NULL;
+    }
+    unsigned long long left = args->quota;
+    while (left > 0 && !args->failed) {
+        size_t records;
+        size_t n = cardid_gen_fill(&gen, args->format, buf, GEN_BUFFER, (size_t)left, &records);
+        left -= records;
+#ifdef GEN_THREADS
+        pthread_mutex_lock(&out_lock);
+        if (out_stop) {
+            pthread_mutex_unlock(&out_lock);
+            break;
+        }
+#endif
+        if (fwrite(buf, 1, n, stdout) != n) args->failed = 1;
+#ifdef GEN_THREADS
+        pthread_mutex_unlock(&out_lock);
+#endif
+    }
+    free(buf);
+    return NULL;
+}
+
+static int run_enumerate(const char* range, int len, cardid_gen_format format) {
+    char lo[CARDID_MAX_DIGITS + 1], hi[CARDID_MAX_DIGITS + 1];
+    const char* dash = strchr(range, '-');
+    size_t lo_len = dash ? (size_t)(dash - range) : strlen(range);
+    const char* hi_src = dash ? dash + 1 : range;
+    if (lo_len > CARDID_MAX_DIGITS || strlen(hi_src) > CARDID_MAX_DIGITS) return 2;
+    memcpy(lo, range, lo_len);
+    lo[lo_len] = '\0';
+    strcpy(hi, hi_src);
+
+    cardid_bin_enum e;
+    if (cardid_bin_enum_init(&e, lo, hi, len) != CARDID_OK) {
+        fprintf(stderr, "cardid-gen: invalid range or length\n");
+        return 2;
+    }
+    const char* pan;
+    while ((pan = cardid_bin_enum_next(&e)) != NULL) {
+        if (format == CARDID_GEN_BINARY) {
+            putchar(len);
+            fwrite(pan, 1, (size_t)len, stdout);
+        } else {
+            fwrite(pan, 1, (size_t)len, stdout);
+            putchar('\n');
+        }
+        if (ferror(stdout)) return 1;
+    }
+    return 0;
+}
+
+int main(int argc, char** argv) {
+    worker_args base;
+    memset(&base, 0, sizeof(base));
+    base.cfg.seed = 1;
+    unsigned long long count = 1000000;
+    int threads = 1;
+    const char* enumerate = NULL;
+    int length = 16;
+#ifdef GEN_THREADS
+    long cpus = sysconf(_SC_NPROCESSORS_ONLN);
+    threads = cpus > 0 ? (int)cpus : 1;
+#endif
+
+    for (int i = 1; i < argc; ++i) {
+        const char* a = argv[i];
+        const char* v = i + 1 < argc ? argv[i + 1] : NULL;
+        int ok = 1;
+        if (strcmp(a, "--binary") == 0) {
+            base.format = CARDID_GEN_BINARY;
+            continue;
+        }
+        if (!v) {
+            ok = 0;
+        } else if (strcmp(a, "-n") == 0) {
+            count = strtoull(v, NULL, 10);
+        } else if (strcmp(a, "-t") == 0) {
+            threads = atoi(v);
+            ok = threads >= 1 && threads <= GEN_MAX_THREADS;
+        } else if (strcmp(a, "--mix") == 0) {
+            ok = parse_weights(v, base.cfg.network_weight, CARD_DISCOVER + 1, 1) == 0;
+        } else if (strcmp(a, "--lengths") == 0) {
+            ok = parse_weights(v, base.cfg.length_weight, CARDID_MAX_DIGITS + 1, 0) == 0;
+        } else if (strcmp(a, "--invalid-rate") == 0) {
+            base.cfg.invalid_rate = atof(v);
+        } else if (strcmp(a, "--separator-rate") == 0) {
+            base.cfg.separator_rate = atof(v);
+        } else if (strcmp(a, "--garbage-rate") == 0) {
+            base.cfg.garbage_rate = atof(v);
+        } else if (strcmp(a, "--seed") == 0) {
+            base.cfg.seed = strtoull(v, NULL, 10);
+        } else if (strcmp(a, "--enumerate") == 0) {
+            enumerate = v;
+        } else if (strcmp(a, "--length") == 0) {
+            length = atoi(v);
+        } else {
+            ok = 0;
+        }
+        if (!ok) {
+            usage();
+            return 2;
+        }
+        ++i;
+    }
+
+    if (enumerate) return run_enumerate(enumerate, length, base.format);
+
+    cardid_gen probe;
+    if (cardid_gen_init(&probe, &base.cfg) != CARDID_OK) {
+        fprintf(stderr, "cardid-gen: invalid mix or rates\n");
+        return 2;
+    }
+
+#ifdef GEN_THREADS
+    if ((unsigned long long)threads > count) threads = count ? (int)count : 1;
+    worker_args args[GEN_MAX_THREADS];
+    pthread_t tids[GEN_MAX_THREADS];
+    for (int t = 0; t < threads; ++t) {
+        args[t] = base;
+        args[t].cfg.seed = base.cfg.seed + (unsigned long long)t * 0x9e3779b97f4a7c15ULL;
+        args[t].quota = count / threads + ((unsigned long long)t < count % threads ? 1 : 0);
+        if (pthread_create(&tids[t], NULL, worker, &args[t]) != 0) {
+            fprintf(stderr, "cardid-gen: cannot start thread\n");
+            // Let the threads already running finish their current block and exit
+            // before main returns, so no write is cut short.
+            pthread_mutex_lock(&out_lock);
+            out_stop = 1;
+            pthread_mutex_unlock(&out_lock);
+            while (t-- > 0) pthread_join(tids[t], NULL);
+            fflush(stdout);
+            return 1;
+        }
+    }
+    int failed = 0;
+    for (int t = 0; t < threads; ++t) {
+        pthread_join(tids[t], NULL);
+        failed |= args[t].failed;
+    }
+#else
+    (void)threads;
+    base.quota = count;
+    worker(&base);
+    int failed = base.failed;
+#endif
+    if (fflush(stdout) != 0) failed = 1;
+    return failed ? 1 : 0;
+}
@@ -1,18 +1,458 @@
+#if !defined(_WIN32) && !defined(_POSIX_C_SOURCE)
+#define _POSIX_C_SOURCE 200809L
+#endif
+#include <signal.h>
 #include <stdio.h>
+#include <stdlib.h>
 #include <string.h>
+#ifndef _WIN32
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
 #include "cardid.h"
+#include "cardid_archive.h"
+#include "cardid_crawl.h"
+#include "cardid_follow.h"
+#include "cardid_metrics.h"
+#include "cardid_record.h"
 
-static const char* network_name(cardid_network n) {
-    switch (n) {
-        case CARD_VISA: return "VISA";
-        case CARD_MASTERCARD: return "MASTERCARD";
-        case CARD_AMEX: return "AMEX";
-        case CARD_DISCOVER: return "DISCOVER";
-        default: return "UNKNOWN";
+static void record_usage(const char* mode) {
+    fprintf(stderr,
+            "Usage: cardid %s [--column NAME|--index N] [--delimiter C] [--no-header] [OPTIONS]"
+            " [FILE]\n"
+            "       cardid ndjson --field NAME [OPTIONS] [FILE]\n"
+            "  --token-key-file F  append cardid_token keyed by the 32 hex digits in F\n"
+            "  --results F         also write a columnar result file indexed by network and BIN\n"
+            "  --metrics           print Prometheus metrics to stderr when done\n",
+            mode);
+}
+
+// Reads a 128-bit tokenization key written as 32 hex digits (k0 then k1). The key
+// comes from a file so it never shows up in the process list.
+static bool load_token_key(const char* path, cardid_token_key* key) {
+    FILE* f = fopen(path, "r");
+    if (!f) {
+        perror(path);
+        return false;
+    }
+    char hex[33] = {0};
+    bool ok = fscanf(f, "%32[0-9a-fA-F]", hex) == 1 && strlen(hex) == 32;
+    fclose(f);
+    if (ok) {
+        char half[17] = {0};
+        memcpy(half, hex, 16);
+        key->k0 = strtoull(half, NULL, 16);
+        key->k1 = strtoull(hex + 16, NULL, 16);
+    } else {
+        fprintf(stderr, "cardid: %s must hold 32 hex digits\n", path);
+    }
+    memset(hex, 0, sizeof(hex));
+    return ok;
+}
+
+static void print_metrics(FILE* out) {
+    size_t need = cardid_metrics_format_prometheus(NULL, 0);
+    char* text = malloc(need + 1);
+    if (!text) return;
+    cardid_metrics_format_prometheus(text, need + 1);
+    fputs(text, out);
+    free(text);
+}
+
+// cardid csv|tsv|ndjson ...: validate one column/field per record and stream the
+// records to stdout with the analysis appended.
+static int run_record_mode(int argc, char** argv) {
+    const char* mode = argv[1];
+    cardid_record_config cfg = {CARDID_RECORD_CSV, 0, true, NULL, 0, NULL, NULL};
+    cardid_token_key key;
+    if (strcmp(mode, "tsv") == 0) cfg.format = CARDID_RECORD_TSV;
+    if (strcmp(mode, "ndjson") == 0) cfg.format = CARDID_RECORD_NDJSON;
+
+    const char* path = NULL;
+    const char* results_path = NULL;
+    for (int i = 2; i < argc; ++i) {
+        const char* a = argv[i];
+        if ((strcmp(a, "--column") == 0 || strcmp(a, "--field") == 0) && i + 1 < argc) {
+            cfg.column_name = argv[++i];
+        } else if (strcmp(a, "--index") == 0 && i + 1 < argc) {
+            cfg.column_index = atoi(argv[++i]);
+            cfg.column_name = NULL;
+        } else if (strcmp(a, "--delimiter") == 0 && i + 1 < argc) {
+            cfg.delimiter = argv[++i][0];
+        } else if (strcmp(a, "--no-header") == 0) {
+            cfg.has_header = false;
+        } else if (strcmp(a, "--token-key-file") == 0 && i + 1 < argc) {
+            if (!load_token_key(argv[++i], &key)) return 2;
+            cfg.token_key = &key;
+        } else if (strcmp(a, "--results") == 0 && i + 1 < argc) {
+            results_path = argv[++i];
+        } else if (strcmp(a, "--metrics") == 0) {
+            cardid_metrics_enable(true);
+        } else if (a[0] == '-' && a[1] != '\0') {
+            record_usage(mode);
+            return 2;
+        } else {
+            path = a;
+        }
+    }
+    if (cfg.format == CARDID_RECORD_NDJSON && !cfg.column_name) {
+        record_usage(mode);
+        return 2;
+    }
+
+    FILE* in = stdin;
+    if (path && strcmp(path, "-") != 0) {
+        in = fopen(path, "rb");
+        if (!in) {
+            perror(path);
+            return 1;
+        }
+    }
+    if (results_path) {
+        cardid_status open_st = cardid_results_writer_open(results_path, &cfg.results);
+        if (open_st != CARDID_OK) {
+            if (open_st == CARDID_ERR_NOMEM) {
+                fprintf(stderr, "cardid: out of memory\n");
+            } else {
+                perror(results_path);
+            }
+            if (in != stdin) fclose(in);
+            return 1;
+        }
+    }
+    cardid_record_stats stats;
+    cardid_status st = cardid_record_stream(in, stdout, &cfg, &stats);
+    if (in != stdin) fclose(in);
+    if (cfg.results && st != CARDID_OK) {
+        cardid_results_writer_discard(cfg.results);
+    } else if (cfg.results) {
+        if (cardid_results_writer_close(cfg.results) != CARDID_OK) {
+            fprintf(stderr, "cardid: cannot write %s\n", results_path);
+            return 1;
+        }
+    }
+    if (cardid_metrics_enabled()) print_metrics(stderr);
+
+    switch (st) {
+        case CARDID_OK:
+            fprintf(stderr, "records=%llu valid=%llu missing=%llu\n", stats.records, stats.valid,
+                    stats.missing);
+            return 0;
+        case CARDID_ERR_ARG:
+            fprintf(stderr, "cardid: column not found or invalid options\n");
+            return 2;
+        case CARDID_ERR_FORMAT:
+            fprintf(stderr, "cardid: record exceeds %u bytes\n", CARDID_RECORD_MAX_BYTES);
+            return 1;
+        default:
+            fprintf(stderr, "cardid: I/O error\n");
+            return 1;
+    }
+}
+
+static void scan_usage(void) {
+    fprintf(stderr,
+            "Usage: cardid scan [--threads N] [--queue-depth N] [--buffer-kib N] [--io MODE]\n"
+            "                   [--manifest F] [--report F] [--max-listed N] PATH...\n"
+            "  --manifest F  skip files unchanged since F, then rewrite F\n"
+            "  --report F    write the report to F instead of stdout\n"
+            "  --io MODE     auto (default), uring or pread\n");
+}
+
+// cardid scan PATH...: sweep directory trees for PANs, reporting offsets and
+// networks per file.
+static int run_scan_mode(int argc, char** argv) {
+    cardid_crawl_config cfg;
+    memset(&cfg, 0, sizeof(cfg));
+    const char* report_path = NULL;
+    const char** roots = calloc((size_t)argc, sizeof(*roots));
+    size_t nroots = 0;
+    if (!roots) return 1;
+
+    for (int i = 2; i < argc; ++i) {
+        const char* a = argv[i];
+        const char* v = i + 1 < argc ? argv[i + 1] : NULL;
+        bool ok = v != NULL;
+        if (strcmp(a, "--threads") == 0 && v) {
+            cfg.threads = atoi(v);
+        } else if (strcmp(a, "--queue-depth") == 0 && v) {
+            cfg.queue_depth = atoi(v);
+        } else if (strcmp(a, "--buffer-kib") == 0 && v) {
+            cfg.buffer_size = (size_t)strtoul(v, NULL, 10) * 1024u;
+        } else if (strcmp(a, "--max-listed") == 0 && v) {
+            cfg.max_listed = (unsigned)strtoul(v, NULL, 10);
+        } else if (strcmp(a, "--manifest") == 0 && v) {
+            cfg.manifest_in = cfg.manifest_out = v;
+        } else if (strcmp(a, "--report") == 0 && v) {
+            report_path = v;
+        } else if (strcmp(a, "--io") == 0 && v) {
+            if (strcmp(v, "uring") == 0) {
+                cfg.io = CARDID_CRAWL_IO_URING;
+            } else if (strcmp(v, "pread") == 0) {
+                cfg.io = CARDID_CRAWL_IO_PREAD;
+            } else {
+                ok = strcmp(v, "auto") == 0;
+            }
+        } else if (a[0] == '-' && a[1] != '\0') {
+            ok = false;
+        } else {
+            roots[nroots++] = a;
+            continue;
+        }
+        if (!ok || cfg.threads < 0 || cfg.queue_depth < 0) {
+            scan_usage();
+            free(roots);
+            return 2;
+        }
+        ++i;
+    }
+    if (nroots == 0) {
+        scan_usage();
+        free(roots);
+        return 2;
+    }
+
+    FILE* report = stdout;
+    if (report_path) {
+        report = fopen(report_path, "w");
+        if (!report) {
+            perror(report_path);
+            free(roots);
+            return 1;
+        }
+    }
+    cardid_crawl_stats stats;
+    cardid_status st = cardid_crawl(roots, nroots, report, &cfg, &stats);
+    if (report != stdout && fclose(report) != 0 && st == CARDID_OK) st = CARDID_ERR_IO;
+    free(roots);
+
+    fprintf(stderr,
+            "files=%llu skipped=%llu failed=%llu decompressed=%llu bytes=%llu matches=%llu"
+            " files_with_matches=%llu io=%s\n",
+            stats.files_scanned, stats.files_skipped, stats.files_failed, stats.files_decompressed,
+            stats.bytes_scanned, stats.matches, stats.files_with_matches,
+            stats.io_uring ? "io_uring" : "pread");
+    switch (st) {
+        case CARDID_OK:
+            return 0;
+        case CARDID_ERR_FORMAT:
+            fprintf(stderr, "cardid: malformed manifest\n");
+            return 1;
+        case CARDID_ERR_ARG:
+            scan_usage();
+            return 2;
+        default:
+            fprintf(stderr, "cardid: scan failed (%s)\n",
+                    cfg.io == CARDID_CRAWL_IO_URING ? "io_uring unavailable or I/O error"
+                                                    : "I/O error");
+            return 1;
+    }
+}
+
+static void stream_usage(void) {
+    fprintf(stderr,
+            "Usage: cardid stream [--threads N] [FILE|-]\n"
+            "  scan one log for PANs, decompressing gzip/zstd input (%s%s)\n"
+            "  --threads N   decoders for bgzip / multi-frame zstd files (default: CPUs)\n",
+            cardid_archive_supported(CARDID_ARCHIVE_GZIP) ? "gzip: yes" : "gzip: not built in",
+            cardid_archive_supported(CARDID_ARCHIVE_ZSTD) ? ", zstd: yes" : ", zstd: not built in");
+}
+
+static void print_stream_match(const cardid_scan_match* m, void* ctx) {
+    (void)ctx;
+    printf("%llu:%s:%d\n", (unsigned long long)m->offset, cardid_network_name(m->network),
+           m->length);
+}
+
+// Maps a regular file for cardid_archive_scan; pipes and stdin are decoded as
+// they are read.
+static cardid_status stream_file(const char* path, int threads, cardid_archive_stats* stats) {
+#ifndef _WIN32
+    int fd = open(path, O_RDONLY | O_CLOEXEC);
+    if (fd < 0) {
+        perror(path);
+        return CARDID_ERR_IO;
+    }
+    struct stat st;
+    if (fstat(fd, &st) == 0 && S_ISREG(st.st_mode) && st.st_size > 0 &&
+        (unsigned long long)st.st_size <= SIZE_MAX) {
+        size_t len = (size_t)st.st_size;
+        void* map = mmap(NULL, len, PROT_READ, MAP_PRIVATE, fd, 0);
+        close(fd);
+        if (map == MAP_FAILED) {
+            perror(path);
+            return CARDID_ERR_IO;
+        }
+        cardid_status rc = cardid_archive_scan(map, len, threads, print_stream_match, NULL, stats);
+        munmap(map, len);
+        return rc;
+    }
+    close(fd);
+#else
+    (void)threads;
+#endif
+    FILE* in = fopen(path, "rb");
+    if (!in) {
+        perror(path);
+        return CARDID_ERR_IO;
+    }
+    cardid_status rc = cardid_archive_scan_stream(in, print_stream_match, NULL, stats);
+    fclose(in);
+    return rc;
+}
+
+// cardid stream [FILE]: report offset:NETWORK:length for every PAN in one log,
+// plain or compressed.
+static int run_stream_mode(int argc, char** argv) {
+    int threads = 0;
+    const char* path = NULL;
+    for (int i = 2; i < argc; ++i) {
+        const char* a = argv[i];
+        if (strcmp(a, "--threads") == 0 && i + 1 < argc) {
+            threads = atoi(argv[++i]);
+        } else if ((a[0] == '-' && a[1] != '\0') || path) {
+            threads = -1;
+            break;
+        } else {
+            path = a;
+        }
+    }
+    if (threads < 0) {
+        stream_usage();
+        return 2;
+    }
+
+    cardid_archive_stats stats;
+    memset(&stats, 0, sizeof(stats));
+    cardid_status st = path && strcmp(path, "-") != 0
+                           ? stream_file(path, threads, &stats)
+                           : cardid_archive_scan_stream(stdin, print_stream_match, NULL, &stats);
+    if (fflush(stdout) != 0 && st == CARDID_OK) st = CARDID_ERR_IO;
+    fprintf(stderr, "format=%s input_bytes=%llu bytes=%llu matches=%llu blocks=%llu threads=%d\n",
+            cardid_archive_format_name(stats.format), stats.input_bytes, stats.bytes,
+            stats.matches, stats.blocks, stats.threads);
+    switch (st) {
+        case CARDID_OK:
+            return 0;
+        case CARDID_ERR_ARG:
+            fprintf(stderr, "cardid: %s input is not supported by this build\n",
+                    cardid_archive_format_name(stats.format));
+            return 1;
+        case CARDID_ERR_FORMAT:
+            fprintf(stderr, "cardid: corrupt or truncated %s data\n",
+                    cardid_archive_format_name(stats.format));
+            return 1;
+        case CARDID_ERR_NOMEM:
+            fprintf(stderr, "cardid: out of memory\n");
+            return 1;
+        default:
+            fprintf(stderr, "cardid: I/O error\n");
+            return 1;
     }
 }
 
+static void follow_usage(void) {
+    fprintf(stderr,
+            "Usage: cardid follow [--checkpoint F] [--interval-ms N] [--once] FILE...\n"
+            "  --checkpoint F    resume from and keep saving positions in F\n"
+            "  --interval-ms N   longest wait between checks (default 1000)\n"
+            "  --once            read what has been appended, save and exit\n");
+}
+
+static volatile sig_atomic_t follow_stop = 0;
+
+static void on_stop_signal(int sig) {
+    (void)sig;
+    follow_stop = 1;
+}
+
+static void print_follow_match(const char* path, const cardid_scan_match* m, void* ctx) {
+    (void)ctx;
+    printf("%s\t%llu:%s:%d\n", path, (unsigned long long)m->offset,
+           cardid_network_name(m->network), m->length);
+}
+
+// cardid follow FILE...: report PANs in appended log data as it arrives.
+static int run_follow_mode(int argc, char** argv) {
+    const char* checkpoint = NULL;
+    int interval_ms = 1000;
+    bool once = false;
+    const char** paths = calloc((size_t)argc, sizeof(*paths));
+    size_t npaths = 0;
+    if (!paths) return 1;
+    for (int i = 2; i < argc; ++i) {
+        const char* a = argv[i];
+        if (strcmp(a, "--checkpoint") == 0 && i + 1 < argc) {
+            checkpoint = argv[++i];
+        } else if (strcmp(a, "--interval-ms") == 0 && i + 1 < argc) {
+            interval_ms = atoi(argv[++i]);
+        } else if (strcmp(a, "--once") == 0) {
+            once = true;
+        } else if (a[0] == '-' && a[1] != '\0') {
+            npaths = 0;
+            break;
+        } else {
+            paths[npaths++] = a;
+        }
+    }
+    if (npaths == 0 || interval_ms <= 0) {
+        follow_usage();
+        free(paths);
+        return 2;
+    }
+
+    cardid_follow* f = cardid_follow_open(paths, npaths, checkpoint);
+    free(paths);
+    if (!f) {
+        fprintf(stderr, "cardid: cannot follow (bad checkpoint or out of memory)\n");
+        return 1;
+    }
+    signal(SIGINT, on_stop_signal);
+    signal(SIGTERM, on_stop_signal);
+
+    cardid_follow_stats stats, saved;
+    memset(&stats, 0, sizeof(stats));
+    memset(&saved, 0, sizeof(saved));
+    int rc = 0;
+    bool first = true;
+    while (!follow_stop) {
+        if (cardid_follow_poll(f, print_follow_match, NULL, &stats) != CARDID_OK) {
+            fprintf(stderr, "cardid: read error\n");
+            rc = 1;
+        }
+        fflush(stdout);
+        // Only rewrite the checkpoint when a position can have moved.
+        if (checkpoint && (first || memcmp(&stats, &saved, sizeof(stats)) != 0)) {
+            if (cardid_follow_save(f) != CARDID_OK) {
+                fprintf(stderr, "cardid: cannot write %s\n", checkpoint);
+                rc = 1;
+                break;
+            }
+            saved = stats;
+        }
+        first = false;
+        if (once || rc) break;
+        cardid_follow_wait(f, interval_ms);
+    }
+    if (checkpoint && rc == 0 && cardid_follow_save(f) != CARDID_OK) rc = 1;
+    fprintf(stderr, "bytes=%llu matches=%llu rotations=%llu truncations=%llu watch=%s\n",
+            stats.bytes, stats.matches, stats.rotations, stats.truncations,
+            cardid_follow_uses_inotify(f) ? "inotify" : "polling");
+    cardid_follow_close(f);
+    return rc;
+}
+
 int main(int argc, char** argv) {
+    if (argc >= 2 && (strcmp(argv[1], "csv") == 0 || strcmp(argv[1], "tsv") == 0 ||
+                      strcmp(argv[1], "ndjson") == 0)) {
+        return run_record_mode(argc, argv);
+    }
+    if (argc >= 2 && strcmp(argv[1], "scan") == 0) return run_scan_mode(argc, argv);
+    if (argc >= 2 && strcmp(argv[1], "follow") == 0) return run_follow_mode(argc, argv);
+    if (argc >= 2 && strcmp(argv[1], "stream") == 0) return run_stream_mode(argc, argv);
+
     char input[256] = {0};
     if (argc >= 2) {
         // Concatenate all args with spaces to allow dashed/spaced inputs
@@ -47,7 +487,7 @@ int main(int argc, char** argv) {
         return 0;
     }
 
-    const char* name = network_name(res.network);
+    const char* name = cardid_network_name(res.network);
     if (res.network == CARD_UNKNOWN) {
         puts("INVALID");
     } else {
@@ -3,6 +3,29 @@
 #include <string.h>
 #include <assert.h>
 #include "../include/cardid.h"
+#include "../include/cardid_archive.h"
+#include "../include/cardid_crawl.h"
+#include "../include/cardid_follow.h"
+#include "../include/cardid_gen.h"
+#include "../include/cardid_metrics.h"
+#include "../include/cardid_record.h"
+#include "../include/cardid_results.h"
+#include "../include/cardid_scan.h"
+#include "../include/cardid_scratch.h"
+#include "../include/cardid_token.h"
+#include "../include/cardid_velocity.h"
+#ifndef _WIN32
+#include <errno.h>
+#include <sys/resource.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+#ifdef CARDID_HAVE_ZLIB
+#include <zlib.h>
+#endif
+#ifdef CARDID_HAVE_ZSTD
+#include <zstd.h>
+#endif
 
 #define TEST_ASSERT(condition, message) \
     do { \
@@ -213,6 +236,1222 @@ static int test_edge_cases() {
     return 0;
 }
 
+static int test_length_delimited() {
+    printf("\n=== Testing Length-Delimited Analysis ===\n");
+
+    // Only the first 19 bytes are part of the input; the tail must be ignored.
+    const char* buf = "4111-1111-1111-1111,5555555555554444";
+    cardid_result result;
+    cardid_analyze_n(buf, 19, &result, NULL);
+    TEST_ASSERT(result.luhn_valid && result.network == CARD_VISA, "Should analyze the prefix only");
+    TEST_ASSERT(result.length == 16, "Should count 16 digits");
+
+    char output[32];
+    cardid_extract_result meta = cardid_extract_digits_n(buf, 4, output, sizeof(output));
+    TEST_ASSERT(meta.digit_count == 4 && strcmp(output, "4111") == 0, "Should stop at input_len");
+
+    TEST_ASSERT(strcmp(cardid_network_name(CARD_AMEX), "AMEX") == 0, "Should name networks");
+
+    TEST_PASS("Length-delimited analysis tests");
+    return 0;
+}
+
+static int stream_string(const cardid_record_config* cfg, const char* input, char* out,
+                         size_t out_cap, cardid_record_stats* stats) {
+    FILE* in = tmpfile();
+    FILE* res = tmpfile();
+    if (!in || !res) return -1;
+    fputs(input, in);
+    rewind(in);
+    cardid_status st = cardid_record_stream(in, res, cfg, stats);
+    rewind(res);
+    size_t n = fread(out, 1, out_cap - 1, res);
+    out[n] = '\0';
+    fclose(in);
+    fclose(res);
+    return st == CARDID_OK ? 0 : -1;
+}
+
+static int test_record_ingestion() {
+    printf("\n=== Testing Record Ingestion ===\n");
+
+    cardid_record_config csv = {CARDID_RECORD_CSV, 0, true, "pan", 0, NULL, NULL};
+    const char* field;
+    size_t len;
+    const char* rec = "7,\"4111 1111, 1111 1111\",x";
+    TEST_ASSERT(cardid_record_field(&csv, 1, rec, strlen(rec), &field, &len), "Should find column");
+    TEST_ASSERT(len == 20 && strncmp(field, "4111 1111, 1111 1111", 20) == 0,
+                "Should unquote field containing the delimiter");
+    TEST_ASSERT(!cardid_record_field(&csv, 3, rec, strlen(rec), &field, &len),
+                "Missing column should not be found");
+
+    char out[512];
+    cardid_record_stats stats;
+    TEST_ASSERT(stream_string(&csv,
+                              "id,pan\n1,4111-1111-1111-1111\r\n2,\"a\nb\"\n3,4111111111111112",
+                              out, sizeof(out), &stats) == 0,
+                "CSV stream should succeed");
+    TEST_ASSERT(strcmp(out,
+                       "id,pan,cardid_valid,cardid_network,cardid_length\n"
+                       "1,4111-1111-1111-1111,true,VISA,16\r\n"
+                       "2,\"a\nb\",false,UNKNOWN,0\n"
+                       "3,4111111111111112,false,UNKNOWN,16") == 0,
+                "CSV output should append result columns and keep records intact");
+    TEST_ASSERT(stats.records == 3 && stats.valid == 1 && stats.missing == 0, "CSV stats");
+
+    // A stray quote inside an unquoted field is data, not the start of a quoted
+    // section that would swallow the following records
+    cardid_record_config desc = {CARDID_RECORD_CSV, 0, true, "pan", 0, NULL, NULL};
+    TEST_ASSERT(stream_string(&desc,
+                              "id,desc,pan\n1,5\" screen,4111111111111111\n"
+                              "2,\"say \"\"hi\"\"\nthere\",5555555555554444\n3,ok,378282246310005\n",
+                              out, sizeof(out), &stats) == 0,
+                "CSV stream with stray quote should succeed");
+    TEST_ASSERT(strcmp(out,
+                       "id,desc,pan,cardid_valid,cardid_network,cardid_length\n"
+                       "1,5\" screen,4111111111111111,true,VISA,16\n"
+                       "2,\"say \"\"hi\"\"\nthere\",5555555555554444,true,MASTERCARD,16\n"
+                       "3,ok,378282246310005,true,AMEX,15\n") == 0,
+                "Records after a stray quote should still be split");
+    TEST_ASSERT(stats.records == 3 && stats.valid == 3, "Stray quote stats");
+
+    cardid_record_config json = {CARDID_RECORD_NDJSON, 0, false, "pan", 0, NULL, NULL};
+    TEST_ASSERT(stream_string(&json,
+                              "{\"o\":{\"pan\":\"1\"},\"pan\":\"378282246310005\"}\n{}\n",
+                              out, sizeof(out), &stats) == 0,
+                "NDJSON stream should succeed");
+    TEST_ASSERT(strcmp(out,
+                       "{\"o\":{\"pan\":\"1\"},\"pan\":\"378282246310005\",\"cardid_valid\":true,"
+                       "\"cardid_network\":\"AMEX\",\"cardid_length\":15}\n"
+                       "{\"cardid_valid\":false,\"cardid_network\":\"UNKNOWN\",\"cardid_length\":0}\n") ==
+                    0,
+                "NDJSON output should use the top-level field only");
+    TEST_ASSERT(stats.records == 2 && stats.valid == 1 && stats.missing == 1, "NDJSON stats");
+
+    cardid_record_config bad = {CARDID_RECORD_CSV, 0, true, "nope", 0, NULL, NULL};
+    TEST_ASSERT(stream_string(&bad, "id,pan\n1,2\n", out, sizeof(out), NULL) != 0,
+                "Unknown column should fail");
+
+    TEST_PASS("Record ingestion tests");
+    return 0;
+}
+
+static int test_metrics() {
+    printf("\n=== Testing Metrics ===\n");
+
+    if (!cardid_metrics_available()) {
+        TEST_ASSERT(!cardid_metrics_enabled(), "Compiled-out metrics stay disabled");
+        TEST_PASS("Metrics tests (compiled out)");
+        return 0;
+    }
+
+    cardid_metrics_snapshot before, after;
+    cardid_metrics_read(&before);
+    cardid_result result;
+    cardid_analyze("4111111111111111", &result, NULL);  // not counted while disabled
+
+    cardid_metrics_enable(true);
+    const char* inputs[] = {
+        "4111111111111111", "378282246310005", "4111111111111112", "12345678901234",
+        "1234", "", "12345678901234567890", "1234567890123452",
+    };
+    cardid_result results[8];
+    cardid_analyze_batch(inputs, 8, results);
+    cardid_metrics_enable(false);
+    cardid_metrics_read(&after);
+
+    static const int expected[CARDID_OUTCOME_COUNT] = {2, 1, 1, 1, 1, 1, 1};
+    for (int i = 0; i < CARDID_OUTCOME_COUNT; ++i) {
+        TEST_ASSERT(after.outcome[i] - before.outcome[i] == (uint64_t)expected[i],
+                    "Each outcome should be counted once per analysis");
+    }
+    TEST_ASSERT(after.network[CARD_VISA] - before.network[CARD_VISA] == 1, "Visa count");
+    TEST_ASSERT(after.network[CARD_AMEX] - before.network[CARD_AMEX] == 1, "Amex count");
+
+    char text[4096];
+    size_t need = cardid_metrics_format_prometheus(text, sizeof(text));
+    TEST_ASSERT(need < sizeof(text), "Prometheus output should fit");
+    TEST_ASSERT(strstr(text, "# TYPE cardid_analyze_total counter") != NULL, "Counter family");
+    TEST_ASSERT(strstr(text, "cardid_batch_duration_seconds_count{path=\"analyze_batch\"}") != NULL,
+                "Batch histogram");
+    TEST_ASSERT(cardid_metrics_format_prometheus(NULL, 0) == need, "Size query should match");
+
+    TEST_PASS("Metrics tests");
+    return 0;
+}
+
+static int test_tokenization() {
+    printf("\n=== Testing Tokenization ===\n");
+
+    // SipHash-2-4 reference vectors: key 00..0f, messages 00..(n-1)
+    cardid_token_key key = {0x0706050403020100ULL, 0x0f0e0d0c0b0a0908ULL};
+    unsigned char msg[8] = {0, 1, 2, 3, 4, 5, 6, 7};
+    TEST_ASSERT(cardid_siphash24(&key, msg, 0) == 0x726fdb47dd0e0e31ULL, "SipHash empty vector");
+    TEST_ASSERT(cardid_siphash24(&key, msg, 8) == 0x93f5f5799a932462ULL, "SipHash 8-byte vector");
+
+    TEST_ASSERT(cardid_pack_digits("4111111111111111", 16) == 4111111111111111ULL, "Pack digits");
+    TEST_ASSERT(cardid_pack_digits("9999999999999999999", 19) == 9999999999999999999ULL,
+                "Pack 19 digits");
+
+    // cardid_token64 is SipHash over LE64(value) || LE64(length)
+    unsigned char block[16] = {0};
+    uint64_t value = 4111111111111111ULL;
+    for (int i = 0; i < 8; i++) block[i] = (unsigned char)(value >> (8 * i));
+    block[8] = 16;
+    uint64_t visa_token = cardid_token64(&key, "4111111111111111", 16);
+    TEST_ASSERT(visa_token == cardid_siphash24(&key, block, 16), "Token layout");
+    TEST_ASSERT(visa_token != cardid_token64(&key, "0004111111111111111", 19),
+                "Leading zeros should change the token");
+
+    // Batch path: same tokens as the scalar path, 0 for rejected inputs
+    const char* inputs[] = {
+        "4111-1111-1111-1111", "5555555555554444", "4111111111111112", "378282246310005",
+        NULL, "6011 1111 1111 1117", "1234", "2223003122003222", "4532015112830366",
+        "6500000000000002",
+    };
+    const char* digits[] = {
+        "4111111111111111", "5555555555554444", NULL, "378282246310005", NULL,
+        "6011111111111117", NULL, "2223003122003222", "4532015112830366", "6500000000000002",
+    };
+    cardid_result results[10];
+    uint64_t tokens[10];
+    cardid_analyze_tokenize_batch(&key, inputs, 10, results, tokens);
+    for (int i = 0; i < 10; i++) {
+        uint64_t expected = digits[i] ? cardid_token64(&key, digits[i], (int)strlen(digits[i])) : 0;
+        TEST_ASSERT(tokens[i] == expected, "Batch token should match scalar token");
+        bool valid = results[i].luhn_valid && results[i].network != CARD_UNKNOWN;
+        TEST_ASSERT((digits[i] != NULL) == valid, "Batch results should match cardid_analyze");
+    }
+
+    // Format-preserving token keeps BIN and last 4, fails Luhn, is deterministic
+    char fpt[20], again[20];
+    TEST_ASSERT(cardid_token_fpt(&key, "4111111111111111", 16, fpt), "FPT should succeed");
+    TEST_ASSERT(strncmp(fpt, "411111", 6) == 0 && strcmp(fpt + 12, "1111") == 0,
+                "FPT should keep BIN and last 4");
+    TEST_ASSERT(!cardid_luhn_digits(fpt, 16), "FPT token should fail Luhn");
+    cardid_token_fpt(&key, "4111111111111111", 16, again);
+    TEST_ASSERT(strcmp(fpt, again) == 0, "FPT should be deterministic");
+    TEST_ASSERT(!cardid_token_fpt(&key, "411111111111", 12, fpt), "FPT rejects short PANs");
+    TEST_ASSERT(!cardid_token_fpt(&key, "4111111111111112", 16, fpt), "FPT rejects Luhn failures");
+    TEST_ASSERT(!cardid_token_fpt(&key, again, 16, fpt), "FPT tokens are not re-tokenized");
+
+    // FPT is injective: every valid PAN sharing a BIN, last 4 and length (all 100
+    // at 13 digits, all 100000 at 16) gets its own token, all failing Luhn.
+    static unsigned char seen[1000000 / 8];
+    const int lens[] = {13, 16};
+    for (int l = 0; l < 2; l++) {
+        int len = lens[l], n = len - 11;
+        int count = 1;
+        for (int i = 0; i < n; i++) count *= 10;
+        memset(seen, 0, sizeof(seen));
+        int distinct = 0, luhn_valid = 0;
+        char pan[20];
+        memcpy(pan, "4111110000000000000", (size_t)len);
+        memcpy(pan + len - 4, "1111", 5);
+        for (int m = 0; m < count; m++) {
+            for (int i = 0, x = m; i < n; i++, x /= 10) pan[6 + n - 1 - i] = (char)('0' + x % 10);
+            for (char c = '0'; c <= '9'; c++) {  // the one middle digit that passes Luhn
+                pan[len - 5] = c;
+                if (cardid_luhn_digits(pan, len)) break;
+            }
+            if (!cardid_token_fpt(&key, pan, len, fpt)) break;
+            luhn_valid += cardid_luhn_digits(fpt, len);
+            uint32_t mid = (uint32_t)cardid_pack_digits(fpt + 6, len - 10);
+            if (!(seen[mid / 8] & (1u << (mid % 8)))) ++distinct;
+            seen[mid / 8] |= (unsigned char)(1u << (mid % 8));
+        }
+        TEST_ASSERT(distinct == count && luhn_valid == 0, "FPT tokens should not collide");
+    }
+
+    TEST_PASS("Tokenization tests");
+    return 0;
+}
+
+static int test_generator() {
+    printf("\n=== Testing Corpus Generator ===\n");
+
+    cardid_gen_config cfg;
+    memset(&cfg, 0, sizeof(cfg));
+    cfg.seed = 42;
+    cfg.separator_rate = 0.5;
+    cardid_gen gen;
+    TEST_ASSERT(cardid_gen_init(&gen, &cfg) == CARDID_OK, "Default config should init");
+
+    int seen[CARD_DISCOVER + 1] = {0};
+    char text[CARDID_GEN_MAX_TEXT + 1];
+    for (int i = 0; i < 10000; i++) {
+        int n = cardid_gen_next(&gen, text);
+        text[n] = '\0';
+        cardid_result result;
+        cardid_analyze(text, &result, NULL);
+        TEST_ASSERT(result.luhn_valid && result.network != CARD_UNKNOWN,
+                    "Generated PANs should validate");
+        seen[result.network]++;
+    }
+    for (int n = CARD_VISA; n <= CARD_DISCOVER; n++) {
+        TEST_ASSERT(seen[n] > 1500, "Even mix should produce every network");
+    }
+
+    // Network/length mix and invalid rate are honoured
+    memset(&cfg, 0, sizeof(cfg));
+    cfg.network_weight[CARD_VISA] = 1;
+    cfg.length_weight[19] = 1;
+    cfg.invalid_rate = 1.0;
+    TEST_ASSERT(cardid_gen_init(&gen, &cfg) == CARDID_OK, "Visa-19 config should init");
+    for (int i = 0; i < 1000; i++) {
+        int n = cardid_gen_next(&gen, text);
+        TEST_ASSERT(n == 19 && text[0] == '4', "Should generate 19-digit Visa");
+        TEST_ASSERT(!cardid_luhn_digits(text, n), "Invalid rate 1 should break every checksum");
+    }
+
+    // Amex only issues length 15, so an Amex-only mix restricted to 16 is empty
+    memset(&cfg, 0, sizeof(cfg));
+    cfg.network_weight[CARD_AMEX] = 1;
+    cfg.length_weight[16] = 1;
+    TEST_ASSERT(cardid_gen_init(&gen, &cfg) == CARDID_ERR_ARG, "Unissuable mix should fail");
+
+    char buf[4096];
+    size_t records;
+    memset(&cfg, 0, sizeof(cfg));
+    cardid_gen_init(&gen, &cfg);
+    size_t used = cardid_gen_fill(&gen, CARDID_GEN_BINARY, buf, sizeof(buf), 10, &records);
+    TEST_ASSERT(records == 10, "Fill should stop at max_records");
+    size_t pos = 0;
+    for (size_t i = 0; i < records; i++) pos += 1 + (unsigned char)buf[pos];
+    TEST_ASSERT(pos == used, "Binary records should be length-prefixed");
+
+    TEST_PASS("Corpus generator tests");
+    return 0;
+}
+
+static int test_bin_enumerator() {
+    printf("\n=== Testing BIN Enumerator ===\n");
+
+    // 16-digit PANs under 41111111109..41111111110: carries ripple through the prefix
+    cardid_bin_enum e;
+    TEST_ASSERT(cardid_bin_enum_init(&e, "41111111109", "41111111110", 16) == CARDID_OK,
+                "Enumerator should init");
+    const char* pan;
+    int count = 0;
+    char first[20] = "", last[20] = "";
+    while ((pan = cardid_bin_enum_next(&e)) != NULL) {
+        TEST_ASSERT(strlen(pan) == 16, "Enumerated PAN length");
+        TEST_ASSERT(cardid_luhn_digits(pan, 16), "Enumerated PANs should pass Luhn");
+        if (count == 0) strcpy(first, pan);
+        strcpy(last, pan);
+        count++;
+    }
+    TEST_ASSERT(count == 20000, "Should enumerate 2 * 10^4 PANs");
+    TEST_ASSERT(strncmp(first, "411111111090000", 15) == 0, "First PAN");
+    TEST_ASSERT(strncmp(last, "411111111109999", 15) == 0, "Last PAN");
+
+    TEST_ASSERT(cardid_bin_enum_init(&e, "4111", "411", 16) == CARDID_ERR_ARG,
+                "Mismatched prefix lengths should fail");
+    TEST_ASSERT(cardid_bin_enum_init(&e, "4112", "4111", 16) == CARDID_ERR_ARG,
+                "Reversed range should fail");
+
+    TEST_PASS("BIN enumerator tests");
+    return 0;
+}
+
+static int test_scratch_arena() {
+    printf("\n=== Testing Scratch Arena ===\n");
+
+    cardid_scratch* arena = cardid_scratch_thread();
+    TEST_ASSERT(arena != NULL, "Thread arena should be created");
+    TEST_ASSERT(cardid_scratch_thread() == arena, "Arena should be reused by the same thread");
+    printf("Arena locked: %s, excluded from core dumps: %s\n",
+           cardid_scratch_locked(arena) ? "yes" : "no",
+           cardid_scratch_dontdump(arena) ? "yes" : "no");
+
+    size_t mark = cardid_scratch_mark(arena);
+    char* a = cardid_scratch_alloc(arena, 20);
+    char* b = cardid_scratch_alloc(arena, 3);
+    TEST_ASSERT(a && b, "Allocations should succeed");
+    TEST_ASSERT(((size_t)b & 15) == 0, "Allocations should be 16-byte aligned");
+    memcpy(a, "4111111111111111", 17);
+    memcpy(b, "12", 3);
+    cardid_scratch_release(arena, mark);
+    TEST_ASSERT(cardid_scratch_mark(arena) == mark, "Release should rewind to the mark");
+    for (int i = 0; i < 20; i++) TEST_ASSERT(a[i] == 0, "Release should wipe used bytes");
+    TEST_ASSERT(b[0] == 0 && b[1] == 0, "Release should wipe every allocation");
+    TEST_ASSERT(cardid_scratch_alloc(arena, CARDID_SCRATCH_BYTES + 1) == NULL,
+                "Oversized allocation should fail");
+
+    // Batch analysis borrows from the arena and gives it back
+    const char* inputs[] = {"4111111111111111", "378282246310005", NULL};
+    cardid_result results[3];
+    cardid_analyze_batch(inputs, 3, results);
+    TEST_ASSERT(results[0].network == CARD_VISA && results[1].network == CARD_AMEX,
+                "Batch analysis should match single analysis");
+    TEST_ASSERT(results[2].length == 0 && !results[2].luhn_valid, "NULL input in batch");
+    TEST_ASSERT(cardid_scratch_mark(arena) == mark, "Batch should release its scratch");
+
+    char buf[8] = {1, 2, 3, 4, 5, 6, 7, 8};
+    cardid_secure_zero(buf, sizeof(buf));
+    for (int i = 0; i < 8; i++) TEST_ASSERT(buf[i] == 0, "Secure zero should clear");
+
+    TEST_PASS("Scratch arena tests");
+    return 0;
+}
+
+typedef struct {
+    cardid_scan_match m[256];
+    int n;
+} match_list;
+
+static void collect_match(const cardid_scan_match* m, void* ctx) {
+    match_list* l = (match_list*)ctx;
+    if (l->n < 256) l->m[l->n] = *m;
+    l->n++;
+}
+
+static void scan_chunked(const char* text, size_t len, size_t chunk, match_list* out) {
+    cardid_scanner s;
+    cardid_scanner_init(&s, 0);
+    out->n = 0;
+    for (size_t i = 0; i < len; i += chunk) {
+        cardid_scanner_feed(&s, text + i, len - i < chunk ? len - i : chunk, collect_match, out);
+    }
+    cardid_scanner_finish(&s, collect_match, out);
+}
+
+static int same_matches(const match_list* a, const match_list* b) {
+    if (a->n != b->n) return 0;
+    for (int i = 0; i < a->n && i < 256; i++) {
+        if (a->m[i].offset != b->m[i].offset || a->m[i].span != b->m[i].span ||
+            a->m[i].length != b->m[i].length || a->m[i].network != b->m[i].network)
+            return 0;
+    }
+    return 1;
+}
+
+static int test_scanner() {
+    printf("\n=== Testing Stream Scanner ===\n");
+
+    const char* text =
+        "pan 4111 1111 1111 1111, amex 3782-822463-10005 end\n"
+        "two 4111111111111111 5555555555554444 adjacent\n"
+        "glued x4111111111111111 and 4111111111111111y and 94111111111111111\n"
+        "bad luhn 4111111111111112 double  sep 4111  1111 1111 1111\n"
+        "long 12345678901234567890123 tail 6011111111111117";
+    size_t len = strlen(text);
+    match_list whole;
+    scan_chunked(text, len, len, &whole);
+    TEST_ASSERT(whole.n == 5, "Scanner should find exactly the five real PANs");
+    TEST_ASSERT(whole.m[0].offset == 4 && whole.m[0].span == 19 && whole.m[0].length == 16 &&
+                    whole.m[0].network == CARD_VISA,
+                "Spaced Visa should report offset and span");
+    TEST_ASSERT(whole.m[1].network == CARD_AMEX && whole.m[1].length == 15, "Dashed Amex");
+    TEST_ASSERT(whole.m[2].network == CARD_VISA && whole.m[3].network == CARD_MASTERCARD,
+                "Space-separated PANs should be reported separately");
+    TEST_ASSERT(whole.m[4].network == CARD_DISCOVER, "PAN at end of stream");
+
+    // Chunk boundaries never change the result
+    size_t chunks[] = {1, 2, 3, 7, 16, 17, 64};
+    for (size_t i = 0; i < sizeof(chunks) / sizeof(chunks[0]); i++) {
+        match_list part;
+        scan_chunked(text, len, chunks[i], &part);
+        TEST_ASSERT(same_matches(&whole, &part), "Chunked scan should match whole scan");
+    }
+
+    // Resuming a fresh scanner from resume_offset reproduces the rest of the scan
+    for (size_t split = 0; split <= len; split++) {
+        match_list a = {0}, b = {0};
+        cardid_scanner s;
+        cardid_scanner_init(&s, 0);
+        cardid_scanner_feed(&s, text, split, collect_match, &a);
+        uint64_t r = cardid_scanner_resume_offset(&s);
+        TEST_ASSERT(r <= split, "Resume offset should not be past the data fed");
+        cardid_scanner_init(&s, r);
+        cardid_scanner_feed(&s, text + r, len - (size_t)r, collect_match, &b);
+        cardid_scanner_finish(&s, collect_match, &b);
+        for (int i = 0; i < b.n; i++) a.m[a.n++] = b.m[i];
+        TEST_ASSERT(same_matches(&whole, &a), "Resumed scan should match whole scan");
+    }
+
+    // Generated corpus: every valid PAN on its own line is found
+    cardid_gen_config cfg;
+    memset(&cfg, 0, sizeof(cfg));
+    cfg.seed = 7;
+    cfg.separator_rate = 0.5;
+    cardid_gen gen;
+    cardid_gen_init(&gen, &cfg);
+    char corpus[200 * (CARDID_GEN_MAX_TEXT + 1)];
+    size_t records;
+    size_t n = cardid_gen_fill(&gen, CARDID_GEN_LINES, corpus, sizeof(corpus), 200, &records);
+    match_list found;
+    scan_chunked(corpus, n, 4096, &found);
+    TEST_ASSERT(found.n == (int)records, "Every generated PAN should be found");
+
+    TEST_PASS("Stream scanner tests");
+    return 0;
+}
+
+static int test_velocity() {
+    printf("\n=== Testing Velocity Tracking ===\n");
+
+    cardid_velocity_config bad = {0, 9, 0, 0, 0};
+    TEST_ASSERT(cardid_velocity_create(&bad) == NULL, "Depth above the maximum should be rejected");
+    bad.depth = 4;
+    bad.slices = 1;
+    TEST_ASSERT(cardid_velocity_create(&bad) == NULL, "A one-slice ring should be rejected");
+
+    cardid_velocity_config cfg = {1000, 4, 5, 1000, 42};
+    cardid_velocity* v = cardid_velocity_create(&cfg);
+    TEST_ASSERT(v != NULL, "Tracker should be created");
+    TEST_ASSERT(cardid_velocity_memory(v) == 5 * 64 + 5 * 4 * 1024 * sizeof(uint32_t),
+                "Width should round up to a power of two and memory should be fixed");
+    double eps, delta;
+    cardid_velocity_bounds(v, &eps, &delta);
+    TEST_ASSERT(eps > 0.00265 && eps < 0.00266, "Epsilon should be e / width");
+    TEST_ASSERT(delta > 0.0183 && delta < 0.0184, "Delta should be e^-depth");
+
+    uint64_t a = cardid_velocity_key("4111111111111111", 16);
+    uint64_t b = cardid_velocity_key("5555555555554444", 16);
+    TEST_ASSERT(a != b && a != cardid_velocity_key("0004111111111111111", 19),
+                "Keys should differ by value and by length");
+    // 5e17 ^ (18 << 59) == 1076460752303423488 ^ (19 << 59): folding the length
+    // into the top bits aliased these two
+    TEST_ASSERT(cardid_velocity_key("500000000000000000", 18) !=
+                    cardid_velocity_key("1076460752303423488", 19),
+                "Keys of different lengths should not alias");
+    for (int i = 0; i < 3; ++i) cardid_velocity_add(v, a, 100);
+    cardid_velocity_add(v, b, 500);
+    TEST_ASSERT(cardid_velocity_count(v, a, 1000, 999) == 3, "Count within one slice");
+    TEST_ASSERT(cardid_velocity_count(v, b, 1000, 999) == 1, "Other key counted apart");
+
+    cardid_velocity_add(v, a, 1500);
+    TEST_ASSERT(cardid_velocity_count(v, a, 2000, 1500) == 4, "Window of two slices");
+    TEST_ASSERT(cardid_velocity_count(v, a, 1000, 1500) == 1, "Window of the current slice");
+    TEST_ASSERT(cardid_velocity_total(v, 2000, 1500) == 5, "Total over the window");
+    TEST_ASSERT(cardid_velocity_count(v, a, 1000000, 1500) == 4,
+                "Oversized windows should clamp to the ring");
+
+    cardid_velocity_add(v, b, 10000);
+    TEST_ASSERT(cardid_velocity_count(v, a, 4000, 10000) == 0, "Old slices should expire");
+    TEST_ASSERT(cardid_velocity_count(v, a, 2000, 1500) == 0,
+                "Reused slots should not answer for their old epoch");
+    cardid_velocity_add(v, a, 100);
+    TEST_ASSERT(cardid_velocity_total(v, 4000, 10000) == 1,
+                "Events older than the ring should be dropped");
+
+    cardid_result r;
+    TEST_ASSERT(cardid_velocity_observe(v, "4111-1111-1111-1111", 19, 10100, 1000, &r) == 1,
+                "First observation counts itself");
+    TEST_ASSERT(r.network == CARD_VISA && r.luhn_valid, "Observe should fill in the analysis");
+    TEST_ASSERT(cardid_velocity_observe(v, "4111111111111111", 16, 10200, 1000, NULL) == 2,
+                "Formatting should not change the key");
+    TEST_ASSERT(cardid_velocity_observe(v, "4111111111111112", 16, 10300, 1000, &r) == 0 &&
+                    !r.luhn_valid,
+                "Invalid PANs should not be counted");
+    TEST_ASSERT(cardid_velocity_observe(v, NULL, 0, 10300, 1000, &r) == 0, "NULL input");
+    cardid_velocity_destroy(v);
+
+    // A narrow sketch collides constantly but must never undercount.
+    cardid_velocity_config narrow = {64, 2, 4, 1000, 7};
+    v = cardid_velocity_create(&narrow);
+    TEST_ASSERT(v != NULL, "Narrow tracker should be created");
+    unsigned exact[200] = {0};
+    uint32_t x = 12345;
+    for (int i = 0; i < 5000; ++i) {
+        x = x * 1103515245u + 12345u;
+        unsigned k = (x >> 8) % 200;
+        ++exact[k];
+        cardid_velocity_add(v, k, 1000 + (uint64_t)i / 2);
+    }
+    for (unsigned k = 0; k < 200; ++k) {
+        TEST_ASSERT(cardid_velocity_count(v, k, 3000, 3499) >= exact[k],
+                    "Count-min estimates should never be below the true count");
+    }
+    cardid_velocity_destroy(v);
+
+    TEST_PASS("Velocity tracking tests");
+    return 0;
+}
+
+#ifndef _WIN32
+static int write_file(const char* path, const char* text) {
+    FILE* f = fopen(path, "wb");
+    if (!f) return 0;
+    fputs(text, f);
+    return fclose(f) == 0;
+}
+
+// Testing hook in the library (src/cardid_internal.h): caps each crawler read.
+extern size_t cardid_crawl_read_limit;
+
+static int crawl_dir(const char* root, const cardid_crawl_config* cfg, char* report, size_t cap,
+                     cardid_crawl_stats* stats) {
+    FILE* out = tmpfile();
+    if (!out) return 0;
+    const char* roots[] = {root};
+    cardid_status st = cardid_crawl(roots, 1, out, cfg, stats);
+    rewind(out);
+    size_t n = fread(report, 1, cap - 1, out);
+    report[n] = '\0';
+    fclose(out);
+    return st == CARDID_OK;
+}
+
+static int test_crawl() {
+    printf("\n=== Testing Filesystem Crawl ===\n");
+
+    char root[] = "/tmp/cardid_crawl_XXXXXX";
+    TEST_ASSERT(mkdtemp(root) != NULL, "Temp dir");
+    char sub[64], a[96], b[96], manifest[96];
+    snprintf(sub, sizeof(sub), "%s/sub", root);
+    snprintf(a, sizeof(a), "%s/a.log", root);
+    snprintf(b, sizeof(b), "%s/b.txt", sub);
+    snprintf(manifest, sizeof(manifest), "%s.manifest", root);  // outside the crawled tree
+    TEST_ASSERT(mkdir(sub, 0700) == 0, "Subdir");
+    TEST_ASSERT(write_file(a, "user paid with 4111 1111 1111 1111\n"), "Write a");
+    TEST_ASSERT(write_file(b, "nothing here 12345\n"), "Write b");
+
+    cardid_crawl_config cfg;
+    memset(&cfg, 0, sizeof(cfg));
+    cfg.threads = 2;
+    cfg.buffer_size = 8;  // many reads per file so the read pipeline wraps
+    cfg.manifest_in = cfg.manifest_out = manifest;
+    char report[1024];
+    cardid_crawl_stats stats;
+    for (int io = CARDID_CRAWL_IO_AUTO; io <= CARDID_CRAWL_IO_PREAD; io++) {
+        if (io == CARDID_CRAWL_IO_URING) continue;  // kernel may refuse io_uring
+        cfg.io = (cardid_crawl_io)io;
+        cfg.manifest_in = NULL;
+        TEST_ASSERT(crawl_dir(root, &cfg, report, sizeof(report), &stats), "Crawl should succeed");
+        TEST_ASSERT(stats.files_scanned == 2 && stats.matches == 1, "One PAN in two files");
+        TEST_ASSERT(strstr(report, "a.log\t1\t15:VISA:16\n") != NULL, "Report names file and offset");
+        TEST_ASSERT(strstr(report, "4111") == NULL, "Report must not contain PAN digits");
+    }
+
+    // Short reads are resumed, not taken for truncation: each 8-byte chunk now
+    // arrives in 3-byte reads, through io_uring when the kernel allows it
+    cardid_crawl_read_limit = 3;
+    for (int io = CARDID_CRAWL_IO_AUTO; io <= CARDID_CRAWL_IO_PREAD; io++) {
+        if (io == CARDID_CRAWL_IO_URING) continue;
+        cfg.io = (cardid_crawl_io)io;
+        TEST_ASSERT(crawl_dir(root, &cfg, report, sizeof(report), &stats), "Crawl should succeed");
+        TEST_ASSERT(stats.files_scanned == 2 && stats.files_failed == 0 &&
+                        stats.bytes_scanned == 35 + 19 && stats.matches == 1,
+                    "Short reads should still scan whole files");
+        TEST_ASSERT(strstr(report, "a.log\t1\t15:VISA:16\n") != NULL, "Short-read report");
+    }
+    cardid_crawl_read_limit = 0;
+
+    // Unchanged files are skipped on the next run; a changed one is rescanned
+    cfg.manifest_in = manifest;
+    TEST_ASSERT(crawl_dir(root, &cfg, report, sizeof(report), &stats), "Second crawl");
+    TEST_ASSERT(stats.files_skipped == 2 && stats.files_scanned == 0, "Manifest skips unchanged");
+    TEST_ASSERT(write_file(b, "now 5555555555554444 and more text\n"), "Rewrite b");
+    TEST_ASSERT(crawl_dir(root, &cfg, report, sizeof(report), &stats), "Third crawl");
+    TEST_ASSERT(stats.files_skipped == 1 && stats.files_scanned == 1 && stats.matches == 1,
+                "Changed file should be rescanned");
+    TEST_ASSERT(strstr(report, "b.txt\t1\t4:MASTERCARD:16\n") != NULL, "Rescan report");
+
+    remove(manifest);
+    remove(a);
+    remove(b);
+    rmdir(sub);
+    rmdir(root);
+    TEST_PASS("Filesystem crawl tests");
+    return 0;
+}
+
+static int append_file(const char* path, const char* text) {
+    FILE* f = fopen(path, "ab");
+    if (!f) return 0;
+    fputs(text, f);
+    return fclose(f) == 0;
+}
+
+static void collect_follow(const char* path, const cardid_scan_match* m, void* ctx) {
+    (void)path;
+    collect_match(m, ctx);
+}
+
+static int test_follow() {
+    printf("\n=== Testing Tail Follow ===\n");
+
+    char dir[] = "/tmp/cardid_follow_XXXXXX";
+    TEST_ASSERT(mkdtemp(dir) != NULL, "Temp dir");
+    char log[96], rotated[96], cp[96];
+    snprintf(log, sizeof(log), "%s/app.log", dir);
+    snprintf(rotated, sizeof(rotated), "%s/app.log.1", dir);
+    snprintf(cp, sizeof(cp), "%s/checkpoint", dir);
+    const char* paths[] = {log};
+
+    // The path may appear after following starts
+    cardid_follow* f = cardid_follow_open(paths, 1, cp);
+    TEST_ASSERT(f != NULL, "Follow should open without the file or a checkpoint");
+    match_list got = {0};
+    cardid_follow_stats stats;
+    memset(&stats, 0, sizeof(stats));
+    TEST_ASSERT(cardid_follow_poll(f, collect_follow, &got, &stats) == CARDID_OK, "Empty poll");
+
+    // A PAN split across two appends is found once both halves are in
+    TEST_ASSERT(write_file(log, "paid 4111 1111 "), "Write log");
+    cardid_follow_poll(f, collect_follow, &got, &stats);
+    TEST_ASSERT(got.n == 0, "Half a PAN is not reported");
+    TEST_ASSERT(append_file(log, "1111 1111 ok\n"), "Append");
+    cardid_follow_poll(f, collect_follow, &got, &stats);
+    TEST_ASSERT(got.n == 1 && got.m[0].offset == 5 && got.m[0].network == CARD_VISA,
+                "Split PAN should be reported after the second append");
+    TEST_ASSERT(stats.bytes == 28, "Each byte is read once");
+
+    // Checkpoint mid-PAN, restart, and the PAN is still found without rereading
+    TEST_ASSERT(append_file(log, "again 5555 5555"), "Append half");
+    cardid_follow_poll(f, collect_follow, &got, &stats);
+    TEST_ASSERT(cardid_follow_save(f) == CARDID_OK, "Save checkpoint");
+    cardid_follow_close(f);
+    TEST_ASSERT(append_file(log, " 5555 4444\n"), "Append other half");
+    f = cardid_follow_open(paths, 1, cp);
+    TEST_ASSERT(f != NULL, "Reopen from checkpoint");
+    memset(&stats, 0, sizeof(stats));
+    got.n = 0;
+    cardid_follow_poll(f, collect_follow, &got, &stats);
+    TEST_ASSERT(got.n == 1 && got.m[0].offset == 34 && got.m[0].network == CARD_MASTERCARD,
+                "PAN spanning the restart should be found");
+    TEST_ASSERT(stats.bytes < 30, "Restart should reread only the pending run");
+
+    // Rotation: the renamed file keeps being drained until the new one has data
+    TEST_ASSERT(rename(log, rotated) == 0, "Rotate");
+    cardid_follow_poll(f, collect_follow, &got, &stats);
+    TEST_ASSERT(append_file(rotated, "late 378282246310005\n"), "Late write to old file");
+    TEST_ASSERT(write_file(log, "new 6011111111111117\n"), "New file");
+    got.n = 0;
+    cardid_follow_poll(f, collect_follow, &got, &stats);
+    TEST_ASSERT(stats.rotations == 1, "Rotation should be counted");
+    TEST_ASSERT(got.n == 2, "Both the late write and the new file should be scanned");
+
+    // Truncation restarts at offset 0
+    TEST_ASSERT(write_file(log, "x\n"), "Truncate");
+    got.n = 0;
+    cardid_follow_poll(f, collect_follow, &got, &stats);
+    TEST_ASSERT(stats.truncations == 1 && got.n == 0, "Truncation should be detected");
+    TEST_ASSERT(append_file(log, "4111111111111111\n"), "Append after truncation");
+    cardid_follow_poll(f, collect_follow, &got, &stats);
+    TEST_ASSERT(got.n == 1 && got.m[0].offset == 2, "Scan resumes in the truncated file");
+    cardid_follow_close(f);
+
+    remove(log);
+    remove(rotated);
+    remove(cp);
+    rmdir(dir);
+    TEST_PASS("Tail follow tests");
+    return 0;
+}
+
+// Record i of the result-file test input; NULL means the pan column is missing.
+static const char* results_pan(int i) {
+    static const char* pans[] = {"4111111111111111", "378282246310005", "4111111111111112", NULL,
+                                 "5555555555554444"};
+    // A block of consecutive AMEX records gives a multi-record network range.
+    return i >= 100 && i < 150 ? pans[1] : pans[i % 5];
+}
+
+static uint32_t pan_bin(const char* pan) {
+    uint32_t bin = 0;
+    for (int k = 0; k < 6; k++) bin = bin * 10 + (uint32_t)(pan[k] - '0');
+    return bin;
+}
+
+extern size_t cardid_results_posting_chunk;
+
+static int test_results_file() {
+    printf("\n=== Testing Result Files ===\n");
+
+    enum { ROWS = 300 };
+    static char input[ROWS * 24 + 16];
+    static char out[ROWS * 64 + 128];
+    uint64_t offsets[ROWS];
+    cardid_result expect[ROWS];
+    size_t len = (size_t)sprintf(input, "id,pan\n");
+    for (int i = 0; i < ROWS; i++) {
+        const char* pan = results_pan(i);
+        offsets[i] = len;
+        len += (size_t)(pan ? sprintf(input + len, "%d,%s\n", i, pan) : sprintf(input + len, "%d\n", i));
+        expect[i] = (cardid_result){CARD_UNKNOWN, false, 0};
+        if (pan) cardid_analyze(pan, &expect[i], NULL);
+    }
+
+    char dir[] = "/tmp/cardid_results_XXXXXX";
+    TEST_ASSERT(mkdtemp(dir) != NULL, "Temp dir");
+    char path[64];
+    snprintf(path, sizeof(path), "%s/out.cidr", dir);
+    cardid_record_config csv = {CARDID_RECORD_CSV, 0, true, "pan", 0, NULL, NULL};
+    TEST_ASSERT(cardid_results_writer_open(path, &csv.results) == CARDID_OK, "Writer should open");
+    TEST_ASSERT(stream_string(&csv, input, out, sizeof(out), NULL) == 0, "CSV stream should succeed");
+    TEST_ASSERT(cardid_results_writer_close(csv.results) == CARDID_OK, "Writer should close");
+
+    cardid_results* r = NULL;
+    TEST_ASSERT(cardid_results_open(path, &r) == CARDID_OK, "Result file should open");
+    TEST_ASSERT(cardid_results_count(r) == ROWS, "One row per data record");
+    cardid_results_row row;
+    for (uint64_t i = 0; i < ROWS; i++) {
+        TEST_ASSERT(cardid_results_get(r, i, &row), "Row should exist");
+        TEST_ASSERT(row.record == i && row.offset == offsets[i], "Row should carry the input offset");
+        TEST_ASSERT(row.result.network == expect[i].network &&
+                        row.result.luhn_valid == expect[i].luhn_valid &&
+                        row.result.length == expect[i].length,
+                    "Row should round-trip cardid_result");
+    }
+    TEST_ASSERT(!cardid_results_get(r, ROWS, &row), "Out-of-range row");
+
+    // Every filter must return exactly what a full scan would, in the documented order.
+    const cardid_results_filter filters[] = {
+        {true, CARD_AMEX, false, 0, 0, false},
+        {true, CARD_UNKNOWN, false, 0, 0, false},
+        {false, CARD_UNKNOWN, false, 0, 0, true},
+        {false, CARD_UNKNOWN, true, 411111, 411111, false},
+        {false, CARD_UNKNOWN, true, 370000, 559999, false},
+        {true, CARD_MASTERCARD, true, 0, 999999, true},
+        {false, CARD_UNKNOWN, true, 600000, 699999, false},
+    };
+    for (size_t f = 0; f < sizeof(filters) / sizeof(filters[0]); f++) {
+        const cardid_results_filter* flt = &filters[f];
+        uint64_t got = 0, want = 0;
+        cardid_results_iter it;
+        cardid_results_iter_init(&it, r, flt);
+        uint32_t last_bin = 0;
+        uint64_t last = 0;
+        while (cardid_results_next(&it, &row)) {
+            uint64_t i = row.record;
+            TEST_ASSERT(row.offset == offsets[i], "Iterated row should be complete");
+            TEST_ASSERT(!flt->by_network || row.result.network == flt->network, "Network filter");
+            TEST_ASSERT(!flt->valid_only || row.result.luhn_valid, "Validity filter");
+            if (flt->by_bin) {
+                uint32_t bin = pan_bin(results_pan((int)i));
+                TEST_ASSERT(bin >= flt->bin_lo && bin <= flt->bin_hi, "BIN filter");
+                TEST_ASSERT(got == 0 || bin > last_bin || (bin == last_bin && i > last),
+                            "BIN order, then record order");
+                last_bin = bin;
+            } else {
+                TEST_ASSERT(got == 0 || i > last, "Record order");
+            }
+            last = i;
+            ++got;
+        }
+        for (int i = 0; i < ROWS; i++) {
+            bool valid = expect[i].luhn_valid && expect[i].network != CARD_UNKNOWN;
+            if (flt->by_network && expect[i].network != flt->network) continue;
+            if (flt->valid_only && !expect[i].luhn_valid) continue;
+            if (flt->by_bin) {
+                if (!valid) continue;
+                uint32_t bin = pan_bin(results_pan(i));
+                if (bin < flt->bin_lo || bin > flt->bin_hi) continue;
+            }
+            ++want;
+        }
+        TEST_ASSERT(got == want, "Filtered iteration should match a full scan");
+    }
+    TEST_ASSERT(cardid_results_network_count(r, CARD_AMEX) == 100, "Network record count");
+    TEST_ASSERT(cardid_results_network_count(r, CARD_DISCOVER) == 0, "Absent network");
+    cardid_results_close(r);
+
+    FILE* f = fopen(path, "r+b");
+    TEST_ASSERT(f != NULL, "Reopen for corruption");
+    // A file written on a host of the other byte order (byte_order follows the
+    // 8-byte magic and the 4-byte version)
+    unsigned char order[4], swapped[4];
+    fseek(f, 12, SEEK_SET);
+    TEST_ASSERT(fread(order, 1, 4, f) == 4, "Read byte order");
+    for (int i = 0; i < 4; i++) swapped[i] = order[3 - i];
+    fseek(f, 12, SEEK_SET);
+    fwrite(swapped, 1, 4, f);
+    fflush(f);
+    TEST_ASSERT(cardid_results_open(path, &r) == CARDID_ERR_FORMAT && r == NULL,
+                "Other byte order should be rejected");
+    fseek(f, 12, SEEK_SET);
+    fwrite(order, 1, 4, f);
+    fflush(f);
+    TEST_ASSERT(cardid_results_open(path, &r) == CARDID_OK, "Restored file should open");
+    cardid_results_close(r);
+    fseek(f, 0, SEEK_END);
+    long size = ftell(f);
+    TEST_ASSERT(ftruncate(fileno(f), size - 1) == 0, "Truncate");
+    fclose(f);
+    TEST_ASSERT(cardid_results_open(path, &r) == CARDID_ERR_FORMAT && r == NULL,
+                "Truncated file should be rejected");
+    TEST_ASSERT(cardid_results_open(dir, &r) != CARDID_OK, "Directory should be rejected");
+    remove(path);
+
+    // An unwritable path fails at open, before any input is read.
+    char bad[96];
+    snprintf(bad, sizeof(bad), "%s/missing/out.cidr", dir);
+    cardid_results_writer* w = NULL;
+    errno = 0;
+    TEST_ASSERT(cardid_results_writer_open(bad, &w) == CARDID_ERR_IO && w == NULL && errno == ENOENT,
+                "Bad path should fail at open with errno set");
+    TEST_ASSERT(cardid_results_writer_open(path, &w) == CARDID_OK, "Writer should open");
+    TEST_ASSERT(access(path, F_OK) != 0, "Only path.tmp exists before close");
+    cardid_results_writer_add(w, 0, &expect[0], results_pan(0));
+    cardid_results_writer_discard(w);
+
+    // Several spill blocks, 8-byte offsets, and postings built a few at a time:
+    // BINs larger than the chunk stream out, small neighbouring ones share a pass.
+    enum { BIG = 10000 };
+    static const char* big_pans[] = {"4111111111111111", "378282246310005", "4111111111111112",
+                                     "5555555555554444", "5105105105105100", "5200828282828210"};
+    cardid_results_posting_chunk = 64;
+    TEST_ASSERT(cardid_results_writer_open(path, &w) == CARDID_OK, "Writer should open");
+    uint64_t big_valid = 0;
+    for (int i = 0; i < BIG; i++) {
+        const char* pan = big_pans[i % 97 == 0 ? 4 : i % 89 == 0 ? 5 : i % 4];
+        cardid_result res;
+        cardid_analyze(pan, &res, NULL);
+        bool valid = res.luhn_valid && res.network != CARD_UNKNOWN;
+        big_valid += valid;
+        TEST_ASSERT(cardid_results_writer_add(w, (uint64_t)i << 33, &res, valid ? pan : NULL) ==
+                        CARDID_OK,
+                    "Row should be added");
+    }
+    TEST_ASSERT(cardid_results_writer_close(w) == CARDID_OK, "Writer should close");
+    cardid_results_posting_chunk = (size_t)1 << 22;
+    TEST_ASSERT(cardid_results_open(path, &r) == CARDID_OK, "Large result file should open");
+    TEST_ASSERT(cardid_results_count(r) == BIG, "Large row count");
+    TEST_ASSERT(cardid_results_get(r, BIG - 1, &row) && row.offset == (uint64_t)(BIG - 1) << 33,
+                "Offsets above 32 bits should round-trip");
+    const cardid_results_filter all_bins = {false, CARD_UNKNOWN, true, 0, 999999, false};
+    cardid_results_iter it;
+    cardid_results_iter_init(&it, r, &all_bins);
+    uint64_t got = 0, last = 0;
+    uint32_t last_bin = 0;
+    while (cardid_results_next(&it, &row)) {
+        int i = (int)row.record;
+        uint32_t bin = pan_bin(big_pans[i % 97 == 0 ? 4 : i % 89 == 0 ? 5 : i % 4]);
+        TEST_ASSERT(row.offset == (uint64_t)i << 33, "Posting should name its record");
+        TEST_ASSERT(got == 0 || bin > last_bin || (bin == last_bin && row.record > last),
+                    "Postings in BIN order, then record order");
+        last_bin = bin;
+        last = row.record;
+        ++got;
+    }
+    TEST_ASSERT(got == big_valid, "Every validated record has a posting");
+    cardid_results_close(r);
+
+    remove(path);
+    TEST_ASSERT(rmdir(dir) == 0, "No spill or temp files should be left behind");
+    TEST_PASS("Result file tests");
+    return 0;
+}
+
+// Order-sensitive fingerprint of a match sequence, for scans too big for match_list.
+typedef struct {
+    unsigned long long n;
+    uint64_t h;
+} match_digest;
+
+static void digest_match(const cardid_scan_match* m, void* ctx) {
+    match_digest* d = (match_digest*)ctx;
+    uint64_t v[4] = {m->offset, m->span, (uint64_t)m->length, (uint64_t)m->network};
+    for (int i = 0; i < 4; i++) d->h = (d->h ^ v[i]) * 1099511628211ull;
+    d->n++;
+}
+
+// Generated PAN lines with a long stretch of digit groups and single spaces in
+// the middle: no byte there lets a parallel worker start cleanly.
+static char* archive_corpus(size_t* len) {
+    size_t cap = 640 * 1024;
+    char* text = malloc(cap);
+    if (!text) return NULL;
+    cardid_gen_config cfg;
+    memset(&cfg, 0, sizeof(cfg));
+    cfg.seed = 37;
+    cfg.separator_rate = 0.5;
+    cfg.invalid_rate = 0.1;
+    cardid_gen gen;
+    cardid_gen_init(&gen, &cfg);
+    size_t records;
+    *len = cardid_gen_fill(&gen, CARDID_GEN_LINES, text, cap, cap, &records);
+    unsigned x = 37;
+    for (size_t i = 250000; i < 320000; i++) {
+        x = x * 1103515245u + 12345u;
+        text[i] = i % 5 == 4 ? ' ' : (char)('0' + (x >> 16) % 10);
+    }
+    memcpy(text + 320000 - 19, "4111 1111 1111 1111", 19);
+    return text;
+}
+
+// Scans data with cardid_archive_scan and checks it reports exactly want.
+static int archive_matches(const void* data, size_t len, int threads, const match_digest* want,
+                           size_t want_bytes, cardid_archive_stats* stats) {
+    match_digest got = {0, 0};
+    cardid_status st = cardid_archive_scan(data, len, threads, digest_match, &got, stats);
+    return st == CARDID_OK && got.n == want->n && got.h == want->h && stats->bytes == want_bytes &&
+           stats->matches == want->n;
+}
+
+#ifdef CARDID_HAVE_ZLIB
+// bgzip layout: gzip members of varying small sizes, each with a 'BC' extra
+// subfield holding its size, and the empty end-of-file member.
+static size_t bgzf_compress(const char* text, size_t len, unsigned char* out) {
+    size_t n = 0;
+    for (size_t off = 0, i = 0; off <= len; ++i) {
+        size_t part = 200 + (i * 7919) % 3000;
+        if (part > len - off) part = len - off;
+        z_stream z;
+        memset(&z, 0, sizeof(z));
+        deflateInit2(&z, 6, Z_DEFLATED, -15, 8, Z_DEFAULT_STRATEGY);
+        z.next_in = (unsigned char*)text + off;
+        z.avail_in = (uInt)part;
+        z.next_out = out + n + 18;
+        z.avail_out = (uInt)deflateBound(&z, (uLong)part);
+        deflate(&z, Z_FINISH);
+        size_t body = z.total_out, bsize = 18 + body + 8;
+        deflateEnd(&z);
+        static const unsigned char head[16] = {31, 139, 8, 4, 0, 0, 0,   0,
+                                               0,  255, 6, 0, 'B', 'C', 2, 0};
+        memcpy(out + n, head, 16);
+        out[n + 16] = (unsigned char)((bsize - 1) & 0xff);
+        out[n + 17] = (unsigned char)((bsize - 1) >> 8);
+        uLong crc = crc32(0L, (const unsigned char*)text + off, (uInt)part);
+        unsigned char* t = out + n + 18 + body;
+        for (int b = 0; b < 4; b++) t[b] = (unsigned char)(crc >> (8 * b));
+        for (int b = 0; b < 4; b++) t[4 + b] = (unsigned char)(part >> (8 * b));
+        n += bsize;
+        off += part;
+        if (part == 0) break;  // the empty member doubles as the EOF marker
+    }
+    return n;
+}
+
+// One bgzip member holding reps copies of unit: deflate tops out near 1000:1,
+// so 24 MiB of repetitive text still fits the 64 KiB member limit.
+static size_t bgzf_member_repeat(const char* unit, size_t reps, unsigned char* out) {
+    size_t ulen = strlen(unit);
+    z_stream z;
+    memset(&z, 0, sizeof(z));
+    deflateInit2(&z, 9, Z_DEFLATED, -15, 9, Z_DEFAULT_STRATEGY);
+    z.next_out = out + 18;
+    z.avail_out = 65536 - 26;
+    uLong crc = crc32(0L, Z_NULL, 0);
+    for (size_t r = 0; r < reps; r++) {
+        z.next_in = (unsigned char*)unit;
+        z.avail_in = (uInt)ulen;
+        deflate(&z, r + 1 == reps ? Z_FINISH : Z_NO_FLUSH);
+        crc = crc32(crc, (const unsigned char*)unit, (uInt)ulen);
+    }
+    size_t body = z.total_out, bsize = 18 + body + 8, total = ulen * reps;
+    deflateEnd(&z);
+    static const unsigned char head[16] = {31, 139, 8, 4, 0, 0, 0,   0,
+                                           0,  255, 6, 0, 'B', 'C', 2, 0};
+    memcpy(out, head, 16);
+    out[16] = (unsigned char)((bsize - 1) & 0xff);
+    out[17] = (unsigned char)((bsize - 1) >> 8);
+    unsigned char* t = out + 18 + body;
+    for (int b = 0; b < 4; b++) t[b] = (unsigned char)(crc >> (8 * b));
+    for (int b = 0; b < 4; b++) t[4 + b] = (unsigned char)(total >> (8 * b));
+    return bsize;
+}
+
+static size_t gzip_compress(const char* text, size_t len, unsigned char* out, size_t cap) {
+    z_stream z;
+    memset(&z, 0, sizeof(z));
+    deflateInit2(&z, 6, Z_DEFLATED, 16 + 15, 8, Z_DEFAULT_STRATEGY);
+    z.next_in = (unsigned char*)text;
+    z.avail_in = (uInt)len;
+    z.next_out = out;
+    z.avail_out = (uInt)cap;
+    int rc = deflate(&z, Z_FINISH);
+    size_t n = z.total_out;
+    deflateEnd(&z);
+    return rc == Z_STREAM_END ? n : 0;
+}
+#endif
+
+#ifdef CARDID_HAVE_ZSTD
+// pzstd-style multi-frame file; frames of varying size.
+static size_t zstd_compress_frames(const char* text, size_t len, unsigned char* out, size_t cap) {
+    size_t n = 0;
+    for (size_t off = 0, i = 0; off < len; ++i) {
+        size_t part = 1000 + (i * 7919) % 20000;
+        if (part > len - off) part = len - off;
+        size_t c = ZSTD_compress(out + n, cap - n, text + off, part, 3);
+        if (ZSTD_isError(c)) return 0;
+        n += c;
+        off += part;
+    }
+    return n;
+}
+#endif
+
+static int test_archive() {
+    printf("\n=== Testing Compressed Archives ===\n");
+
+    static const unsigned char gz_magic[] = {0x1f, 0x8b, 8, 0};
+    static const unsigned char zstd_magic[] = {0x28, 0xb5, 0x2f, 0xfd};
+    TEST_ASSERT(cardid_archive_detect(gz_magic, 4) == CARDID_ARCHIVE_GZIP, "gzip magic");
+    TEST_ASSERT(cardid_archive_detect(zstd_magic, 4) == CARDID_ARCHIVE_ZSTD, "zstd magic");
+    TEST_ASSERT(cardid_archive_detect(zstd_magic, 3) == CARDID_ARCHIVE_PLAIN, "Short header");
+    TEST_ASSERT(cardid_archive_detect("4111", 4) == CARDID_ARCHIVE_PLAIN, "Plain text");
+    TEST_ASSERT(cardid_archive_supported(CARDID_ARCHIVE_PLAIN), "Plain is always supported");
+
+    size_t len;
+    char* text = archive_corpus(&len);
+    TEST_ASSERT(text != NULL, "Corpus");
+    match_digest want = {0, 0};
+    cardid_scanner s;
+    cardid_scanner_init(&s, 0);
+    cardid_scanner_feed(&s, text, len, digest_match, &want);
+    cardid_scanner_finish(&s, digest_match, &want);
+    TEST_ASSERT(want.n > 10000, "Corpus should hold many PANs");
+
+    // Plain input: parallel slices must stitch back to the sequential result
+    cardid_archive_stats stats;
+    const int threads[] = {1, 2, 3, 8};
+    for (size_t t = 0; t < sizeof(threads) / sizeof(threads[0]); t++) {
+        TEST_ASSERT(archive_matches(text, len, threads[t], &want, len, &stats),
+                    "Plain scan should match the scanner");
+        TEST_ASSERT(stats.format == CARDID_ARCHIVE_PLAIN, "Plain format");
+    }
+
+    size_t cap = 2 * len + 65536;
+    unsigned char* packed = malloc(cap);
+    TEST_ASSERT(packed != NULL, "Buffer");
+    match_digest none = {0, 0};
+#ifdef CARDID_HAVE_ZLIB
+    size_t n = bgzf_compress(text, len, packed);
+    for (size_t t = 0; t < sizeof(threads) / sizeof(threads[0]); t++) {
+        TEST_ASSERT(archive_matches(packed, n, threads[t], &want, len, &stats),
+                    "bgzip scan should match the scanner on the decompressed text");
+        TEST_ASSERT(stats.format == CARDID_ARCHIVE_GZIP && stats.input_bytes == n, "bgzip stats");
+        TEST_ASSERT(threads[t] == 1 || (stats.threads > 1 && stats.blocks > 100),
+                    "bgzip blocks should be decoded in parallel");
+    }
+    TEST_ASSERT(cardid_archive_scan(packed, n - 40, 4, digest_match, &none, &stats) ==
+                    CARDID_ERR_FORMAT,
+                "Truncated bgzip should be rejected");
+    TEST_ASSERT(cardid_archive_scan(packed, n - 40, 1, digest_match, &none, &stats) ==
+                    CARDID_ERR_FORMAT,
+                "Truncated bgzip should be rejected sequentially too");
+
+    // Streamed: same matches from a FILE*
+    FILE* f = tmpfile();
+    TEST_ASSERT(f != NULL && fwrite(packed, 1, n, f) == n, "Temp file");
+    rewind(f);
+    match_digest streamed = {0, 0};
+    TEST_ASSERT(cardid_archive_scan_stream(f, digest_match, &streamed, &stats) == CARDID_OK,
+                "Stream scan should succeed");
+    TEST_ASSERT(streamed.n == want.n && streamed.h == want.h && stats.bytes == len,
+                "Stream scan should match the scanner");
+    fclose(f);
+
+    // Single-member gzip has no block structure: decoded sequentially
+    n = gzip_compress(text, len, packed, cap);
+    TEST_ASSERT(n > 0, "gzip");
+    TEST_ASSERT(archive_matches(packed, n, 4, &want, len, &stats) && stats.threads == 1,
+                "Plain gzip scan should match the scanner");
+    packed[n++] = 'x';
+    TEST_ASSERT(cardid_archive_scan(packed, n, 4, digest_match, &none, &stats) ==
+                    CARDID_ERR_FORMAT,
+                "Trailing garbage should be rejected");
+#endif
+#ifdef CARDID_HAVE_ZSTD
+    size_t zn = zstd_compress_frames(text, len, packed, cap);
+    TEST_ASSERT(zn > 0, "zstd");
+    for (size_t t = 0; t < sizeof(threads) / sizeof(threads[0]); t++) {
+        TEST_ASSERT(archive_matches(packed, zn, threads[t], &want, len, &stats),
+                    "zstd scan should match the scanner on the decompressed text");
+        TEST_ASSERT(stats.format == CARDID_ARCHIVE_ZSTD, "zstd format");
+    }
+    TEST_ASSERT(cardid_archive_scan(packed, zn - 3, 4, digest_match, &none, &stats) ==
+                    CARDID_ERR_FORMAT,
+                "Truncated zstd should be rejected");
+#else
+    TEST_ASSERT(cardid_archive_scan(zstd_magic, 4, 1, digest_match, &none, &stats) ==
+                    CARDID_ERR_ARG,
+                "zstd input without libzstd");
+#endif
+
+#ifdef CARDID_HAVE_ZLIB
+    // High-ratio blocks: memory stays bounded by chunks, not by what a block
+    // inflates to. Long lines stream through a worker; a 24 MiB stretch with no
+    // sync byte and a dense run of PANs exceed the seam and match caps and are
+    // decoded on the calling thread instead.
+    static const char* units[] = {"start 4111111111111111\n", "xxxxxxxxxxxxxxxxxxxxxxxxxxxxxxx\n",
+                                  "1234 ", "4111111111111111\n", "end 5555555555554444\n"};
+    static const size_t reps[] = {1, 24u << 15, (24u << 20) / 5, (24u << 20) / 17, 1};
+    n = 0;
+    unsigned long long inflated = 0;
+    for (int u = 0; u < 5; u++) {
+        n += bgzf_member_repeat(units[u], reps[u], packed + n);
+        inflated += strlen(units[u]) * reps[u];
+    }
+    TEST_ASSERT(n < 256 * 1024 && inflated > (64u << 20), "High-ratio archive");
+    struct rusage ru;
+    getrusage(RUSAGE_SELF, &ru);
+    long rss_before = ru.ru_maxrss;
+    match_digest seq = {0, 0}, par = {0, 0};
+    TEST_ASSERT(cardid_archive_scan(packed, n, 1, digest_match, &seq, &stats) == CARDID_OK &&
+                    stats.bytes == inflated,
+                "High-ratio archive sequentially");
+    TEST_ASSERT(seq.n > (1u << 20), "Dense PAN block should be scanned");
+    TEST_ASSERT(cardid_archive_scan(packed, n, 4, digest_match, &par, &stats) == CARDID_OK &&
+                    stats.threads > 1 && stats.bytes == inflated,
+                "High-ratio archive in parallel");
+    TEST_ASSERT(par.n == seq.n && par.h == seq.h, "Parallel should match sequential");
+    getrusage(RUSAGE_SELF, &ru);
+    TEST_ASSERT(ru.ru_maxrss - rss_before < 16 * 1024,  // KiB
+                "Peak memory should not grow with the inflated block size");
+#endif
+
+#ifdef CARDID_HAVE_ZLIB
+    // The crawler scans compressed files decompressed
+    char root[] = "/tmp/cardid_archive_XXXXXX";
+    TEST_ASSERT(mkdtemp(root) != NULL, "Temp dir");
+    char gz[96];
+    snprintf(gz, sizeof(gz), "%s/app.log.1.gz", root);
+    n = bgzf_compress("paid 4111 1111 1111 1111\n", 25, packed);
+    f = fopen(gz, "wb");
+    TEST_ASSERT(f != NULL && fwrite(packed, 1, n, f) == n && fclose(f) == 0, "Write archive");
+    cardid_crawl_config cfg;
+    memset(&cfg, 0, sizeof(cfg));
+    cfg.threads = 2;
+    char report[512];
+    cardid_crawl_stats cs;
+    TEST_ASSERT(crawl_dir(root, &cfg, report, sizeof(report), &cs), "Crawl should succeed");
+    TEST_ASSERT(cs.files_decompressed == 1 && cs.matches == 1 && cs.bytes_scanned == 25,
+                "Archive should be scanned decompressed");
+    TEST_ASSERT(strstr(report, "app.log.1.gz\t1\t5:VISA:16\n") != NULL,
+                "Offsets are in the decompressed data");
+    f = fopen(gz, "wb");
+    TEST_ASSERT(f != NULL && fwrite(packed, 1, n - 30, f) == n - 30 && fclose(f) == 0,
+                "Truncate archive");
+    TEST_ASSERT(crawl_dir(root, &cfg, report, sizeof(report), &cs), "Crawl should still succeed");
+    TEST_ASSERT(cs.files_failed == 1 && strstr(report, "\terror\tcorrupt") != NULL,
+                "Corrupt archive should be reported");
+
+    // Archives of 1 MiB or more are read into memory and decoded on threads
+    // borrowed from idle workers; with one worker they stream instead
+    n = bgzf_compress(text, len, packed);
+    f = fopen(gz, "wb");
+    int copies = 0;
+    for (; f && (size_t)copies * n < (2u << 20); copies++) fwrite(packed, 1, n, f);
+    TEST_ASSERT(f != NULL && fclose(f) == 0, "Write big archive");
+    char big[512];
+    cfg.threads = 1;
+    TEST_ASSERT(crawl_dir(root, &cfg, big, sizeof(big), &cs), "Streamed crawl");
+    unsigned long long one_thread = cs.matches;
+    TEST_ASSERT(cs.files_decompressed == 1 &&
+                    cs.bytes_scanned == (unsigned long long)copies * len &&
+                    one_thread >= (unsigned long long)copies * want.n,
+                "Big archive should stream whole");
+    cfg.threads = 4;
+    TEST_ASSERT(crawl_dir(root, &cfg, report, sizeof(report), &cs), "Parallel crawl");
+    TEST_ASSERT(cs.files_decompressed == 1 && cs.matches == one_thread && strcmp(report, big) == 0,
+                "Borrowed threads should find the same PANs");
+    remove(gz);
+    rmdir(root);
+#endif
+
+    free(packed);
+    free(text);
+    TEST_PASS("Compressed archive tests");
+    return 0;
+}
+#endif
+
 int main() {
     printf("Starting CardID Test Suite\n");
     printf("==========================\n");
@@ -223,6 +1462,21 @@ int main() {
     failures += test_network_detection();
     failures += test_full_analysis();
     failures += test_edge_cases();
+    failures += test_length_delimited();
+    failures += test_record_ingestion();
+    failures += test_metrics();
+    failures += test_tokenization();
+    failures += test_generator();
+    failures += test_bin_enumerator();
+    failures += test_scratch_arena();
+    failures += test_scanner();
+    failures += test_velocity();
+#ifndef _WIN32
+    failures += test_crawl();
+    failures += test_follow();
+    failures += test_results_file();
+    failures += test_archive();
+#endif
     
     printf("\n==========================\n");
     if (failures == 0) {
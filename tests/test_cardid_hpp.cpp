@@ -0,0 +1,200 @@
+// C++ interface tests: compile-time validation, and bit-for-bit agreement of
+// cardid.hpp with the C library across generated, random and exhaustive inputs.
+
+#include <array>
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include <string_view>
+#include <vector>
+#include "../include/cardid.h"
+#include "../include/cardid.hpp"
+#include "../include/cardid_gen.h"
+
+#define TEST_ASSERT(condition, message) \
+    do { \
+        if (!(condition)) { \
+            printf("FAIL: %s:%d - %s\n", __FILE__, __LINE__, message); \
+            return 1; \
+        } \
+    } while(0)
+
+#define TEST_PASS(message) \
+    printf("PASS: %s\n", message)
+
+// Evaluated by the compiler: a broken constexpr path fails the build.
+static_assert(cardid::valid("4111 1111 1111 1111"), "Visa with spaces");
+static_assert(cardid::valid("3782-822463-10005"), "Amex with dashes");
+static_assert(!cardid::valid("4111111111111112"), "Luhn failure");
+static_assert(cardid::analyze("6011111111111117").network == CARD_DISCOVER, "Discover");
+static_assert(cardid::analyze("5555555555554444").length == 16, "Length");
+static_assert(cardid::luhn<16>("4111111111111111") && !cardid::luhn<16>("4111111111111112"),
+              "Length-specialized Luhn");
+static_assert(cardid::detect_network<15>("378282246310005") == CARD_AMEX, "Specialized detect");
+static_assert(cardid::network_name(CARD_MASTERCARD) == "MASTERCARD", "Network name");
+
+static bool same(const cardid_result& a, const cardid_result& b) {
+    return a.network == b.network && a.luhn_valid == b.luhn_valid && a.length == b.length;
+}
+
+// Compares every output of cardid::analyze with cardid_analyze_n on one input.
+static bool agrees(std::string_view s) {
+    cardid_result c, cpp;
+    cardid_extract_result cm, cppm;
+    std::memset(&c, 0xa5, sizeof(c));
+    std::memset(&cpp, 0x5a, sizeof(cpp));
+    cardid_analyze_n(s.data(), s.size(), &c, &cm);
+    cardid::analyze(s, cpp, &cppm);
+    return same(c, cpp) && cm.digit_count == cppm.digit_count &&
+           cm.found_non_digit == cppm.found_non_digit && cm.overflowed == cppm.overflowed;
+}
+
+static int test_constexpr_and_fixed() {
+    printf("\n=== Testing C++ Fixed Cases ===\n");
+    const char* cases[] = {"4111111111111111", "4111-1111-1111-1111", "5555 5555 5555 4444",
+                           "378282246310005", "6011111111111117", "6221260000000000",
+                           "4111111111111112", "", "   ", "abc", "4111x1111y1111z1111",
+                           "1234567890123", "12345678901234", "41111111111111111111",
+                           "4111111111111111111 ", "4111111111111111111a", "\t4111111111111111\n",
+                           "4222222222222", "0000000000000000"};
+    for (const char* s : cases) {
+        TEST_ASSERT(agrees(s), s);
+    }
+    std::string owned = "pan=4111111111111111;";
+    TEST_ASSERT(agrees(std::string_view(owned).substr(4, 16)), "Slice of a std::string");
+    TEST_PASS("C++ fixed cases");
+    return 0;
+}
+
+static int test_random_bytes() {
+    printf("\n=== Testing C++ Random Inputs ===\n");
+    // Digits dominate so most strings land near real PAN lengths; the rest covers
+    // separators, whitespace, letters and high bytes (isspace/isdigit must not
+    // accept them in the "C" locale).
+    static const char alphabet[] = "01234567890123456789 -\t\n\v\f\rax/\x80\xa0\xff";
+    unsigned x = 2024;
+    char buf[48];
+    for (int n = 0; n < 200000; ++n) {
+        x = x * 1103515245u + 12345u;
+        std::size_t len = (x >> 16) % sizeof(buf);
+        for (std::size_t i = 0; i < len; ++i) {
+            x = x * 1103515245u + 12345u;
+            buf[i] = alphabet[(x >> 16) % (sizeof(alphabet) - 1)];
+        }
+        TEST_ASSERT(agrees(std::string_view(buf, len)), "Random input should match C");
+    }
+    TEST_PASS("C++ random inputs");
+    return 0;
+}
+
+static int test_generated_corpus() {
+    printf("\n=== Testing C++ Generated Corpus ===\n");
+    cardid_gen_config cfg;
+    std::memset(&cfg, 0, sizeof(cfg));
+    cfg.seed = 36;
+    cfg.invalid_rate = 0.2;
+    cfg.separator_rate = 0.5;
+    cfg.garbage_rate = 0.05;
+    cardid_gen gen;
+    TEST_ASSERT(cardid_gen_init(&gen, &cfg) == CARDID_OK, "Generator config");
+    char text[CARDID_GEN_MAX_TEXT + 1];
+    int valid = 0;
+    for (int n = 0; n < 100000; ++n) {
+        int len = cardid_gen_next(&gen, text);
+        TEST_ASSERT(agrees(std::string_view(text, (std::size_t)len)), "Generated PAN should match C");
+        valid += cardid::valid(std::string_view(text, (std::size_t)len));
+    }
+    TEST_ASSERT(valid > 50000, "Most generated PANs should be valid");
+    TEST_PASS("C++ generated corpus");
+    return 0;
+}
+
+template <int Len>
+static int check_length() {
+    char d[Len + 1];
+    for (int p = 0; p < 1000000; p += (Len == 16 ? 1 : 7)) {
+        std::snprintf(d, sizeof(d), "%06d%0*d", p, Len - 6, p % 997);
+        cardid_result c, cpp;
+        cardid_analyze_n(d, Len, &c, NULL);
+        cardid::analyze_digits<Len>(d, cpp);
+        TEST_ASSERT(same(c, cpp), "Length-specialized analysis should match C");
+        TEST_ASSERT(cardid_detect_network(d, Len) == cardid::detect_network<Len>(d) &&
+                        cardid::detect_network<Len>(d) ==
+                            cardid::detect_network(std::string_view(d, Len)),
+                    "Network detection should match C for every prefix");
+        TEST_ASSERT(cardid_luhn_digits(d, Len) == cardid::luhn<Len>(d), "Luhn should match C");
+    }
+    d[3] = '-';
+    cardid_result c, cpp;
+    cardid_analyze_n(d, Len, &c, NULL);
+    cardid::analyze_digits<Len>(d, cpp);
+    TEST_ASSERT(same(c, cpp), "Non-digit fields take the general path");
+    return 0;
+}
+
+static int test_length_specialized() {
+    printf("\n=== Testing C++ Length Templates ===\n");
+    int failures = check_length<13>() + check_length<14>() + check_length<15>() +
+                   check_length<16>() + check_length<19>();
+    TEST_ASSERT(failures == 0, "Every specialized length should match C");
+    std::array<char, 16> field = {'4', '1', '1', '1', '1', '1', '1', '1',
+                                  '1', '1', '1', '1', '1', '1', '1', '1'};
+    cardid_result r;
+    TEST_ASSERT(cardid::analyze_digits(field, r) == CARDID_OUTCOME_VALID && r.network == CARD_VISA,
+                "std::array overload");
+    char longer[21] = "41111111111111111111";
+    cardid_result c;
+    cardid_analyze_n(longer, 20, &c, NULL);
+    TEST_ASSERT(cardid::analyze_digits<20>(longer, r) == CARDID_OUTCOME_OVERFLOW && same(c, r),
+                "Overlong fields overflow as in C");
+    TEST_PASS("C++ length templates");
+    return 0;
+}
+
+static int test_batch() {
+    printf("\n=== Testing C++ Batch Overloads ===\n");
+    std::vector<std::string> owned = {"4111111111111111", "nope", "378282246310005",
+                                      "4111111111111112"};
+    std::vector<std::string_view> views(owned.begin(), owned.end());
+    cardid_result out[3];
+    cardid_outcome outcomes[4];
+    TEST_ASSERT(cardid::analyze_batch(views, out) == 3, "Batch should stop at the shorter span");
+    TEST_ASSERT(out[0].network == CARD_VISA && !out[1].luhn_valid && out[2].network == CARD_AMEX,
+                "Batch results");
+    std::vector<cardid_result> more(4);
+    TEST_ASSERT(cardid::analyze_batch(views, more, outcomes) == 4, "Batch with outcomes");
+    TEST_ASSERT(outcomes[0] == CARDID_OUTCOME_VALID && outcomes[1] == CARDID_OUTCOME_EMPTY &&
+                    outcomes[3] == CARDID_OUTCOME_LUHN_FAIL,
+                "Batch outcomes");
+
+    const char packed[] = "4111111111111111" "5555555555554444" "6011111111111117" "4111";
+    cardid_result fixed[8];
+    TEST_ASSERT(cardid::analyze_batch_digits<16>(
+                    cardid::span<const char>(packed, sizeof(packed) - 1), fixed) == 3,
+                "Fixed-width batch ignores the partial record");
+    TEST_ASSERT(fixed[1].network == CARD_MASTERCARD && fixed[2].network == CARD_DISCOVER,
+                "Fixed-width batch results");
+    TEST_PASS("C++ batch overloads");
+    return 0;
+}
+
+int main() {
+    printf("Starting CardID C++ Test Suite\n");
+    printf("==============================\n");
+
+    int failures = 0;
+    failures += test_constexpr_and_fixed();
+    failures += test_random_bytes();
+    failures += test_generated_corpus();
+    failures += test_length_specialized();
+    failures += test_batch();
+
+    printf("\n==============================\n");
+    if (failures == 0) {
+        printf("All tests PASSED! ✅\n");
+        return 0;
+    } else {
+        printf("Tests FAILED: %d failures ❌\n", failures);
+        return 1;
+    }
+}